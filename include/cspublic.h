@@ -270,8 +270,14 @@ enum
 #define CS_DATABASE CS_DATABASE
 	CS_NOTE_EMPTY_DATA = 9303,
 #define CS_NOTE_EMPTY_DATA CS_NOTE_EMPTY_DATA
-	CS_PRODUCT_NAME = 9304
+	CS_PRODUCT_NAME = 9304,
 #define CS_PRODUCT_NAME CS_PRODUCT_NAME
+	CS_STMT_CACHE_SIZE = 9305,
+#define CS_STMT_CACHE_SIZE CS_STMT_CACHE_SIZE
+	CS_STMT_CACHE_HITS = 9306,
+#define CS_STMT_CACHE_HITS CS_STMT_CACHE_HITS
+	CS_STMT_CACHE_MISSES = 9307
+#define CS_STMT_CACHE_MISSES CS_STMT_CACHE_MISSES
 };
 
 /* Arbitrary precision math operators */
@@ -184,6 +184,30 @@ CT_COLINFO;
 
 typedef struct _cs_dynamic CS_DYNAMIC;
 
+/**
+ * Entry of the prepared statement cache, keyed by statement text and
+ * current database.
+ * Holds a reference to the libTDS dynamic so it survives CS_DEALLOC.
+ */
+typedef struct _cs_stmt_cache_entry
+{
+	struct _cs_stmt_cache_entry *next;
+	char *stmt;
+	/** database in use when statement was prepared */
+	char *database;
+	TDSDYNAMIC *tdsdyn;
+} CS_STMT_CACHE_ENTRY;
+
+/** LRU cache of prepared statements, most recently used first */
+typedef struct _cs_stmt_cache
+{
+	CS_STMT_CACHE_ENTRY *entries;
+	CS_INT size;
+	CS_INT count;
+	CS_INT hits;
+	CS_INT misses;
+} CS_STMT_CACHE;
+
 struct _cs_connection
 {
 	CS_CONTEXT *ctx;
@@ -197,6 +221,7 @@ struct _cs_connection
 	CS_LOCALE *locale;
 	CS_COMMAND *cmds;
 	CS_DYNAMIC *dynlist;
+	CS_STMT_CACHE stmt_cache;
 	char *server_addr;
 	bool network_auth;
 };
@@ -251,6 +276,8 @@ struct _cs_dynamic
 	char *stmt;
 	CS_DYNAMIC_PARAM *param_list;
 	TDSDYNAMIC *tdsdyn;
+	/** prepare failed on server, do not cache */
+	bool prepare_failed;
 }; 
 
 /* specific FreeTDS commands */
@@ -280,6 +307,18 @@ struct _cs_dynamic
 #define _CS_CANCEL_NOCANCEL     0
 #define _CS_CANCEL_PENDING      1
 
+/**
+ * Binding of a result set precomputed for array fetches.
+ * Columns with a non-zero direct_size are decoded by libTDS straight
+ * into the bound array, skipping the row buffer and cs_convert.
+ */
+typedef struct _cs_bind_plan
+{
+	TDSRESULTINFO *resinfo;
+	TDS_INT *direct_size;
+	unsigned char **saved_data;
+} CS_BIND_PLAN;
+
 struct _cs_command
 {
 	struct _cs_command *next;
@@ -295,6 +334,7 @@ struct _cs_command
 	int row_prefetched;
 	int curr_result_type;
 	int bind_count;
+	CS_BIND_PLAN *bind_plan;
 	int get_data_item;
 	int get_data_bytes_returned;
 	CS_IODESC *iodesc;
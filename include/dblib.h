@@ -68,6 +68,8 @@ typedef struct
 	int term_len;
 	int tab_colnum;
 	int column_error;
+	/** same type as table column, data are copied without conversion */
+	bool passthrough;
 } BCP_HOSTCOLINFO;
 
 typedef struct
@@ -81,6 +83,11 @@ typedef struct
 	TDS_INT lastrow;
 	TDS_INT maxerrs;
 	TDS_INT batch;
+	/** range of bytes of host file to copy in, see bcp_filerange() */
+	TDS_INT8 range_start, range_end;
+	/** journal of committed batches, see bcp_journal() */
+	TDS_CHAR *journalfile;
+	bool journal_resume;
 } BCP_HOSTFILEINFO;
 
 /* linked list of rpc parameters */
@@ -88,9 +88,17 @@ unsigned char tds_willconvert(int srctype, int desttype);
 TDS_SERVER_TYPE tds_get_null_type(TDS_SERVER_TYPE srctype);
 TDS_INT tds_char2hex(TDS_CHAR *dest, TDS_UINT destlen, const TDS_CHAR * src, TDS_UINT srclen);
 TDS_INT tds_convert(const TDSCONTEXT *context, int srctype, const void *src, TDS_UINT srclen, int desttype, CONV_RESULT *cr);
+TDS_INT tds_convert_batch(const TDSCONTEXT *context, int srctype, const void *const *src, const TDS_UINT *srclens,
+			  TDS_INT n, int desttype, CONV_RESULT *cr, TDS_INT *destlens, const unsigned char *nulls);
 
 size_t tds_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEREC * timeptr, int prec);
 
+typedef struct tds_datefmt TDSDATEFMT;
+TDSDATEFMT *tds_datefmt_compile(const char *format);
+size_t tds_datefmt_format(const TDSDATEFMT *fmt, char *buf, size_t maxsize, const TDSDATEREC * timeptr, int prec);
+void tds_datefmt_free(TDSDATEFMT *fmt);
+void tds_locale_compile_formats(TDSLOCALE *locale);
+
 #ifdef __cplusplus
 #if 0
 {
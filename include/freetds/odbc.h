@@ -283,6 +283,18 @@ struct _hcattr
 #define TDS_MAX_APP_DESC	100
 
 struct _hstmt;
+
+/** prepared statement kept by the connection to be reused by another statement */
+typedef struct _hstmt_cache_entry
+{
+	struct _hstmt_cache_entry *next;
+	/** query text, as sent to server */
+	DSTR query;
+	/** parameter types used to prepare, see odbc_stmt_cache_signature */
+	char *signature;
+	TDSDYNAMIC *dyn;
+} TDS_STMT_CACHE_ENTRY;
+
 struct _hdbc
 {
 	SQLSMALLINT htype;	/* do not reorder this field */
@@ -311,9 +323,20 @@ struct _hdbc
 	/** <>0 if server handle cursors */
 	unsigned int cursor_support:1;
 	unsigned int use_oldpwd:1;
+	/** send INSERT parameter arrays using bulk copy, see odbc_bcp_paramset */
+	unsigned int bulk_paramsets:1;
 	TDS_INT default_query_timeout;
 
 	TDSBCPINFO *bcpinfo;
+
+	/** prepared statements not used by any statement, most recently used first */
+	TDS_STMT_CACHE_ENTRY *stmt_cache;
+	unsigned int stmt_cache_count;
+	/** maximum number of entries in stmt_cache, 0 to disable */
+	unsigned int stmt_cache_size;
+	unsigned int stmt_cache_hits, stmt_cache_misses;
+	/** an error invalidated server handles, flush cache before next use */
+	unsigned int stmt_cache_flush:1;
 };
 
 struct _hsattr
@@ -389,6 +412,28 @@ typedef enum
 	ODBC_SPECIAL_SPECIALCOLUMNS = 4
 } TDS_ODBC_SPECIAL_ROWS;
 
+/** how a column is copied to application buffers, see odbc_tds2sql_plan */
+typedef enum
+{
+	ODBC_COPY_CONVERT = 0,	/**< generic conversion, odbc_tds2sql_col */
+	ODBC_COPY_FIXED,	/**< same binary representation, just copy */
+	ODBC_COPY_TIMESTAMP	/**< datetime or smalldatetime to TIMESTAMP_STRUCT */
+} TDS_ODBC_COPY_KIND;
+
+/** binding information computed once for each column during an array fetch */
+typedef struct _odbc_col_plan
+{
+	TDS_ODBC_COPY_KIND kind;
+	/** C type to convert to, never SQL_C_DEFAULT */
+	int c_type;
+	/** server type of the column, as returned by tds_get_conversion_type */
+	int srctype;
+	/** size of an element of the array for column-wise binding */
+	SQLLEN octet_len;
+	/** bytes to copy for ODBC_COPY_FIXED */
+	unsigned int size;
+} TDS_ODBC_COL_PLAN;
+
 struct _hstmt
 {
 	SQLSMALLINT htype;	/* do not reorder this field */
@@ -435,6 +480,8 @@ struct _hstmt
 	TDS_ODBC_ROW_STATUS row_status;
 	/* do NOT free dynamic, free from socket or attach to connection */
 	TDSDYNAMIC *dyn;
+	/** parameter signature dyn was prepared with, NULL if dyn cannot be cached */
+	char *dyn_signature;
 	TDS_DESC *ard, *ird, *apd, *ipd;
 	TDS_DESC *orig_ard, *orig_apd;
 	SQLULEN sql_rowset_size;
@@ -443,6 +490,9 @@ struct _hstmt
 	TDS_ODBC_SPECIAL_ROWS special_row;
 	/* do NOT free cursor, free from socket or attach to connection */
 	TDSCURSOR *cursor;
+	/** columns plan used by array fetch, allocated for fetch_plan_alloc columns */
+	TDS_ODBC_COL_PLAN *fetch_plan;
+	int fetch_plan_alloc;
 };
 
 typedef struct _henv TDS_ENV;
@@ -529,7 +579,9 @@ bool get_login_info(HWND hwndParent, TDSLOGIN * login);
 	ODBC_PARAM(ApplicationIntent) \
 	ODBC_PARAM(Timeout) \
 	ODBC_PARAM(Encrypt) \
-	ODBC_PARAM(HostNameInCertificate)
+	ODBC_PARAM(HostNameInCertificate) \
+	ODBC_PARAM(StatementCacheSize) \
+	ODBC_PARAM(BulkParamsets)
 
 #define ODBC_PARAM(p) ODBC_PARAM_##p,
 enum {
@@ -571,6 +623,8 @@ int odbc_build_connect_string(TDS_ERRS *errs, TDS_PARSED_PARAM *params, char **o
 SQLLEN odbc_tds2sql_col(TDS_STMT * stmt, TDSCOLUMN *curcol, int desttype,
 			TDS_CHAR * dest, SQLULEN destlen, const struct _drecord *drec_ixd);
 SQLLEN odbc_tds2sql_int4(TDS_STMT * stmt, TDS_INT *src, int desttype, TDS_CHAR * dest, SQLULEN destlen);
+void odbc_tds2sql_plan(TDS_ODBC_COL_PLAN *plan, TDSCOLUMN *curcol, int desttype);
+SQLLEN odbc_tds2sql_fast(const TDS_ODBC_COL_PLAN *plan, TDSCOLUMN *curcol, TDS_CHAR * dest);
 
 
 
@@ -721,8 +775,10 @@ void odbc_bcp_init(TDS_DBC *dbc, const ODBC_CHAR *tblname, const ODBC_CHAR *hfil
 void odbc_bcp_control(TDS_DBC *dbc, int field, void *value);
 void odbc_bcp_colptr(TDS_DBC *dbc, const void * colptr, int table_column);
 void odbc_bcp_sendrow(TDS_DBC *dbc);
+int odbc_bcp_sendcolumns(TDS_DBC *dbc, const void *columns, int num_columns, int num_rows);
 int odbc_bcp_batch(TDS_DBC *dbc);
 int odbc_bcp_done(TDS_DBC *dbc);
+SQLRETURN odbc_bcp_paramset(TDS_STMT *stmt);
 void odbc_bcp_bind(TDS_DBC *dbc, const void * varaddr, int prefixlen, int varlen, const void * terminator, int termlen,
 		   int vartype, int table_column);
 
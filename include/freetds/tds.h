@@ -176,6 +176,9 @@ typedef struct tdsdaterec
  */
 extern const int tds_numeric_bytes_per_prec[];
 
+/** pairs of decimal digits from "00" to "99" */
+extern const char tds_digit_pairs[];
+
 typedef int TDSRET;
 #define TDS_NO_MORE_RESULTS  ((TDSRET)1)
 #define TDS_SUCCESS          ((TDSRET)0)
@@ -521,6 +524,8 @@ typedef struct tds_login
 	TDS_TINYINT encryption_level;
 
 	TDS_INT query_timeout;
+	/** number of prepared statements the ODBC driver keeps for reuse, 0 to disable */
+	TDS_INT stmt_cache_size;
 	TDS_CAPABILITIES capabilities;
 	DSTR client_charset;
 	DSTR database;
@@ -551,6 +556,7 @@ typedef struct tds_login
 	unsigned int enable_tls_v1:1;
 	unsigned int enable_tls_v1_specified:1;
 	unsigned int server_is_valid:1;
+	unsigned int bulk_paramsets:1;	/**< send INSERT parameter arrays using bulk copy */
 } TDSLOGIN;
 
 typedef struct tds_headers
@@ -568,6 +574,10 @@ typedef struct tds_locale
 	char *datetime_fmt;
 	char *date_fmt;
 	char *time_fmt;
+	/** formats above compiled by tds_locale_compile_formats(), if locale independent */
+	struct tds_datefmt *datetime_compiled;
+	struct tds_datefmt *date_compiled;
+	struct tds_datefmt *time_compiled;
 } TDSLOCALE;
 
 /** 
@@ -614,6 +624,8 @@ typedef struct tds_bcpcoldata
 	TDS_UCHAR *data;
 	TDS_INT    datalen;
 	bool       is_null;
+	/** bytes allocated for data */
+	TDS_INT    datasize;
 } BCPCOLDATA;
 
 
@@ -746,6 +758,8 @@ struct tds_column
 	TDS_INT bcp_prefix_len;
 	TDS_INT bcp_term_len;
 	TDS_CHAR *bcp_terminator;
+	/** distance in bytes between rows of bound array, 0 if not an array */
+	TDS_INT bcp_stride;
 };
 
 
@@ -1630,6 +1644,7 @@ TDSRET tds_vstrbuild(char *buffer, int buflen, int *resultlen, const char *text,
 char *tds_money_to_string(const TDS_MONEY * money, char *s, bool use_2_digits);
 TDS_INT tds_numeric_to_string(const TDS_NUMERIC * numeric, char *s);
 TDS_INT tds_numeric_change_prec_scale(TDS_NUMERIC * numeric, unsigned char new_prec, unsigned char new_scale);
+char *tds_format_uint8(TDS_UINT8 num, char *end);
 
 
 /* getmac.c */
@@ -1678,6 +1693,29 @@ typedef struct tds5_colinfo
 	TDS_INT length;
 } TDS5COLINFO;
 
+/** How a column is written in a bulk copy row, see TDSBCPCOLPLAN */
+enum tds_bcp_writer
+{
+	TDS_BCP_WRITE_GENERIC,	/**< use column put_data */
+	TDS_BCP_WRITE_FIXED,	/**< fixed size data, no length */
+	TDS_BCP_WRITE_BYTELEN,	/**< data preceded by 1 byte length */
+	TDS_BCP_WRITE_SHORTLEN	/**< data preceded by 2 bytes length */
+};
+
+/** Precomputed information to send a column in bulk copy rows */
+typedef struct tds_bcp_col_plan
+{
+	TDSCOLUMN *col;
+	/** index of column in bindinfo */
+	TDS_SMALLINT index;
+	/** how to write data, see enum tds_bcp_writer */
+	TDS_TINYINT writer;
+	/** NULL can be sent */
+	bool nullable;
+	/** size for fixed data or maximum size */
+	TDS_INT size;
+} TDSBCPCOLPLAN;
+
 struct tds_bcpinfo
 {
 	void *parent;
@@ -1691,12 +1729,38 @@ struct tds_bcpinfo
 	TDSRESULTINFO *bindinfo;
 	TDS5COLINFO *sybase_colinfo;
 	TDS_INT sybase_count;
+	/**
+	 * Columns to send in each row, built by tds_bcp_start_copy_in.
+	 * For TDS 5.0 contains fixed columns, then variable columns, then blobs.
+	 */
+	TDSBCPCOLPLAN *plan;
+	TDS_INT plan_count;
+	TDS_INT plan_fixed, plan_variable;
 };
 
 TDSRET tds_bcp_init(TDSSOCKET *tds, TDSBCPINFO *bcpinfo);
 typedef TDSRET (*tds_bcp_get_col_data) (TDSBCPINFO *bulk, TDSCOLUMN *bcpcol, int offset);
 typedef void (*tds_bcp_null_error)   (TDSBCPINFO *bulk, int index, int offset);
 TDSRET tds_bcp_send_record(TDSSOCKET *tds, TDSBCPINFO *bcpinfo, tds_bcp_get_col_data get_col_data, tds_bcp_null_error null_error, int offset);
+
+/**
+ * Data of a column for many rows, in columnar layout, see tds_bcp_send_columns.
+ * Same layout of Apache Arrow buffers.
+ */
+typedef struct tds_bcp_column_buffer
+{
+	/** type of values, a fixed size type or a char/binary type */
+	TDS_SERVER_TYPE type;
+	/** values of fixed size types or data of all rows concatenated, NULL if all rows are NULL */
+	const void *values;
+	/** for char/binary types num_rows + 1 offsets into values, NULL for fixed size types */
+	const TDS_INT *offsets;
+	/** bit (row % 8) of byte (row / 8) is set if row is not NULL, NULL if no row is NULL */
+	const unsigned char *validity;
+} TDSBCPCOLBUF;
+
+TDSRET tds_bcp_send_columns(TDSSOCKET *tds, TDSBCPINFO *bcpinfo, const TDSBCPCOLBUF *columns, TDS_INT num_rows,
+			    tds_bcp_null_error null_error, TDS_INT *rows_sent);
 TDSRET tds_bcp_done(TDSSOCKET *tds, int *rows_copied);
 TDSRET tds_bcp_start(TDSSOCKET *tds, TDSBCPINFO *bcpinfo);
 TDSRET tds_bcp_start_copy_in(TDSSOCKET *tds, TDSBCPINFO *bcpinfo);
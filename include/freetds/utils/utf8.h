@@ -0,0 +1,50 @@
+/* FreeTDS - Library of routines accessing Sybase and Microsoft databases
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef _tdsguard_dK3mUq8XvR5tWb2NcYf7Ea_
+#define _tdsguard_dK3mUq8XvR5tWb2NcYf7Ea_
+
+#include <tds_sysdep_public.h>
+#include <freetds/utils/bjoern-utf8.h>
+
+#include <freetds/pushvis.h>
+
+/** length of the initial part of a buffer containing only ASCII characters */
+size_t tds_utf8_ascii_len(const unsigned char *s, size_t len);
+
+/**
+ * Validate an UTF-8 buffer and count its characters.
+ * Scan stops at the first invalid or truncated sequence.
+ * @param s        buffer to check
+ * @param len      length of buffer in bytes
+ * @param p_chars  if not NULL returns number of characters (code points)
+ * @param p_utf16  if not NULL returns number of UTF-16 units required
+ * @return length in bytes of the valid part of the buffer
+ */
+size_t tds_utf8_count(const unsigned char *s, size_t len, size_t *p_chars, size_t *p_utf16);
+
+/**
+ * Convert UTF-8 to UTF-16LE, iconv(3) like.
+ * Pointers and lengths are updated to reflect converted data.
+ * @return 0 on success or EILSEQ, EINVAL or E2BIG, same as iconv errors
+ */
+int tds_utf8_to_utf16le(const unsigned char **p_in, size_t *p_in_len, unsigned char **p_out, size_t *p_out_len);
+
+#include <freetds/popvis.h>
+
+#endif /* _tdsguard_dK3mUq8XvR5tWb2NcYf7Ea_ */
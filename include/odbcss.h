@@ -54,6 +54,7 @@ extern "C" {
 
 #define SQL_INFO_FREETDS_TDS_VERSION	1300
 #define SQL_INFO_FREETDS_SOCKET	1301
+#define SQL_INFO_FREETDS_STMT_CACHE_HITS	1302
 
 #ifndef SQL_MARS_ENABLED_NO
 #define SQL_MARS_ENABLED_NO	0
@@ -185,6 +186,7 @@ typedef struct tagSS_TIMESTAMPOFFSET_STRUCT {
 #define SQL_COPT_TDSODBC_IMPL_BCP_BIND	(SQL_COPT_TDSODBC_IMPL_BASE+6)
 #define SQL_COPT_TDSODBC_IMPL_BCP_INITW	(SQL_COPT_TDSODBC_IMPL_BASE+7)
 #define SQL_COPT_TDSODBC_IMPL_BCP_CONTROL	(SQL_COPT_TDSODBC_IMPL_BASE+8)
+#define SQL_COPT_TDSODBC_IMPL_BCP_SENDCOLUMNS	(SQL_COPT_TDSODBC_IMPL_BASE+9)
 
 #define SQL_VARLEN_DATA -10
 
@@ -363,6 +365,37 @@ bcp_bind(HDBC hdbc, const unsigned char * varaddr, int prefixlen, int varlen,
 	return SQL_SUCCEEDED(SQLSetConnectAttr(hdbc, SQL_COPT_TDSODBC_IMPL_BCP_BIND, &params, SQL_IS_POINTER)) ? SUCCEED : FAIL;
 }
 
+/* FreeTDS extension, data of a column for bcp_sendcolumns, same layout of Apache Arrow buffers */
+typedef struct
+{
+	/* BCP_TYPE_xxx of values, a fixed size type or a char/binary type */
+	int vartype;
+	/* fixed size values or data of all rows concatenated, NULL if all rows are NULL */
+	const void *values;
+	/* for char/binary types num_rows + 1 offsets into values, NULL for fixed size types */
+	const int *offsets;
+	/* bit (row % 8) of byte (row / 8) is set if row is not NULL, NULL if no row is NULL */
+	const unsigned char *validity;
+} BCPCOLUMNDATA;
+
+struct tdsodbc_impl_bcp_sendcolumns_params
+{
+	const BCPCOLUMNDATA *columns;
+	int num_columns;
+	int num_rows;
+	int rows_sent;
+};
+
+static TDSODBC_INLINE RETCODE SQL_API
+bcp_sendcolumns(HDBC hdbc, const BCPCOLUMNDATA *columns, int num_columns, int num_rows, int *rows_sent)
+{
+	struct tdsodbc_impl_bcp_sendcolumns_params params = {columns, num_columns, num_rows, 0};
+	RETCODE ret = SQL_SUCCEEDED(SQLSetConnectAttr(hdbc, SQL_COPT_TDSODBC_IMPL_BCP_SENDCOLUMNS, &params, SQL_IS_POINTER)) ? SUCCEED : FAIL;
+	if (rows_sent)
+		*rows_sent = params.rows_sent;
+	return ret;
+}
+
 #ifdef UNICODE
 #define bcp_init bcp_initW
 #define BCPHINTS BCPHINTSW
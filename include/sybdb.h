@@ -1319,13 +1319,17 @@ RETCODE bcp_colfmt(DBPROCESS * dbproc, int host_column, int host_type, int host_
 RETCODE bcp_colfmt_ps(DBPROCESS * dbproc, int host_column, int host_type, int host_prefixlen, DBINT host_collen,
 		      BYTE * host_term, int host_termlen, int colnum, DBTYPEINFO * typeinfo);
 RETCODE bcp_colptr(DBPROCESS * dbproc, BYTE * colptr, int table_column);
+RETCODE bcp_colstride(DBPROCESS * dbproc, DBINT stride, int table_column); /* FreeTDS only */
 RETCODE bcp_control(DBPROCESS * dbproc, int field, DBINT value);
 int bcp_getbatchsize(DBPROCESS * dbproc); /* FreeTDS only */
 RETCODE bcp_exec(DBPROCESS * dbproc, DBINT * rows_copied);
+RETCODE bcp_filerange(DBPROCESS * dbproc, DBBIGINT first_byte, DBBIGINT end_byte); /* FreeTDS only */
+RETCODE bcp_journal(DBPROCESS * dbproc, const char *filename, int resume); /* FreeTDS only */
 DBBOOL bcp_getl(LOGINREC * login);
 RETCODE bcp_options(DBPROCESS * dbproc, int option, BYTE * value, int valuelen);
 RETCODE bcp_readfmt(DBPROCESS * dbproc, const char filename[]);
 RETCODE bcp_sendrow(DBPROCESS * dbproc);
+RETCODE bcp_sendrows(DBPROCESS * dbproc, DBINT nrows, DBINT * rows_sent); /* FreeTDS only */
 
 #ifdef __cplusplus
 #if 0
@@ -50,6 +50,7 @@
 
 #include <freetds/replacements.h>
 #include <freetds/macros.h>
+#include <freetds/thread.h>
 
 typedef struct
 {
@@ -85,6 +86,7 @@ static int create_target_table(char *sobjname, char *owner, char *dobjname, DBPR
 static int check_table_structures(char *sobjname, char *dobjname, DBPROCESS * dbsrc, DBPROCESS * dbdest);
 static int transfer_data(const BCPPARAMDATA * params, DBPROCESS * dbsrc, DBPROCESS * dbdest);
 static RETCODE set_textsize(DBPROCESS *dbproc, int textsize);
+static int send_row(const BCPPARAMDATA * params, DBPROCESS * dbdest, DBINT * rows_sent, DBINT * rows_done);
 
 static int err_handler(DBPROCESS *, int, int, int, char *, char *);
 static int msg_handler(DBPROCESS *, DBINT, int, int, char *, char *, char *, int);
@@ -576,6 +578,227 @@ check_table_structures(char *sobjname, char *dobjname, DBPROCESS * dbsrc, DBPROC
 	return TRUE;
 }
 
+/* send current bound row, committing every batchsize rows */
+static int
+send_row(const BCPPARAMDATA * params, DBPROCESS * dbdest, DBINT * rows_sent, DBINT * rows_done)
+{
+	DBINT ret;
+
+	if (bcp_sendrow(dbdest) == FAIL) {
+		fprintf(stderr, "bcp_sendrow failed.  \n");
+		return FALSE;
+	}
+	if (++*rows_sent == params->batchsize) {
+		ret = bcp_batch(dbdest);
+		if (ret == -1) {
+			fprintf(stderr, "bcp_batch error\n");
+			return FALSE;
+		}
+		*rows_done += ret;
+		printf("%d rows successfully copied (total %d)\n", ret, *rows_done);
+		*rows_sent = 0;
+	}
+	return TRUE;
+}
+
+#ifdef TDS_HAVE_MUTEX
+/* rows read from source and not sent yet */
+#define ROW_QUEUE_SIZE 64
+
+typedef struct
+{
+	/* data of all columns */
+	BYTE *data;
+	size_t size;
+	/* length of every column, -1 for NULL */
+	DBINT *lens;
+} QUEUEDROW;
+
+/* rows passed from the thread reading source to the one writing to destination */
+typedef struct
+{
+	DBPROCESS *dbsrc;
+	int numcols;
+	tds_mutex mtx;
+	/* signaled when a row is added or removed */
+	tds_condition cond;
+	QUEUEDROW rows[ROW_QUEUE_SIZE];
+	int head, count;
+	BOOL eof, stop, failed;
+	DBINT rows_read;
+} ROWQUEUE;
+
+/* copy current row of source, data are taken as they came from server */
+static int
+save_row(DBPROCESS * dbsrc, int numcols, QUEUEDROW * row)
+{
+	size_t size = 0;
+	BYTE *p;
+	int col;
+
+	for (col = 0; col < numcols; col++) {
+		row->lens[col] = dbdata(dbsrc, col + 1) ? dbdatlen(dbsrc, col + 1) : -1;
+		if (row->lens[col] > 0)
+			size += row->lens[col];
+	}
+	if (size > row->size) {
+		p = (BYTE *) realloc(row->data, size);
+		if (!p)
+			return FALSE;
+		row->data = p;
+		row->size = size;
+	}
+	p = row->data;
+	for (col = 0; col < numcols; col++) {
+		if (row->lens[col] <= 0)
+			continue;
+		memcpy(p, dbdata(dbsrc, col + 1), row->lens[col]);
+		p += row->lens[col];
+	}
+	return TRUE;
+}
+
+static TDS_THREAD_PROC_DECLARE(read_rows, arg)
+{
+	ROWQUEUE *queue = (ROWQUEUE *) arg;
+	QUEUEDROW *row;
+	BOOL failed = FALSE;
+
+	while (dbnextrow(queue->dbsrc) == REG_ROW) {
+		tds_mutex_lock(&queue->mtx);
+		while (queue->count == ROW_QUEUE_SIZE && !queue->stop)
+			tds_cond_wait(&queue->cond, &queue->mtx);
+		if (queue->stop) {
+			tds_mutex_unlock(&queue->mtx);
+			dbcancel(queue->dbsrc);
+			break;
+		}
+		/* slot is not used by the writer until count is incremented */
+		row = &queue->rows[(queue->head + queue->count) % ROW_QUEUE_SIZE];
+		tds_mutex_unlock(&queue->mtx);
+
+		if (!save_row(queue->dbsrc, queue->numcols, row)) {
+			fprintf(stderr, "Could not allocate memory for row\n");
+			failed = TRUE;
+			dbcancel(queue->dbsrc);
+			break;
+		}
+
+		tds_mutex_lock(&queue->mtx);
+		queue->count++;
+		queue->rows_read++;
+		tds_cond_signal(&queue->cond);
+		tds_mutex_unlock(&queue->mtx);
+	}
+
+	tds_mutex_lock(&queue->mtx);
+	queue->eof = TRUE;
+	queue->failed = failed;
+	tds_cond_signal(&queue->cond);
+	tds_mutex_unlock(&queue->mtx);
+	return TDS_THREAD_RESULT(0);
+}
+
+/*
+ * Read source rows in a separate thread so reading and writing overlap.
+ * Column data are passed to bcp as received, same types do not need conversions.
+ */
+static int
+copy_rows_threaded(const BCPPARAMDATA * params, DBPROCESS * dbsrc, DBPROCESS * dbdest, int numcols,
+		   DBINT * rows_read, DBINT * rows_sent, DBINT * rows_done)
+{
+	ROWQUEUE *queue;
+	tds_thread reader;
+	QUEUEDROW *row;
+	BYTE *p;
+	int i, col, ok = TRUE;
+
+	queue = (ROWQUEUE *) calloc(1, sizeof(ROWQUEUE));
+	if (!queue) {
+		fprintf(stderr, "Could not allocate memory for row queue\n");
+		return FALSE;
+	}
+	queue->dbsrc = dbsrc;
+	queue->numcols = numcols;
+	for (i = 0; i < ROW_QUEUE_SIZE; i++) {
+		queue->rows[i].lens = (DBINT *) calloc(numcols, sizeof(DBINT));
+		if (!queue->rows[i].lens)
+			ok = FALSE;
+	}
+	if (!ok) {
+		fprintf(stderr, "Could not allocate memory for row queue\n");
+		goto cleanup;
+	}
+	if (tds_mutex_init(&queue->mtx) != 0) {
+		fprintf(stderr, "Could not initialize row queue mutex\n");
+		ok = FALSE;
+		goto cleanup;
+	}
+	if (tds_cond_init(&queue->cond) != 0) {
+		tds_mutex_free(&queue->mtx);
+		ok = FALSE;
+		goto cleanup;
+	}
+	if (tds_thread_create(&reader, read_rows, queue) != 0) {
+		fprintf(stderr, "Could not start reading thread\n");
+		tds_cond_destroy(&queue->cond);
+		tds_mutex_free(&queue->mtx);
+		ok = FALSE;
+		goto cleanup;
+	}
+
+	for (;;) {
+		tds_mutex_lock(&queue->mtx);
+		while (queue->count == 0 && !queue->eof)
+			tds_cond_wait(&queue->cond, &queue->mtx);
+		if (queue->count == 0) {
+			tds_mutex_unlock(&queue->mtx);
+			break;
+		}
+		row = &queue->rows[queue->head];
+		tds_mutex_unlock(&queue->mtx);
+
+		p = row->data;
+		for (col = 0; col < numcols; col++) {
+			if (row->lens[col] < 0) {
+				bcp_colptr(dbdest, NULL, col + 1);
+				bcp_collen(dbdest, 0, col + 1);
+				continue;
+			}
+			bcp_colptr(dbdest, p, col + 1);
+			bcp_collen(dbdest, row->lens[col], col + 1);
+			p += row->lens[col];
+		}
+		ok = send_row(params, dbdest, rows_sent, rows_done);
+
+		tds_mutex_lock(&queue->mtx);
+		queue->head = (queue->head + 1) % ROW_QUEUE_SIZE;
+		queue->count--;
+		if (!ok)
+			queue->stop = TRUE;
+		tds_cond_signal(&queue->cond);
+		tds_mutex_unlock(&queue->mtx);
+		if (!ok)
+			break;
+	}
+
+	tds_thread_join(reader, NULL);
+	if (queue->failed)
+		ok = FALSE;
+	*rows_read = queue->rows_read;
+	tds_cond_destroy(&queue->cond);
+	tds_mutex_free(&queue->mtx);
+
+cleanup:
+	for (i = 0; i < ROW_QUEUE_SIZE; i++) {
+		free(queue->rows[i].data);
+		free(queue->rows[i].lens);
+	}
+	free(queue);
+	return ok;
+}
+#endif
+
 static int
 transfer_data(const BCPPARAMDATA * params, DBPROCESS * dbsrc, DBPROCESS * dbdest)
 {
@@ -673,6 +896,7 @@ transfer_data(const BCPPARAMDATA * params, DBPROCESS * dbsrc, DBPROCESS * dbdest
 
 		srcdata[col].coltype = dbcoltype(dbsrc, col + 1);
 
+		/* types are checked only here, rows are copied as is without checking them again */
 		switch (srcdata[col].coltype) {
 		case SYBBIT:
 		case SYBINT1:
@@ -708,65 +932,27 @@ transfer_data(const BCPPARAMDATA * params, DBPROCESS * dbsrc, DBPROCESS * dbdest
 
 	gettimeofday(&start_time, 0);
 
-	while (dbnextrow(dbsrc) != NO_MORE_ROWS) {
+#ifdef TDS_HAVE_MUTEX
+	if (!copy_rows_threaded(params, dbsrc, dbdest, src_numcols, &rows_read, &rows_sent, &rows_done)) {
+		free(srcdata);
+		return FALSE;
+	}
+#else
+	while (dbnextrow(dbsrc) == REG_ROW) {
 		rows_read++;
 		for (col = 0; col < src_numcols; col++) {
 			BYTE *data = dbdata(dbsrc, col + 1);
 
-			switch (srcdata[col].coltype) {
-			case SYBBIT:
-			case SYBINT1:
-			case SYBINT2:
-			case SYBINT4:
-			case SYBINT8:
-			case SYBFLT8:
-			case SYBREAL:
-			case SYBDATETIME:
-			case SYBDATETIME4:
-			case SYBTIME:
-			case SYBDATE:
-			case SYBBIGTIME:
-			case SYBBIGDATETIME:
-			case SYBMONEY:
-			case SYBMONEY4:
-			case SYBCHAR:
-			case SYBTEXT:
-			case SYBBINARY:
-			case SYBIMAGE:
-			case SYBNUMERIC:
-			case SYBDECIMAL:
-				bcp_colptr(dbdest, data, col + 1);
-				if (data == NULL) {	/* NULL data retrieved from source */
-					bcp_collen(dbdest, 0, col + 1);
-				} else {
-					bcp_collen(dbdest, dbdatlen(dbsrc, col + 1), col + 1);
-				}
-				break;
-			default:
-				fprintf(stderr, "Type %d not handled by datacopy\n", srcdata[col].coltype);
-				exit(1);
-			}
+			bcp_colptr(dbdest, data, col + 1);
+			/* zero length for NULL data retrieved from source */
+			bcp_collen(dbdest, data ? dbdatlen(dbsrc, col + 1) : 0, col + 1);
 		}
-		if (bcp_sendrow(dbdest) == FAIL) {
-			fprintf(stderr, "bcp_sendrow failed.  \n");
+		if (!send_row(params, dbdest, &rows_sent, &rows_done)) {
 			free(srcdata);
 			return FALSE;
-		} else {
-			rows_sent++;
-			if (rows_sent == params->batchsize) {
-				ret = bcp_batch(dbdest);
-				if (ret == -1) {
-					fprintf(stderr, "bcp_batch error\n");
-					free(srcdata);
-					return FALSE;
-				} else {
-					rows_done += ret;
-					printf("%d rows successfully copied (total %d)\n", ret, rows_done);
-					rows_sent = 0;
-				}
-			}
 		}
 	}
+#endif
 
 	if (rows_read) {
 		ret = bcp_done(dbdest);
@@ -57,11 +57,44 @@
 
 #include <freetds/tds.h>
 #include <freetds/utils.h>
+#include <freetds/thread.h>
+#include <freetds/time.h>
 #include <freetds/replacements.h>
 #include <sybfront.h>
 #include <sybdb.h>
 #include "freebcp.h"
 
+#ifdef HAVE_FSEEKO
+typedef off_t offset_type;
+#elif defined(_WIN32) || defined(_WIN64)
+/* win32 version */
+typedef __int64 offset_type;
+# if defined(HAVE__FSEEKI64) && defined(HAVE__FTELLI64)
+#  define fseeko(f,o,w) _fseeki64((f),o,w)
+#  define ftello(f) _ftelli64((f))
+# else
+#  define fseeko(f,o,w) (_lseeki64(fileno(f),o,w) == -1 ? -1 : 0)
+#  define ftello(f) _telli64(fileno(f))
+# endif
+#else
+/* use old version */
+#define fseeko(f,o,w) fseek(f,o,w)
+#define ftello(f) ftell(f)
+typedef long offset_type;
+#endif
+
+#define MAX_JOBS 64
+#define MERGE_BUFSIZE 0x100000
+
+/** a connection copying part of the file in parallel with others */
+typedef struct
+{
+	BCPPARAMDATA params;
+	DBPROCESS *dbproc;
+	int ok;
+	double elapsed;
+} BCPWORKER;
+
 void pusage(void);
 int process_parameters(int, char **, struct pd *);
 static int unescape(char arg[]);
@@ -76,6 +109,8 @@ int err_handler(DBPROCESS * dbproc, int severity, int dberr, int oserr, char *db
 int msg_handler(DBPROCESS * dbproc, DBINT msgno, int msgstate, int severity, char *msgtext, char *srvname, char *procname,
 		int line);
 static int set_bcp_hints(BCPPARAMDATA *pdata, DBPROCESS *pdbproc);
+static int parallel_copy(BCPPARAMDATA *pdata);
+static int set_journal(const BCPPARAMDATA *pdata, DBPROCESS *dbproc);
 
 int
 main(int argc, char **argv)
@@ -103,6 +138,11 @@ main(int argc, char **argv)
 	}
 
 
+	if (params.jobs > 1) {
+		ok = parallel_copy(&params);
+		exit((ok == TRUE) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
 	if (login_to_database(&params, &dbproc) == FALSE) {
 		exit(EXIT_FAILURE);
 	}
@@ -213,7 +253,7 @@ process_parameters(int argc, char **argv, BCPPARAMDATA *pdata)
 	 * Get the rest of the arguments
 	 */
 	optind = 4; /* start processing options after table, direction, & filename */
-	while ((ch = getopt(argc, argv, "m:f:e:F:L:b:t:r:U:P:i:I:S:h:T:A:o:O:0:C:ncEdvVD:")) != -1) {
+	while ((ch = getopt(argc, argv, "m:f:e:F:L:b:t:r:U:P:i:I:S:h:T:A:o:O:0:C:j:p:J:ncEsRdvVD:")) != -1) {
 		switch (ch) {
 		case 'v':
 		case 'V':
@@ -313,6 +353,24 @@ process_parameters(int argc, char **argv, BCPPARAMDATA *pdata)
 		case 'C':
 			pdata->charset = strdup(optarg);
 			break;
+		case 'j':
+			pdata->jflag++;
+			pdata->jobs = atoi(optarg);
+			break;
+		case 'p':
+			free(pdata->partkey);
+			pdata->partkey = strdup(optarg);
+			break;
+		case 's':
+			pdata->sflag++;
+			break;
+		case 'J':
+			free(pdata->journalfile);
+			pdata->journalfile = strdup(optarg);
+			break;
+		case 'R':
+			pdata->Rflag++;
+			break;
 		case '?':
 		default:
 			pusage();
@@ -342,6 +400,40 @@ process_parameters(int argc, char **argv, BCPPARAMDATA *pdata)
 		return (FALSE);
 	}
 
+	/* Parallel copy */
+	if (pdata->jflag) {
+		if (pdata->jobs < 1 || pdata->jobs > MAX_JOBS) {
+			fprintf(stderr, "-j must be between 1 and %d.\n", MAX_JOBS);
+			return (FALSE);
+		}
+		if (pdata->direction == DB_IN && pdata->jobs > 1 && !pdata->cflag && !pdata->Lflag) {
+			fprintf(stderr, "-j with -n or -f requires -L.\n");
+			return (FALSE);
+		}
+		if (pdata->direction != DB_IN && pdata->jobs > 1) {
+			if (!pdata->partkey) {
+				fprintf(stderr, "-j copying out requires -p.\n");
+				return (FALSE);
+			}
+			if (pdata->Fflag || pdata->Lflag) {
+				fprintf(stderr, "-j copying out cannot be used with -F or -L.\n");
+				return (FALSE);
+			}
+		}
+	}
+	if ((pdata->partkey || pdata->sflag) && (pdata->direction == DB_IN || pdata->jobs < 2)) {
+		fprintf(stderr, "-p and -s can only be used copying out with -j.\n");
+		return (FALSE);
+	}
+	if (pdata->journalfile && pdata->direction != DB_IN) {
+		fprintf(stderr, "-J can only be used copying in.\n");
+		return (FALSE);
+	}
+	if (pdata->Rflag && !pdata->journalfile) {
+		fprintf(stderr, "-R requires -J.\n");
+		return (FALSE);
+	}
+
 	/* Character mode file: fill in default values */
 	if (pdata->cflag) {
 
@@ -485,6 +577,13 @@ file_character(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 	bcp_control(dbproc, BCPLAST, pdata->lastrow);
 	bcp_control(dbproc, BCPMAXERRS, pdata->maxerrors);
 
+	if ((pdata->range_start || pdata->range_end)
+	    && bcp_filerange(dbproc, pdata->range_start, pdata->range_end) == FAIL)
+		return FALSE;
+
+	if (pdata->journalfile && !set_journal(pdata, dbproc))
+		return FALSE;
+
 	if (dir == DB_QUERYOUT) {
 		if (dbfcmd(dbproc, "SET FMTONLY ON %s SET FMTONLY OFF", pdata->dbobject) == FAIL) {
 			fprintf(stderr, "dbfcmd failed\n");
@@ -534,14 +633,17 @@ file_character(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 
 	bcp_control(dbproc, BCPBATCH, pdata->batchsize);
 
-	printf("\nStarting copy...\n");
+	if (!pdata->worker)
+		printf("\nStarting copy...\n");
 
 	if (FAIL == bcp_exec(dbproc, &li_rowsread)) {
 		fprintf(stderr, "bcp copy %s failed\n", (dir == DB_IN) ? "in" : "out");
 		return FALSE;
 	}
 
-	printf("%d rows copied.\n", li_rowsread);
+	pdata->rows_copied = li_rowsread;
+	if (!pdata->worker)
+		printf("%d rows copied.\n", li_rowsread);
 
 	return TRUE;
 }
@@ -583,6 +685,13 @@ file_native(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 	bcp_control(dbproc, BCPLAST, pdata->lastrow);
 	bcp_control(dbproc, BCPMAXERRS, pdata->maxerrors);
 
+	if ((pdata->range_start || pdata->range_end)
+	    && bcp_filerange(dbproc, pdata->range_start, pdata->range_end) == FAIL)
+		return FALSE;
+
+	if (pdata->journalfile && !set_journal(pdata, dbproc))
+		return FALSE;
+
 	if (dir == DB_QUERYOUT) {
 		if (dbfcmd(dbproc, "SET FMTONLY ON %s SET FMTONLY OFF", pdata->dbobject) == FAIL) {
 			fprintf(stderr, "dbfcmd failed\n");
@@ -625,7 +734,8 @@ file_native(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 		}
 	}
 
-	printf("\nStarting copy...\n\n");
+	if (!pdata->worker)
+		printf("\nStarting copy...\n\n");
 
 
 	if (FAIL == bcp_exec(dbproc, &li_rowsread)) {
@@ -633,7 +743,9 @@ file_native(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 		return FALSE;
 	}
 
-	printf("%d rows copied.\n", li_rowsread);
+	pdata->rows_copied = li_rowsread;
+	if (!pdata->worker)
+		printf("%d rows copied.\n", li_rowsread);
 
 	return TRUE;
 }
@@ -672,10 +784,18 @@ file_formatted(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 	bcp_control(dbproc, BCPLAST, pdata->lastrow);
 	bcp_control(dbproc, BCPMAXERRS, pdata->maxerrors);
 
+	if ((pdata->range_start || pdata->range_end)
+	    && bcp_filerange(dbproc, pdata->range_start, pdata->range_end) == FAIL)
+		return FALSE;
+
+	if (pdata->journalfile && !set_journal(pdata, dbproc))
+		return FALSE;
+
 	if (FAIL == bcp_readfmt(dbproc, pdata->formatfile))
 		return FALSE;
 
-	printf("\nStarting copy...\n\n");
+	if (!pdata->worker)
+		printf("\nStarting copy...\n\n");
 
 
 	if (FAIL == bcp_exec(dbproc, &li_rowsread)) {
@@ -683,7 +803,9 @@ file_formatted(BCPPARAMDATA * pdata, DBPROCESS * dbproc, DBINT dir)
 		return FALSE;
 	}
 
-	printf("%d rows copied.\n", li_rowsread);
+	pdata->rows_copied = li_rowsread;
+	if (!pdata->worker)
+		printf("%d rows copied.\n", li_rowsread);
 
 	return TRUE;
 }
@@ -764,6 +886,465 @@ set_bcp_hints(BCPPARAMDATA *pdata, DBPROCESS *pdbproc)
 	return TRUE;
 }
 
+/**
+ * Find the position after \a count rows of a character file, starting from \a pos.
+ * \return position, end of file if there are not enough rows, -1 on error
+ */
+static offset_type
+skip_rows(FILE *file, offset_type pos, const BCPPARAMDATA *pdata, TDS_INT8 count)
+{
+	char *window;
+	int c, filled = 0;
+	const int len = pdata->rowtermlen;
+
+	if (count <= 0)
+		return pos;
+
+	if (fseeko(file, pos, SEEK_SET) != 0)
+		return -1;
+
+	/* keep last bytes read and compare with the terminator */
+	window = tds_new(char, len);
+	if (!window)
+		return -1;
+	while ((c = getc(file)) != EOF) {
+		++pos;
+		if (filled == len) {
+			memmove(window, window + 1, len - 1);
+			--filled;
+		}
+		window[filled++] = (char) c;
+		if (filled == len && memcmp(window, pdata->rowterm, len) == 0) {
+			if (--count == 0)
+				break;
+			filled = 0;
+		}
+	}
+	free(window);
+
+	return ferror(file) ? -1 : pos;
+}
+
+/**
+ * Split a character file in parts ending at row terminators, one for each job.
+ * \return number of parts, -1 on error
+ */
+static int
+split_character_file(const BCPPARAMDATA *pdata, BCPWORKER *workers)
+{
+	FILE *file;
+	offset_type size, start, end, prev, next;
+	int i, n = 0;
+
+	/* we could not tell row terminators from field ones */
+	for (i = 0; i + pdata->rowtermlen <= pdata->fieldtermlen; ++i) {
+		if (memcmp(pdata->fieldterm + i, pdata->rowterm, pdata->rowtermlen) == 0) {
+			fprintf(stderr, "-j cannot be used if the field terminator contains the row terminator.\n");
+			return -1;
+		}
+	}
+
+	file = fopen(pdata->hostfilename, "rb");
+	if (!file) {
+		fprintf(stderr, "%s: unable to open %s: %s\n", "freebcp", pdata->hostfilename, strerror(errno));
+		return -1;
+	}
+
+	if (fseeko(file, 0, SEEK_END) != 0 || (size = ftello(file)) < 0)
+		goto error;
+
+	start = skip_rows(file, 0, pdata, (TDS_INT8) pdata->firstrow - 1);
+	end = pdata->lastrow > 0 ? skip_rows(file, 0, pdata, pdata->lastrow) : size;
+	if (start < 0 || end < 0)
+		goto error;
+
+	prev = start;
+	for (i = 1; i <= pdata->jobs; ++i) {
+		BCPPARAMDATA *params;
+
+		next = end;
+		if (i < pdata->jobs) {
+			next = start + (end - start) / pdata->jobs * i;
+			next = skip_rows(file, next > prev ? next : prev, pdata, 1);
+			if (next < 0)
+				goto error;
+			if (next > end)
+				next = end;
+		}
+		/* always have a part, even if empty */
+		if (next <= prev && n > 0)
+			continue;
+
+		params = &workers[n].params;
+		*params = *pdata;
+		params->worker = ++n;
+		params->firstrow = 0;
+		params->lastrow = 0;
+		params->range_start = prev;
+		params->range_end = next;
+		prev = next;
+	}
+
+	fclose(file);
+	return n;
+
+error:
+	fprintf(stderr, "%s: error reading %s: %s\n", "freebcp", pdata->hostfilename, strerror(errno));
+	fclose(file);
+	return -1;
+}
+
+/**
+ * Split rows from firstrow to lastrow, one range for each job.
+ * \return number of parts
+ */
+static int
+split_rows(const BCPPARAMDATA *pdata, BCPWORKER *workers)
+{
+	TDS_INT8 first, total, from, to;
+	int i, n = 0;
+
+	first = pdata->firstrow > 1 ? pdata->firstrow : 1;
+	total = pdata->lastrow - first + 1;
+	if (total <= 0) {
+		workers[0].params = *pdata;
+		workers[0].params.worker = 1;
+		return 1;
+	}
+
+	for (i = 0; i < pdata->jobs; ++i) {
+		BCPPARAMDATA *params;
+
+		from = first + total * i / pdata->jobs;
+		to = first + total * (i + 1) / pdata->jobs - 1;
+		if (to < from)
+			continue;
+
+		params = &workers[n].params;
+		*params = *pdata;
+		params->worker = ++n;
+		params->firstrow = (int) from;
+		params->lastrow = (int) to;
+	}
+	return n;
+}
+
+/**
+ * Split rows to copy out in ranges of the partitioning key, one for each job.
+ * Each part is written to a different file.
+ * \return number of parts, -1 on error
+ */
+static int
+split_key_range(BCPPARAMDATA *pdata, BCPWORKER *workers)
+{
+	DBPROCESS *dbproc;
+	const char *source;
+	DBBIGINT min_key = 0, max_key = 0, lo, hi;
+	TDS_UINT8 span, keys, step, rest;
+	RETCODE erc;
+	int i, n = 0;
+
+	/* rows to copy, queries are used as derived tables */
+	source = pdata->direction == DB_QUERYOUT ? "(%s) freebcp_part" : "%s";
+
+	if (login_to_database(pdata, &dbproc) == FALSE)
+		return -1;
+
+	if (!setoptions(dbproc, pdata)
+	    || dbfcmd(dbproc, "select convert(bigint, min(%s)), convert(bigint, max(%s)) from ",
+		      pdata->partkey, pdata->partkey) == FAIL
+	    || dbfcmd(dbproc, source, pdata->dbobject) == FAIL
+	    || dbsqlexec(dbproc) == FAIL) {
+		fprintf(stderr, "unable to get range of partitioning key %s\n", pdata->partkey);
+		dbclose(dbproc);
+		return -1;
+	}
+	while ((erc = dbresults(dbproc)) == SUCCEED) {
+		if (dbnumcols(dbproc) != 2) {
+			while (dbnextrow(dbproc) == REG_ROW)
+				continue;
+			continue;
+		}
+		dbbind(dbproc, 1, BIGINTBIND, 0, (BYTE *) &min_key);
+		dbbind(dbproc, 2, BIGINTBIND, 0, (BYTE *) &max_key);
+		while (dbnextrow(dbproc) == REG_ROW)
+			continue;
+	}
+	dbclose(dbproc);
+	if (erc == FAIL) {
+		fprintf(stderr, "unable to get range of partitioning key %s\n", pdata->partkey);
+		return -1;
+	}
+
+	/*
+	 * First part takes also NULLs and keys lower than the minimum, last part
+	 * keys greater than maximum, so rows changed in the meantime are not lost.
+	 */
+	span = (TDS_UINT8) max_key - (TDS_UINT8) min_key;
+	/* number of possible keys, saturated for the whole bigint range */
+	keys = span + 1 ? span + 1 : span;
+	if (keys < (TDS_UINT8) pdata->jobs)
+		pdata->jobs = (int) keys;
+	/* part i ends at min_key + keys * (i + 1) / jobs, computed without overflows */
+	step = keys / pdata->jobs;
+	rest = keys % pdata->jobs;
+	hi = min_key;
+	for (i = 0; i < pdata->jobs; ++i) {
+		BCPPARAMDATA *params = &workers[n].params;
+		char *where = NULL;
+		int len;
+
+		lo = hi;
+		hi = (DBBIGINT) ((TDS_UINT8) min_key + step * (i + 1) + rest * (i + 1) / pdata->jobs);
+
+		if (pdata->jobs == 1)
+			len = asprintf(&where, "%s", "");
+		else if (i == 0)
+			len = asprintf(&where, " where %s < %" PRId64 " or %s is null", pdata->partkey, hi, pdata->partkey);
+		else if (i == pdata->jobs - 1)
+			len = asprintf(&where, " where %s >= %" PRId64, pdata->partkey, lo);
+		else
+			len = asprintf(&where, " where %s >= %" PRId64 " and %s < %" PRId64,
+				       pdata->partkey, lo, pdata->partkey, hi);
+
+		*params = *pdata;
+		params->worker = ++n;
+		params->direction = DB_QUERYOUT;
+		params->dbobject = NULL;
+		params->hostfilename = NULL;
+		if (len < 0) {
+			fprintf(stderr, "Out of memory!\n");
+			return -1;
+		}
+		if (pdata->direction == DB_QUERYOUT)
+			len = asprintf(&params->dbobject, "select * from (%s) freebcp_part%s", pdata->dbobject, where);
+		else
+			len = asprintf(&params->dbobject, "select * from %s%s", pdata->dbobject, where);
+		free(where);
+		if (len < 0 || asprintf(&params->hostfilename, "%s.%d", pdata->hostfilename, params->worker) < 0) {
+			fprintf(stderr, "Out of memory!\n");
+			return -1;
+		}
+	}
+	return n;
+}
+
+static TDS_THREAD_PROC_DECLARE(worker_proc, arg)
+{
+	BCPWORKER *worker = (BCPWORKER *) arg;
+	BCPPARAMDATA *pdata = &worker->params;
+	struct timeval start, end;
+
+	gettimeofday(&start, NULL);
+
+	worker->ok = FALSE;
+	if (setoptions(worker->dbproc, pdata)) {
+		if (pdata->cflag)
+			worker->ok = file_character(pdata, worker->dbproc, pdata->direction);
+		else if (pdata->nflag)
+			worker->ok = file_native(pdata, worker->dbproc, pdata->direction);
+		else
+			worker->ok = file_formatted(pdata, worker->dbproc, pdata->direction);
+	}
+
+	gettimeofday(&end, NULL);
+	worker->elapsed = (double) (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+
+	return TDS_THREAD_RESULT(0);
+}
+
+/**
+ * Concatenate, in order, the parts written by the connections into the data file.
+ */
+static int
+merge_parts(const BCPPARAMDATA *pdata, const BCPWORKER *workers, int n)
+{
+	FILE *out, *in;
+	char *buf;
+	size_t len;
+	int i, ok = TRUE;
+
+	buf = tds_new(char, MERGE_BUFSIZE);
+	if (!buf) {
+		fprintf(stderr, "Out of memory!\n");
+		return FALSE;
+	}
+
+	if ((out = fopen(pdata->hostfilename, "wb")) == NULL) {
+		fprintf(stderr, "%s: unable to open %s: %s\n", "freebcp", pdata->hostfilename, strerror(errno));
+		free(buf);
+		return FALSE;
+	}
+
+	for (i = 0; ok && i < n; ++i) {
+		const char *part = workers[i].params.hostfilename;
+
+		if ((in = fopen(part, "rb")) == NULL) {
+			fprintf(stderr, "%s: unable to open %s: %s\n", "freebcp", part, strerror(errno));
+			ok = FALSE;
+			break;
+		}
+		while ((len = fread(buf, 1, MERGE_BUFSIZE, in)) > 0) {
+			if (fwrite(buf, 1, len, out) != len) {
+				fprintf(stderr, "%s: error writing %s: %s\n", "freebcp", pdata->hostfilename, strerror(errno));
+				ok = FALSE;
+				break;
+			}
+		}
+		if (ok && ferror(in)) {
+			fprintf(stderr, "%s: error reading %s: %s\n", "freebcp", part, strerror(errno));
+			ok = FALSE;
+		}
+		fclose(in);
+	}
+
+	if (fclose(out) != 0 && ok) {
+		fprintf(stderr, "%s: error writing %s: %s\n", "freebcp", pdata->hostfilename, strerror(errno));
+		ok = FALSE;
+	}
+	free(buf);
+
+	/* parts are no more needed */
+	for (i = 0; ok && i < n; ++i)
+		remove(workers[i].params.hostfilename);
+
+	return ok;
+}
+
+/**
+ * Copy using multiple connections, each one copying a part of the data.
+ */
+static int
+parallel_copy(BCPPARAMDATA *pdata)
+{
+	BCPWORKER *workers;
+#ifdef TDS_HAVE_MUTEX
+	tds_thread threads[MAX_JOBS];
+#endif
+	int i, n, started, jobs, ok = TRUE;
+	char *pass = NULL;
+	DBINT total = 0;
+	struct timeval start, end;
+	double elapsed;
+
+	jobs = pdata->jobs;
+	workers = tds_new0(BCPWORKER, jobs);
+	if (!workers) {
+		fprintf(stderr, "Out of memory!\n");
+		return FALSE;
+	}
+
+	/* login_to_database clears the password, keep a copy for other connections */
+	if (pdata->pass && (pass = strdup(pdata->pass)) == NULL) {
+		fprintf(stderr, "Out of memory!\n");
+		free(workers);
+		return FALSE;
+	}
+
+	if (pdata->direction != DB_IN)
+		n = split_key_range(pdata, workers);
+	else if (pdata->cflag)
+		n = split_character_file(pdata, workers);
+	else
+		n = split_rows(pdata, workers);
+	if (n <= 0) {
+		n = 0;
+		ok = FALSE;
+	}
+
+	for (i = 0; ok && i < n; ++i) {
+		BCPPARAMDATA *params = &workers[i].params;
+
+		if (pdata->errorfile && asprintf(&params->errorfile, "%s.%d", pdata->errorfile, params->worker) < 0) {
+			fprintf(stderr, "Out of memory!\n");
+			params->errorfile = NULL;
+			ok = FALSE;
+			break;
+		}
+		if (pass)
+			strcpy(pdata->pass, pass);
+		if (login_to_database(params, &workers[i].dbproc) == FALSE) {
+			ok = FALSE;
+			break;
+		}
+		dbsetuserdata(workers[i].dbproc, (BYTE *) &workers[i]);
+	}
+
+	if (pass) {
+		memset(pass, 0, strlen(pass));
+		free(pass);
+	}
+
+	if (ok) {
+		printf("\nStarting copy using %d connections...\n", n);
+		gettimeofday(&start, NULL);
+
+		i = 0;
+#ifdef TDS_HAVE_MUTEX
+		for (; i < n; ++i)
+			if (tds_thread_create(&threads[i], worker_proc, &workers[i]) != 0)
+				break;
+#endif
+		started = i;
+		/* run in this thread what we could not start */
+		for (; i < n; ++i)
+			worker_proc(&workers[i]);
+#ifdef TDS_HAVE_MUTEX
+		for (i = 0; i < started; ++i)
+			tds_thread_join(threads[i], NULL);
+#endif
+
+		printf("\n");
+		for (i = 0; i < n; ++i) {
+			const BCPWORKER *worker = &workers[i];
+
+			printf("Connection %d: %d rows copied in %.3f seconds", worker->params.worker,
+			       (int) worker->params.rows_copied, worker->elapsed);
+			if (worker->elapsed > 0)
+				printf(" (%.2f rows per sec.)", worker->params.rows_copied / worker->elapsed);
+			printf("\n");
+			total += worker->params.rows_copied;
+
+			if (worker->ok)
+				continue;
+			if (ok && pdata->direction != DB_IN)
+				fprintf(stderr, "Connection %d failed copying \"%s\"\n",
+					worker->params.worker, worker->params.dbobject);
+			else if (ok && pdata->cflag)
+				fprintf(stderr, "Connection %d failed, its part of the file starts at byte %" PRId64 "\n",
+					worker->params.worker, worker->params.range_start);
+			else if (ok)
+				fprintf(stderr, "Connection %d failed, its part of the file starts at row %d\n",
+					worker->params.worker, worker->params.firstrow > 1 ? worker->params.firstrow : 1);
+			ok = FALSE;
+		}
+
+		if (ok && pdata->direction != DB_IN && !pdata->sflag)
+			ok = merge_parts(pdata, workers, n);
+
+		gettimeofday(&end, NULL);
+		elapsed = (double) (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+		printf("%d rows copied in %.3f seconds.\n", (int) total, elapsed);
+	}
+
+	for (i = 0; i < jobs; ++i) {
+		BCPPARAMDATA *params = &workers[i].params;
+
+		if (workers[i].dbproc)
+			dbclose(workers[i].dbproc);
+		if (params->errorfile != pdata->errorfile)
+			free(params->errorfile);
+		/* copying out each connection has its own query and file */
+		if (params->dbobject != pdata->dbobject)
+			free(params->dbobject);
+		if (params->hostfilename != pdata->hostfilename)
+			free(params->hostfilename);
+	}
+	free(workers);
+
+	return ok;
+}
+
 void
 pusage(void)
 {
@@ -774,22 +1355,58 @@ pusage(void)
 	fprintf(stderr, "        [-U username] [-P password] [-I interfaces_file] [-S server] [-D database]\n");
 	fprintf(stderr, "        [-v] [-d] [-h \"hint [,...]\" [-O \"set connection_option on|off, ...]\"\n");
 	fprintf(stderr, "        [-A packet size] [-T text or image size] [-E]\n");
-	fprintf(stderr, "        [-i input_file] [-o output_file]\n");
+	fprintf(stderr, "        [-i input_file] [-o output_file] [-j jobs] [-p partition_column] [-s]\n");
+	fprintf(stderr, "        [-J journal_file] [-R]\n");
 	fprintf(stderr, "        \n");
 	fprintf(stderr, "example: freebcp testdb.dbo.inserttest in inserttest.txt -S mssql -U guest -P password -c\n");
 }
 
+/* each connection copying in parallel keeps its own journal */
+static int
+set_journal(const BCPPARAMDATA *pdata, DBPROCESS *dbproc)
+{
+	char *name = pdata->journalfile;
+	int ok;
+
+	if (pdata->worker && asprintf(&name, "%s.%d", pdata->journalfile, pdata->worker) < 0) {
+		fprintf(stderr, "Out of memory!\n");
+		return FALSE;
+	}
+	ok = bcp_journal(dbproc, name, pdata->Rflag) != FAIL;
+	if (name != pdata->journalfile)
+		free(name);
+	return ok;
+}
+
+static int
+worker_number(DBPROCESS * dbproc)
+{
+	const BCPWORKER *worker;
+
+	if (!dbproc)
+		return 0;
+	worker = (const BCPWORKER *) dbgetuserdata(dbproc);
+	return worker ? worker->params.worker : 0;
+}
+
 int
 err_handler(DBPROCESS * dbproc, int severity, int dberr, int oserr TDS_UNUSED, char *dberrstr, char *oserrstr TDS_UNUSED)
 {
+	static tds_mutex sent_mtx = TDS_MUTEX_INITIALIZER;
 	static int sent = 0;
+	int worker = worker_number(dbproc);
 
 	if (dberr == SYBEBBCI) { /* Batch successfully bulk copied to the server */
 		int batch = bcp_getbatchsize(dbproc);
+		/* connections copying in parallel share the counter */
+		tds_mutex_lock(&sent_mtx);
 		printf("%d rows sent to SQL Server.\n", sent += batch);
+		tds_mutex_unlock(&sent_mtx);
 		return INT_CANCEL;
 	}
 
+	if (worker)
+		fprintf(stderr, "Connection %d: ", worker);
 	if (dberr) {
 		fprintf(stderr, "Msg %d, Level %d\n", dberr, severity);
 		fprintf(stderr, "%s\n\n", dberrstr);
@@ -802,9 +1419,11 @@ err_handler(DBPROCESS * dbproc, int severity, int dberr, int oserr TDS_UNUSED, c
 }
 
 int
-msg_handler(DBPROCESS * dbproc TDS_UNUSED, DBINT msgno, int msgstate, int severity,
+msg_handler(DBPROCESS * dbproc, DBINT msgno, int msgstate, int severity,
 	    char *msgtext, char *srvname, char *procname, int line)
 {
+	int worker;
+
 	/*
 	 * If it's a database change message, we'll ignore it.
 	 * Also ignore language change message.
@@ -812,6 +1431,9 @@ msg_handler(DBPROCESS * dbproc TDS_UNUSED, DBINT msgno, int msgstate, int severi
 	if (msgno == 5701 || msgno == 5703)
 		return (0);
 
+	worker = worker_number(dbproc);
+	if (worker)
+		fprintf(stderr, "Connection %d: ", worker);
 	fprintf(stderr, "Msg %ld, Level %d, State %d\n", (long) msgno, severity, msgstate);
 
 	if (strlen(srvname) > 0)
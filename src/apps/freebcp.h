@@ -68,7 +68,19 @@ typedef struct pd
 	int Tflag;
 	int Aflag;
 	int Eflag;
+	int jflag;
+	int jobs;
+	char *partkey;
+	int sflag;
+	/** worker number (1 based) copying a part of the file, 0 if not parallel */
+	int worker;
+	TDS_INT8 range_start;
+	TDS_INT8 range_end;
+	DBINT rows_copied;
 	char *inputfile;
 	char *outputfile;
+	/** journal of committed batches, see bcp_journal() */
+	char *journalfile;
+	int Rflag;
 }
 BCPPARAMDATA;
@@ -0,0 +1,356 @@
+/* FreeTDS - Library of routines accessing Sybase and Microsoft databases
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * This tests parallel copy out of freebcp, checking rows are
+ * split among part files by ranges of the partitioning key
+ */
+
+#undef NDEBUG
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+#if HAVE_STRING_H
+#include <string.h>
+#endif /* HAVE_STRING_H */
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <process.h>
+#define EXE_SUFFIX ".exe"
+#define SDIR_SEPARATOR "\\"
+#else
+#define EXE_SUFFIX ""
+#define SDIR_SEPARATOR "/"
+#endif
+
+#include <freetds/bool.h>
+#include <freetds/macros.h>
+
+static char USER[512];
+static char SERVER[512];
+static char PASSWORD[512];
+static char DATABASE[512];
+
+/* content of output file, from command executed */
+static char *output;
+
+static bool
+read_login_info(void)
+{
+	FILE *in = NULL;
+	char line[512];
+	char *s1, *s2;
+
+	s1 = getenv("TDSPWDFILE");
+	if (s1 && s1[0])
+		in = fopen(s1, "r");
+	if (!in)
+		in = fopen("../../../PWD", "r");
+	if (!in) {
+		fprintf(stderr, "Can not open PWD file\n\n");
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), in)) {
+		s1 = strtok(line, "=");
+		s2 = strtok(NULL, "\n");
+		if (!s1 || !s2) {
+			continue;
+		}
+		if (!strcmp(s1, "UID")) {
+			strcpy(USER, s2);
+		} else if (!strcmp(s1, "SRV")) {
+			strcpy(SERVER, s2);
+		} else if (!strcmp(s1, "PWD")) {
+			strcpy(PASSWORD, s2);
+		} else if (!strcmp(s1, "DB")) {
+			strcpy(DATABASE, s2);
+		}
+	}
+	fclose(in);
+	return true;
+}
+
+static void
+no_space(void)
+{
+	fprintf(stderr, "No space left on buffer\n");
+	exit(1);
+}
+
+/* read a file and output on a stream */
+static void
+cat(const char *fn, FILE *out)
+{
+	char line[1024];
+	FILE *f = fopen(fn, "r");
+	assert(f);
+	while (fgets(line, sizeof(line), f)) {
+		fputs("  ", out);
+		fputs(line, out);
+	}
+	fclose(f);
+}
+
+/* read a text file into memory, return it as a string */
+static char *
+read_file(const char *fn)
+{
+	long pos;
+	char *buf;
+	size_t readed;
+
+	FILE *f = fopen(fn, "r");
+	assert(f);
+	assert(fseek(f, 0, SEEK_END) == 0);
+	pos = ftell(f);
+	assert(pos >= 0);
+	assert(fseek(f, 0, SEEK_SET) == 0);
+	buf = malloc(pos + 10); /* allocate some more space */
+	assert(buf);
+	readed = fread(buf, 1, pos+1, f);
+	assert(readed <= pos);
+	assert(feof(f));
+	fclose(f);
+	buf[readed] = 0;
+	return buf;
+}
+
+#define CHECK(n) do {\
+	if (dest + (n) > dest_end) \
+		no_space(); \
+} while(0)
+
+static char *
+quote_arg(char *dest, char *dest_end, const char *arg)
+{
+#ifndef _WIN32
+	CHECK(1);
+	*dest++ = '\'';
+	for (; *arg; ++arg) {
+		if (*arg == '\'') {
+			CHECK(3);
+			strcpy(dest, "'\\'");
+			dest += 3;
+		}
+		CHECK(1);
+		*dest++ = *arg;
+	}
+	CHECK(1);
+	*dest++ = '\'';
+#else
+	CHECK(1);
+	*dest++ = '\"';
+	for (; *arg; ++arg) {
+		if (*arg == '\\' || *arg == '\"') {
+			CHECK(1);
+			*dest++ = '\\';
+		}
+		CHECK(1);
+		*dest++ = *arg;
+	}
+	CHECK(1);
+	*dest++ = '\"';
+#endif
+	return dest;
+}
+
+static char *
+add_string(char *dest, char *const dest_end, const char *str)
+{
+	size_t len = strlen(str);
+	CHECK(len);
+	memcpy(dest, str, len);
+	return dest + len;
+}
+
+#undef CHECK
+
+static char *
+add_server(char *dest, char *const dest_end)
+{
+	dest = add_string(dest, dest_end, " -S ");
+	dest = quote_arg(dest, dest_end, SERVER);
+	dest = add_string(dest, dest_end, " -U ");
+	dest = quote_arg(dest, dest_end, USER);
+	dest = add_string(dest, dest_end, " -P ");
+	dest = quote_arg(dest, dest_end, PASSWORD);
+	if (DATABASE[0]) {
+		dest = add_string(dest, dest_end, " -D ");
+		dest = quote_arg(dest, dest_end, DATABASE);
+	}
+	return dest;
+}
+
+static void
+cleanup(void)
+{
+	char name[32];
+	int i;
+
+	for (i = 1; i <= 8; ++i) {
+		sprintf(name, "parts.%d", i);
+		unlink(name);
+	}
+	unlink("parts");
+	unlink("output");
+	unlink("input");
+	TDS_ZERO_FREE(output);
+}
+
+static void
+tsql(const char *input_data)
+{
+	char cmd[2048];
+	char *const end = cmd + sizeof(cmd) - 1;
+	char *p;
+	FILE *f;
+
+	f = fopen("input", "w");
+	assert(f);
+	fputs(input_data, f);
+	fclose(f);
+
+	strcpy(cmd, ".." SDIR_SEPARATOR "tsql" EXE_SUFFIX " -o q");
+	p = strchr(cmd, 0);
+	p = add_server(p, end);
+	p = add_string(p, end, "<input >output");
+	*p = 0;
+	printf("Executing: %s\n", cmd);
+	if (system(cmd) != 0) {
+		printf("Output is:\n");
+		cat("output", stdout);
+		fprintf(stderr, "Failed command\n");
+		exit(1);
+	}
+	TDS_ZERO_FREE(output);
+	output = read_file("output");
+}
+
+static void
+freebcp_out(const char *table, int jobs)
+{
+	char cmd[2048], buf[64];
+	char *const end = cmd + sizeof(cmd) - 1;
+	char *p;
+
+	strcpy(cmd, ".." SDIR_SEPARATOR "freebcp" EXE_SUFFIX " ");
+	p = strchr(cmd, 0);
+	p = quote_arg(p, end, table);
+	sprintf(buf, " out parts -c -s -p id -j %d", jobs);
+	p = add_string(p, end, buf);
+	p = add_server(p, end);
+	p = add_string(p, end, " >output");
+	*p = 0;
+	printf("Executing: %s\n", cmd);
+	if (system(cmd) != 0) {
+		printf("Output is:\n");
+		cat("output", stdout);
+		fprintf(stderr, "Failed command\n");
+		exit(1);
+	}
+}
+
+/* check number of rows in part files, -1 if part should not exist */
+static void
+check_parts(const int *expected, int num_parts)
+{
+	char name[32];
+	int i;
+
+	for (i = 0; i < num_parts; ++i) {
+		FILE *f;
+		char *p;
+		int rows = 0;
+
+		sprintf(name, "parts.%d", i + 1);
+		if (expected[i] < 0) {
+			f = fopen(name, "r");
+			if (f) {
+				fclose(f);
+				fprintf(stderr, "File %s should not exist\n", name);
+				exit(1);
+			}
+			continue;
+		}
+		TDS_ZERO_FREE(output);
+		output = read_file(name);
+		for (p = output; *p; ++p)
+			if (*p == '\n')
+				++rows;
+		if (rows != expected[i]) {
+			fprintf(stderr, "File %s has %d rows, expected %d\n", name, rows, expected[i]);
+			exit(1);
+		}
+	}
+}
+
+/* fill table with keys from first to last */
+static void
+create_table(int first, int last)
+{
+	char sql[1024];
+
+	sprintf(sql,
+		"IF OBJECT_ID('freebcp_parts') IS NOT NULL DROP TABLE freebcp_parts\n"
+		"GO\n"
+		"CREATE TABLE freebcp_parts(id INT NOT NULL, name VARCHAR(20) NOT NULL)\n"
+		"GO\n"
+		"DECLARE @i INT\n"
+		"SET @i = %d\n"
+		"WHILE @i <= %d\n"
+		"BEGIN\n"
+		"  INSERT INTO freebcp_parts VALUES(@i, 'row ' + CONVERT(VARCHAR(10), @i))\n"
+		"  SET @i = @i + 1\n"
+		"END\n", first, last);
+	tsql(sql);
+}
+
+int main(void)
+{
+	/* keys 10-19 in 4 parts */
+	static const int expected_wide[] = { 2, 3, 2, 3, -1 };
+	/* only 3 keys, parts are reduced to 3, one key each */
+	static const int expected_small[] = { 1, 1, 1, -1 };
+
+	cleanup();
+
+	if (!read_login_info())
+		return 1;
+
+	create_table(10, 19);
+	freebcp_out("freebcp_parts", 4);
+	check_parts(expected_wide, 5);
+	cleanup();
+
+	create_table(1, 3);
+	freebcp_out("freebcp_parts", 4);
+	check_parts(expected_small, 4);
+
+	tsql("IF OBJECT_ID('freebcp_parts') IS NOT NULL DROP TABLE freebcp_parts\n");
+
+	cleanup();
+	return 0;
+}
@@ -56,6 +56,12 @@ static int _ct_fill_param(CS_INT cmd_type, CS_PARAM * param, const CS_DATAFMT_LA
 static void _ct_initialise_cmd(CS_COMMAND *cmd);
 static CS_RETCODE _ct_cancel_cleanup(CS_COMMAND * cmd);
 static CS_INT _ct_map_compute_op(CS_INT comp_op);
+static int _ct_bind_column(CS_CONTEXT *ctx, TDSCOLUMN *curcol, TDSCOLUMN *bindcol, CS_INT offset);
+static CS_BIND_PLAN *_ct_bind_plan_get(CS_COMMAND *cmd, TDSRESULTINFO *resinfo);
+static void _ct_bind_plan_free(CS_COMMAND *cmd);
+static void _ct_bind_plan_redirect(CS_BIND_PLAN *plan, CS_INT offset);
+static void _ct_bind_plan_restore(TDSSOCKET *tds, CS_BIND_PLAN *plan);
+static int _ct_bind_plan_data(CS_CONTEXT *ctx, CS_BIND_PLAN *plan, CS_INT offset);
 
 /* Added for CT_DIAG */
 /* Code changes starts here - CT_DIAG - 01 */
@@ -78,6 +84,10 @@ static TDSPARAMINFO *paraminfoalloc(TDSSOCKET * tds, CS_PARAM * first_param);
 
 static CS_DYNAMIC * _ct_allocate_dynamic(CS_CONNECTION * con, char *id, int idlen);
 static CS_INT  _ct_deallocate_dynamic(CS_CONNECTION * con, CS_DYNAMIC *dyn);
+static void _ct_stmt_cache_lookup(CS_CONNECTION * con, CS_DYNAMIC *dyn);
+static void _ct_stmt_cache_add(CS_CONNECTION * con, CS_DYNAMIC *dyn);
+static bool _ct_stmt_cache_has(CS_CONNECTION * con, TDSDYNAMIC *tdsdyn);
+static void _ct_stmt_cache_trim(CS_CONNECTION * con, CS_INT size, bool unprepare);
 static CS_DYNAMIC * _ct_locate_dynamic(CS_CONNECTION * con, char *id, int idlen);
 
 /* RPC Code changes ends here */
@@ -593,6 +603,15 @@ ct_con_props(CS_CONNECTION * con, CS_INT action, CS_INT property, CS_VOID * buff
 		case CS_SEC_DELEGATION:
 		        tds_login->gssapi_use_delegation = !!(*(CS_INT *) buffer);
 			break;
+		case CS_STMT_CACHE_SIZE:
+			memcpy(&intval, buffer, sizeof(intval));
+			if (intval < 0) {
+				_ctclient_msg(NULL, con, "ct_con_props(SET,STMT_CACHE_SIZE)", 1, 1, 1, 5, "%d, %s", intval, "buffer");
+				return CS_FAIL;
+			}
+			con->stmt_cache.size = intval;
+			_ct_stmt_cache_trim(con, intval, true);
+			break;
 		default:
 			tdsdump_log(TDS_DBG_ERROR, "Unknown property %d\n", property);
 			break;
@@ -732,6 +751,19 @@ ct_con_props(CS_CONNECTION * con, CS_INT action, CS_INT property, CS_VOID * buff
 		case CS_ENDPOINT:
 			*(CS_INT *) buffer = tds_get_s(con->tds_socket);
 			break;
+		case CS_STMT_CACHE_SIZE:
+		case CS_STMT_CACHE_HITS:
+		case CS_STMT_CACHE_MISSES:
+			if (property == CS_STMT_CACHE_SIZE)
+				intval = con->stmt_cache.size;
+			else if (property == CS_STMT_CACHE_HITS)
+				intval = con->stmt_cache.hits;
+			else
+				intval = con->stmt_cache.misses;
+			memcpy(buffer, &intval, sizeof(intval));
+			if (out_len)
+				*out_len = sizeof(intval);
+			break;
 		default:
 			tdsdump_log(TDS_DBG_ERROR, "Unknown property %d\n", property);
 			break;
@@ -811,6 +843,7 @@ ct_connect(CS_CONNECTION * con, CS_CHAR * servername, CS_INT snamelen)
 			locale->datetime_fmt = strdup(con->locale->time);
 			if (!locale->datetime_fmt)
 				goto Cleanup;
+			tds_locale_compile_formats(locale);
 		}
 		/* TODO how to handle this?
 		if (con->locale->collate) {
@@ -1060,7 +1093,19 @@ ct_send(CS_COMMAND * cmd)
 
 		switch (cmd->dynamic_cmd) {
 		case CS_PREPARE:
-			if (TDS_FAILED(tds_submit_prepare(tds, dyn->stmt, dyn->id, &dyn->tdsdyn, NULL)))
+			/* found in statement cache, already prepared on server */
+			if (dyn->tdsdyn) {
+				tds_set_cur_dyn(tds, dyn->tdsdyn);
+				cmd->results_state = _CS_RES_CMD_SUCCEED;
+				ct_set_command_state(cmd, _CS_COMMAND_SENT);
+				return CS_SUCCEED;
+			}
+			/*
+			 * Cached statements can outlive their client id so let
+			 * libTDS generate a unique server one.
+			 */
+			if (TDS_FAILED(tds_submit_prepare(tds, dyn->stmt, cmd->con->stmt_cache.size > 0 ? NULL : dyn->id,
+							  &dyn->tdsdyn, NULL)))
 				return CS_FAIL;
 			ct_set_command_state(cmd, _CS_COMMAND_SENT);
 			return CS_SUCCEED;
@@ -1104,6 +1149,12 @@ ct_send(CS_COMMAND * cmd)
 				tdsdump_log(TDS_DBG_INFO1, "ct_send(CS_DEALLOC) no tdsdyn!\n");
 				return CS_FAIL;
 			}
+			/* still cached or shared with other statements, keep it on server */
+			if (_ct_stmt_cache_has(cmd->con, tdsdyn) || tdsdyn->ref_count > 2) {
+				cmd->results_state = _CS_RES_CMD_SUCCEED;
+				ct_set_command_state(cmd, _CS_COMMAND_SENT);
+				return CS_SUCCEED;
+			}
 			if (TDS_FAILED(tds_submit_unprepare(tds, tdsdyn)))
 				return CS_FAIL;
 
@@ -1300,6 +1351,7 @@ ct_results(CS_COMMAND * cmd, CS_INT * result_type)
 		return CS_FAIL;
 
 	cmd->bind_count = CS_UNUSED;
+	_ct_bind_plan_free(cmd);
 
 	context = cmd->con->ctx;
 
@@ -1356,6 +1408,11 @@ ct_results(CS_COMMAND * cmd, CS_INT * result_type)
 		tdsdump_log(TDS_DBG_FUNC, "ct_results() process_result_tokens returned %d (type %d) \n",
 			    tdsret, res_type);
 
+		if (tdsret == TDS_SUCCESS && cmd->command_type == CS_DYNAMIC_CMD && cmd->dynamic_cmd == CS_PREPARE
+		    && cmd->dyn && (done_flags & TDS_DONE_ERROR)
+		    && (res_type == TDS_DONE_RESULT || res_type == TDS_DONEPROC_RESULT || res_type == TDS_DONEINPROC_RESULT))
+			cmd->dyn->prepare_failed = true;
+
 		switch (tdsret) {
 
 		case TDS_SUCCESS:
@@ -1620,6 +1677,9 @@ ct_results(CS_COMMAND * cmd, CS_INT * result_type)
 				_ct_deallocate_dynamic(cmd->con, cmd->dyn);
 				cmd->dyn = NULL;
 			}
+			if (cmd->command_type == CS_DYNAMIC_CMD &&
+				cmd->dynamic_cmd  == CS_PREPARE)
+				_ct_stmt_cache_add(cmd->con, cmd->dyn);
 			return CS_END_RESULTS;
 			break;
 
@@ -1683,6 +1743,9 @@ ct_bind(CS_COMMAND * cmd, CS_INT item, CS_DATAFMT * datafmt_arg, CS_VOID * buffe
 		}
 	}
 
+	/* bindings changed, plan must be computed again */
+	_ct_bind_plan_free(cmd);
+
 	/* bind the column_varaddr to the address of the buffer */
 
 	colinfo = resinfo->columns[item - 1];
@@ -1708,6 +1771,8 @@ ct_fetch(CS_COMMAND * cmd, CS_INT type, CS_INT offset, CS_INT option, CS_INT * p
 	TDS_INT temp_count;
 	TDSSOCKET *tds;
 	CS_INT rows_read_dummy;
+	CS_BIND_PLAN *plan = NULL;
+	int bind_failed;
 
 	tdsdump_log(TDS_DBG_FUNC, "ct_fetch(%p, %d, %d, %d, %p)\n", cmd, type, offset, option, prows_read);
 
@@ -1769,11 +1834,24 @@ ct_fetch(CS_COMMAND * cmd, CS_INT type, CS_INT offset, CS_INT option, CS_INT * p
 
 	/* Array Binding Code changes start here */
 
+	/*
+	 * For array binding compute once how every column is transferred,
+	 * fixed size columns are then read directly into the bound arrays.
+	 */
+	if (cmd->bind_count > 1 && cmd->curr_result_type == CS_ROW_RESULT)
+		plan = _ct_bind_plan_get(cmd, tds->current_results);
+
 	for (temp_count = 0; temp_count < cmd->bind_count; temp_count++) {
 
+		if (plan)
+			_ct_bind_plan_redirect(plan, temp_count);
+
 		ret = tds_process_tokens(tds, &ret_type, NULL,
 					 TDS_STOPAT_ROWFMT|TDS_STOPAT_DONE|TDS_RETURN_ROW|TDS_RETURN_COMPUTE);
 
+		if (plan)
+			_ct_bind_plan_restore(tds, plan);
+
 		tdsdump_log(TDS_DBG_FUNC, "inside ct_fetch() process_row_tokens returned %d\n", ret);
 
 		switch (ret) {
@@ -1781,7 +1859,12 @@ ct_fetch(CS_COMMAND * cmd, CS_INT type, CS_INT offset, CS_INT option, CS_INT * p
 				if (ret_type == TDS_ROW_RESULT || ret_type == TDS_COMPUTE_RESULT) {
 					cmd->get_data_item = 0;
 					cmd->get_data_bytes_returned = 0;
-					if (_ct_bind_data(cmd->con->ctx, tds->current_results, tds->current_results, temp_count))
+					if (plan && plan->resinfo && plan->resinfo == tds->current_results)
+						bind_failed = _ct_bind_plan_data(cmd->con->ctx, plan, temp_count);
+					else
+						bind_failed = _ct_bind_data(cmd->con->ctx, tds->current_results,
+									    tds->current_results, temp_count);
+					if (bind_failed)
 						return CS_ROW_FAIL;
 					(*prows_read)++;
 					break;
@@ -1907,93 +1990,272 @@ _ct_fetch_cursor(CS_COMMAND * cmd, CS_INT type, CS_INT offset, CS_INT option, CS
 int
 _ct_bind_data(CS_CONTEXT *ctx, TDSRESULTINFO * resinfo, TDSRESULTINFO *bindinfo, CS_INT offset)
 {
-	TDSCOLUMN *curcol, *bindcol;
-	unsigned char *src, *dest;
 	int i, result = 0;
+
+	tdsdump_log(TDS_DBG_FUNC, "_ct_bind_data(%p, %p, %p, %d)\n", ctx, resinfo, bindinfo, offset);
+
+	for (i = 0; i < resinfo->num_cols; i++)
+		result |= _ct_bind_column(ctx, resinfo->columns[i], bindinfo->columns[i], offset);
+
+	return result;
+}
+
+/**
+ * Copy a single column of current row into the bound variable.
+ * @return 0 on success, 1 on conversion error
+ */
+static int
+_ct_bind_column(CS_CONTEXT *ctx, TDSCOLUMN *curcol, TDSCOLUMN *bindcol, CS_INT offset)
+{
+	unsigned char *src, *dest;
 	CS_DATAFMT_COMMON srcfmt, destfmt;
 	TDS_INT datalen_dummy, *pdatalen;
 	TDS_SMALLINT nullind_dummy, *nullind;
+	CS_RETCODE ret;
+	CONV_RESULT convert_buffer;
+	CS_INT srctype;
 
-	tdsdump_log(TDS_DBG_FUNC, "_ct_bind_data(%p, %p, %p, %d)\n", ctx, resinfo, bindinfo, offset);
+	tdsdump_log(TDS_DBG_FUNC, "_ct_bind_data(): column is type %d and has length %d\n",
+					curcol->column_type, curcol->column_cur_size);
 
-	for (i = 0; i < resinfo->num_cols; i++) {
+	if (curcol->column_hidden)
+		return 0;
 
-		CS_RETCODE ret;
-		CONV_RESULT convert_buffer;
-		CS_INT srctype;
+	/*
+	 * Retrieve the initial bound column_varaddress and increment it if offset specified
+	 */
 
-		curcol = resinfo->columns[i];
-		bindcol = bindinfo->columns[i];
+	dest = (unsigned char *) bindcol->column_varaddr;
+	if (dest)
+		dest += offset * bindcol->column_bindlen;
 
-		tdsdump_log(TDS_DBG_FUNC, "_ct_bind_data(): column %d is type %d and has length %d\n",
-						i, curcol->column_type, curcol->column_cur_size);
+	nullind = &nullind_dummy;
+	if (bindcol->column_nullbind) {
+		nullind = bindcol->column_nullbind;
+		assert(nullind);
+		nullind += offset;
+	}
+	pdatalen = &datalen_dummy;
+	if (bindcol->column_lenbind) {
+		pdatalen = bindcol->column_lenbind;
+		assert(pdatalen);
+		pdatalen += offset;
+	}
 
-		if (curcol->column_hidden)
-			continue;
+	/* no destination specified */
+	if (!dest) {
+		*pdatalen = 0;
+		return 0;
+	}
 
-		/*
-		 * Retrieve the initial bound column_varaddress and increment it if offset specified
-		 */
+	/* NULL column */
+	if (curcol->column_cur_size < 0) {
+		*nullind = -1;
+		*pdatalen = 0;
+		return 0;
+	}
 
-		dest = (unsigned char *) bindcol->column_varaddr;
-		if (dest)
-			dest += offset * bindcol->column_bindlen;
+	src = curcol->column_data;
+	if (is_blob_col(curcol))
+		src = (unsigned char *) ((TDSBLOB *) src)->textvalue;
 
-		nullind = &nullind_dummy;
-		if (bindcol->column_nullbind) {
-			nullind = bindcol->column_nullbind;
-			assert(nullind);
-			nullind += offset;
-		}
-		pdatalen = &datalen_dummy;
-		if (bindcol->column_lenbind) {
-			pdatalen = bindcol->column_lenbind;
-			assert(pdatalen);
-			pdatalen += offset;
-		}
+	srctype = _cs_convert_not_client(ctx, curcol, &convert_buffer, &src);
+	if (srctype == CS_ILLEGAL_TYPE)
+		srctype = _ct_get_client_type(curcol, false);
+	if (srctype == CS_ILLEGAL_TYPE)
+		return 1;
+
+	srcfmt.datatype  = srctype;
+	srcfmt.maxlength = curcol->column_cur_size;
+
+	destfmt.datatype = bindcol->column_bindtype;
+	destfmt.maxlength = bindcol->column_bindlen;
+	destfmt.format = bindcol->column_bindfmt;
+
+	/* if convert return FAIL mark error but process other columns */
+	ret = _cs_convert(ctx, &srcfmt, src, &destfmt, dest, pdatalen, TDS_INVALID_TYPE);
+	*nullind = 0;
+	if (ret != CS_SUCCEED) {
+		tdsdump_log(TDS_DBG_FUNC, "cs_convert-result = %d\n", ret);
+		tdsdump_log(TDS_DBG_INFO1, "error: converted only %d bytes for type %d \n",
+						*pdatalen, srctype);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Get the array binding plan for given result set, computing it if needed.
+ * @return plan or NULL if no column can be read directly
+ */
+static CS_BIND_PLAN *
+_ct_bind_plan_get(CS_COMMAND *cmd, TDSRESULTINFO *resinfo)
+{
+	CS_BIND_PLAN *plan = cmd->bind_plan;
+	TDSCOLUMN *curcol;
+	int i, num_direct = 0;
+	TDS_INT size;
+
+	if (!resinfo)
+		return NULL;
+
+	if (plan && plan->resinfo == resinfo)
+		return plan;
+
+	_ct_bind_plan_free(cmd);
+
+	plan = tds_new0(CS_BIND_PLAN, 1);
+	if (!plan)
+		return NULL;
+	plan->direct_size = tds_new0(TDS_INT, resinfo->num_cols);
+	plan->saved_data = tds_new0(unsigned char *, resinfo->num_cols);
+	if (!plan->direct_size || !plan->saved_data) {
+		cmd->bind_plan = plan;
+		_ct_bind_plan_free(cmd);
+		return NULL;
+	}
+	plan->resinfo = resinfo;
+	cmd->bind_plan = plan;
+
+	for (i = 0; i < resinfo->num_cols; i++) {
+		curcol = resinfo->columns[i];
 
-		/* no destination specified */
-		if (!dest) {
-			*pdatalen = 0;
+		if (curcol->column_hidden || !curcol->column_varaddr || curcol->char_conv)
 			continue;
-		}
 
-		/* NULL column */
-		if (curcol->column_cur_size < 0) {
-			*nullind = -1;
-			*pdatalen = 0;
+		/* only fixed types decoded by the generic reader, same client type */
+		switch (tds_get_conversion_type(curcol->column_type, curcol->column_size)) {
+		case SYBINT1:
+		case SYBINT2:
+		case SYBINT4:
+		case SYBINT8:
+		case SYBREAL:
+		case SYBFLT8:
+		case SYBMONEY:
+		case SYBMONEY4:
+		case SYBDATETIME:
+		case SYBDATETIME4:
+		case SYBBIT:
+			break;
+		default:
 			continue;
 		}
+		if (curcol->column_bindtype != _ct_get_client_type(curcol, false))
+			continue;
 
-		src = curcol->column_data;
-		if (is_blob_col(curcol))
-			src = (unsigned char *) ((TDSBLOB *) src)->textvalue;
+		size = tds_get_size_by_type(tds_get_conversion_type(curcol->column_type, curcol->column_size));
+		if (size <= 0 || size != curcol->column_size || curcol->column_bindlen < size)
+			continue;
+
+		plan->direct_size[i] = size;
+		++num_direct;
+	}
+
+	tdsdump_log(TDS_DBG_FUNC, "_ct_bind_plan_get() %d of %d columns read directly\n", num_direct, resinfo->num_cols);
+
+	if (!num_direct) {
+		_ct_bind_plan_free(cmd);
+		return NULL;
+	}
+	return plan;
+}
+
+static void
+_ct_bind_plan_free(CS_COMMAND *cmd)
+{
+	CS_BIND_PLAN *plan = cmd->bind_plan;
+
+	if (!plan)
+		return;
+	free(plan->direct_size);
+	free(plan->saved_data);
+	free(plan);
+	cmd->bind_plan = NULL;
+}
+
+/**
+ * Point the direct columns to the slot of the bound arrays for the row
+ * we are going to read.
+ */
+static void
+_ct_bind_plan_redirect(CS_BIND_PLAN *plan, CS_INT offset)
+{
+	TDSRESULTINFO *resinfo = plan->resinfo;
+	TDSCOLUMN *curcol;
+	int i;
+
+	if (!resinfo)
+		return;
 
-		srctype = _cs_convert_not_client(ctx, curcol, &convert_buffer, &src);
-		if (srctype == CS_ILLEGAL_TYPE)
-			srctype = _ct_get_client_type(curcol, false);
-		if (srctype == CS_ILLEGAL_TYPE) {
-			result = 1;
+	for (i = 0; i < resinfo->num_cols; i++) {
+		if (!plan->direct_size[i])
 			continue;
-		}
+		curcol = resinfo->columns[i];
+		plan->saved_data[i] = curcol->column_data;
+		curcol->column_data = (unsigned char *) curcol->column_varaddr + offset * curcol->column_bindlen;
+	}
+}
+
+/**
+ * Restore row buffer pointers changed by _ct_bind_plan_redirect.
+ */
+static void
+_ct_bind_plan_restore(TDSSOCKET *tds, CS_BIND_PLAN *plan)
+{
+	TDSRESULTINFO *resinfo = plan->resinfo;
+	int i;
+
+	if (!resinfo)
+		return;
+
+	/* results were freed while reading, nothing to restore */
+	if (tds->res_info != resinfo) {
+		plan->resinfo = NULL;
+		return;
+	}
+
+	for (i = 0; i < resinfo->num_cols; i++)
+		if (plan->direct_size[i])
+			resinfo->columns[i]->column_data = plan->saved_data[i];
+}
 
-		srcfmt.datatype  = srctype;
-		srcfmt.maxlength = curcol->column_cur_size;
+/**
+ * Complete binding of a row read using a plan.
+ * Direct columns are already in place, only lengths and indicators are set.
+ * @return 0 on success, 1 if any column failed
+ */
+static int
+_ct_bind_plan_data(CS_CONTEXT *ctx, CS_BIND_PLAN *plan, CS_INT offset)
+{
+	TDSRESULTINFO *resinfo = plan->resinfo;
+	TDSCOLUMN *curcol;
+	TDS_INT size;
+	int i, result = 0;
 
-		destfmt.datatype = bindcol->column_bindtype;
-		destfmt.maxlength = bindcol->column_bindlen;
-		destfmt.format = bindcol->column_bindfmt;
+	tdsdump_log(TDS_DBG_FUNC, "_ct_bind_plan_data(%p, %p, %d)\n", ctx, plan, offset);
 
-		/* if convert return FAIL mark error but process other columns */
-		ret = _cs_convert(ctx, &srcfmt, src, &destfmt, dest, pdatalen, TDS_INVALID_TYPE);
-		if (ret != CS_SUCCEED) {
-			tdsdump_log(TDS_DBG_FUNC, "cs_convert-result = %d\n", ret);
-			result = 1;
-			tdsdump_log(TDS_DBG_INFO1, "error: converted only %d bytes for type %d \n",
-							*pdatalen, srctype);
+	for (i = 0; i < resinfo->num_cols; i++) {
+		curcol = resinfo->columns[i];
+		size = plan->direct_size[i];
+
+		if (!size) {
+			result |= _ct_bind_column(ctx, curcol, curcol, offset);
+			continue;
+		}
+
+		/* unexpected size from server, move data to row and convert as usual */
+		if (curcol->column_cur_size >= 0 && curcol->column_cur_size != size) {
+			memcpy(curcol->column_data,
+			       (unsigned char *) curcol->column_varaddr + offset * curcol->column_bindlen,
+			       curcol->column_cur_size);
+			result |= _ct_bind_column(ctx, curcol, curcol, offset);
+			continue;
 		}
 
-		*nullind = 0;
+		if (curcol->column_lenbind)
+			curcol->column_lenbind[offset] = curcol->column_cur_size < 0 ? 0 : size;
+		if (curcol->column_nullbind)
+			curcol->column_nullbind[offset] = curcol->column_cur_size < 0 ? -1 : 0;
 	}
 	return result;
 }
@@ -2017,6 +2279,7 @@ ct_cmd_drop(CS_COMMAND * cmd)
 			free(cmd->rpc);
 		}
 		free(cmd->iodesc);
+		_ct_bind_plan_free(cmd);
 
 		/* now remove this command from the list of commands in the connection */
 		con = cmd->con;
@@ -2045,6 +2308,8 @@ ct_close(CS_CONNECTION * con, CS_INT option)
 {
 	tdsdump_log(TDS_DBG_FUNC, "ct_close(%p, %d)\n", con, option);
 
+	/* prepared statements do not survive the connection */
+	_ct_stmt_cache_trim(con, 0, false);
 	tds_close_socket(con->tds_socket);
 	tds_free_socket(con->tds_socket);
 	con->tds_socket = NULL;
@@ -2071,6 +2336,7 @@ ct_con_drop(CS_CONNECTION * con)
 		}
 		while (con->dynlist)
 			_ct_deallocate_dynamic(con, con->dynlist);
+		_ct_stmt_cache_trim(con, 0, false);
 		if (con->locale)
 			_cs_locale_free(con->locale);
 		tds_free_socket(con->tds_socket);
@@ -3429,6 +3695,8 @@ ct_dynamic(CS_COMMAND * cmd, CS_INT type, CS_CHAR * id, CS_INT idlen, CS_CHAR *
 			return CS_FAIL;
 		}
 		dyn->stmt = tds_strndup(buffer, query_len);
+		if (dyn->stmt)
+			_ct_stmt_cache_lookup(con, dyn);
 
 		cmd->dyn = dyn;
 
@@ -4920,6 +5188,163 @@ _ct_deallocate_dynamic(CS_CONNECTION * con, CS_DYNAMIC *dyn)
 	return CS_SUCCEED;
 }
 
+/**
+ * Check dynamic is still prepared on the connection.
+ */
+static bool
+_ct_dynamic_alive(TDSSOCKET * tds, TDSDYNAMIC *tdsdyn)
+{
+	TDSDYNAMIC *curr;
+
+	if (!tds || IS_TDSDEAD(tds) || tdsdyn->defer_close)
+		return false;
+
+	for (curr = tds->conn->dyns; curr; curr = curr->next)
+		if (curr == tdsdyn)
+			return true;
+	return false;
+}
+
+/**
+ * Return the database currently in use on the connection.
+ * Statements refer to objects of this database so it is part of the cache key.
+ */
+static const char *
+_ct_stmt_cache_database(CS_CONNECTION * con)
+{
+	TDSSOCKET *tds = con->tds_socket;
+
+	if (!tds || !tds->conn->env.database)
+		return "";
+	return tds->conn->env.database;
+}
+
+/**
+ * Search the statement cache for a dynamic prepared with the same query
+ * in the current database.
+ * On success the libTDS dynamic is attached to dyn and no prepare is needed.
+ */
+static void
+_ct_stmt_cache_lookup(CS_CONNECTION * con, CS_DYNAMIC *dyn)
+{
+	CS_STMT_CACHE *cache = &con->stmt_cache;
+	CS_STMT_CACHE_ENTRY *entry, **pentry;
+	const char *database;
+
+	if (cache->size <= 0)
+		return;
+
+	database = _ct_stmt_cache_database(con);
+	for (pentry = &cache->entries; (entry = *pentry) != NULL; pentry = &entry->next) {
+		if (strcmp(entry->stmt, dyn->stmt) != 0 || strcmp(entry->database, database) != 0)
+			continue;
+
+		/* unlink, we either move it to front or discard it */
+		*pentry = entry->next;
+
+		if (!_ct_dynamic_alive(con->tds_socket, entry->tdsdyn)) {
+			tdsdump_log(TDS_DBG_INFO1, "_ct_stmt_cache_lookup() discarding stale entry\n");
+			--cache->count;
+			tds_release_dynamic(&entry->tdsdyn);
+			free(entry->stmt);
+			free(entry->database);
+			free(entry);
+			break;
+		}
+
+		entry->next = cache->entries;
+		cache->entries = entry;
+
+		++entry->tdsdyn->ref_count;
+		dyn->tdsdyn = entry->tdsdyn;
+		++cache->hits;
+		tdsdump_log(TDS_DBG_INFO1, "_ct_stmt_cache_lookup() hit, using dynamic %s\n", dyn->tdsdyn->id);
+		return;
+	}
+	++cache->misses;
+}
+
+/**
+ * Add a successfully prepared dynamic to the statement cache.
+ */
+static void
+_ct_stmt_cache_add(CS_CONNECTION * con, CS_DYNAMIC *dyn)
+{
+	CS_STMT_CACHE *cache = &con->stmt_cache;
+	CS_STMT_CACHE_ENTRY *entry;
+	TDSDYNAMIC *tdsdyn;
+
+	if (cache->size <= 0 || !dyn || !dyn->tdsdyn || dyn->prepare_failed)
+		return;
+
+	tdsdyn = dyn->tdsdyn;
+	if (_ct_stmt_cache_has(con, tdsdyn) || !_ct_dynamic_alive(con->tds_socket, tdsdyn))
+		return;
+	if (IS_TDS7_PLUS(con->tds_socket->conn) && !tdsdyn->num_id)
+		return;
+
+	entry = tds_new0(CS_STMT_CACHE_ENTRY, 1);
+	if (!entry)
+		return;
+	entry->stmt = strdup(dyn->stmt);
+	entry->database = strdup(_ct_stmt_cache_database(con));
+	if (!entry->stmt || !entry->database) {
+		free(entry->stmt);
+		free(entry->database);
+		free(entry);
+		return;
+	}
+	++tdsdyn->ref_count;
+	entry->tdsdyn = tdsdyn;
+
+	entry->next = cache->entries;
+	cache->entries = entry;
+	++cache->count;
+
+	_ct_stmt_cache_trim(con, cache->size, true);
+}
+
+static bool
+_ct_stmt_cache_has(CS_CONNECTION * con, TDSDYNAMIC *tdsdyn)
+{
+	CS_STMT_CACHE_ENTRY *entry;
+
+	for (entry = con->stmt_cache.entries; entry; entry = entry->next)
+		if (entry->tdsdyn == tdsdyn)
+			return true;
+	return false;
+}
+
+/**
+ * Evict least recently used statements till cache has at most size entries.
+ * Statements no more used by the client are unprepared when connection is idle.
+ */
+static void
+_ct_stmt_cache_trim(CS_CONNECTION * con, CS_INT size, bool unprepare)
+{
+	CS_STMT_CACHE *cache = &con->stmt_cache;
+	CS_STMT_CACHE_ENTRY *entry, **pentry;
+	TDSSOCKET *tds = con->tds_socket;
+
+	while (cache->count > size && cache->entries) {
+		for (pentry = &cache->entries; (*pentry)->next; pentry = &(*pentry)->next)
+			continue;
+		entry = *pentry;
+		*pentry = NULL;
+		--cache->count;
+
+		tdsdump_log(TDS_DBG_INFO1, "_ct_stmt_cache_trim() evicting dynamic %s\n", entry->tdsdyn->id);
+
+		/* only references are connection list and cache */
+		if (unprepare && entry->tdsdyn->ref_count == 2 && _ct_dynamic_alive(tds, entry->tdsdyn))
+			tds_deferred_unprepare(tds->conn, entry->tdsdyn);
+		tds_release_dynamic(&entry->tdsdyn);
+		free(entry->stmt);
+		free(entry->database);
+		free(entry);
+	}
+}
+
 static CS_INT
 _ct_map_compute_op(CS_INT comp_op)
 {
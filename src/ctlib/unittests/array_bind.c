@@ -23,6 +23,7 @@ main(void)
 	CS_CHAR select[1024];
 
 	CS_INT col1[2];
+	static const CS_INT expected_col1[] = { 1, 2, 3, 8, 9 };
 	CS_CHAR col2[2][5];
 	CS_CHAR col3[2][32];
 
@@ -100,9 +101,16 @@ main(void)
 					return 1;
 				} else {	/* ret == CS_SUCCEED */
 					printf("ct_fetch returned %d rows\n", count);
-					for (cv = 0; cv < count; cv++)
+					for (cv = 0; cv < count; cv++) {
 						printf("col1 = %d col2= '%s', col3 = '%s'\n", col1[cv], col2[cv],
 							col3[cv]);
+						/* int column is read directly into the array */
+						if (col1[cv] != expected_col1[row_count - count + cv]) {
+							fprintf(stderr, "wrong col1 %d on row %d\n", col1[cv],
+								row_count - count + cv);
+							return 1;
+						}
+					}
 				}
 				count = 0;
 			}
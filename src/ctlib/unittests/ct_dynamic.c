@@ -38,6 +38,17 @@ chk(int check, const char *fmt, ...)
 	exit(1);
 }
 
+static void
+check_results(CS_COMMAND *command)
+{
+	CS_RETCODE ret;
+	CS_INT res_type;
+
+	while ((ret = ct_results(command, &res_type)) == CS_SUCCEED)
+		chk(res_type == CS_CMD_SUCCEED || res_type == CS_CMD_DONE, "invalid ct_results result type: %d\n", res_type);
+	chk(ret == CS_END_RESULTS, "ct_results() unexpected return.\n", (int) ret);
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -298,6 +309,29 @@ main(int argc, char *argv[])
 	}
 	chk(ret == CS_END_RESULTS, "ct_results() unexpected return.\n", (int) ret);
 
+	/*
+	 * check statement cache reuses a statement deallocated by the client
+	 */
+	intvar = 4;
+	check_call(ct_con_props, (conn, CS_SET, CS_STMT_CACHE_SIZE, &intvar, CS_UNUSED, NULL));
+	strcpy(cmdbuf, "select name from #ct_dynamic where cost > ?");
+	for (i = 0; i < 2; ++i) {
+		sprintf(name, "cached%d", i);
+		check_call(ct_dynamic, (cmd, CS_PREPARE, name, CS_NULLTERM, cmdbuf, CS_NULLTERM));
+		check_call(ct_send, (cmd));
+		check_results(cmd);
+
+		check_call(ct_dynamic, (cmd, CS_DEALLOC, name, CS_NULLTERM, NULL, CS_UNUSED));
+		check_call(ct_send, (cmd));
+		check_results(cmd);
+	}
+	check_call(ct_con_props, (conn, CS_GET, CS_STMT_CACHE_HITS, &intvar, CS_UNUSED, NULL));
+	chk(intvar == 1, "statement cache hits %d, expected 1\n", (int) intvar);
+	check_call(ct_con_props, (conn, CS_GET, CS_STMT_CACHE_MISSES, &intvar, CS_UNUSED, NULL));
+	chk(intvar == 1, "statement cache misses %d, expected 1\n", (int) intvar);
+	intvar = 0;
+	check_call(ct_con_props, (conn, CS_SET, CS_STMT_CACHE_SIZE, &intvar, CS_UNUSED, NULL));
+
 	/*
 	 * check we can prepare again dynamic with same name after deallocation
 	 */
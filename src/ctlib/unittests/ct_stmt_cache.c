@@ -0,0 +1,93 @@
+/*
+ * Test statement cache takes into account current database.
+ * A statement prepared in a database should not be reused after a USE.
+ */
+#include "common.h"
+
+static CS_CONTEXT *ctx;
+static CS_CONNECTION *conn;
+static CS_COMMAND *cmd;
+
+static void
+check_results(void)
+{
+	CS_RETCODE ret;
+	CS_INT res_type;
+
+	while ((ret = ct_results(cmd, &res_type)) == CS_SUCCEED) {
+		if (res_type != CS_CMD_SUCCEED && res_type != CS_CMD_DONE) {
+			fprintf(stderr, "invalid ct_results result type: %d\n", res_type);
+			exit(1);
+		}
+	}
+	if (ret != CS_END_RESULTS) {
+		fprintf(stderr, "ct_results() unexpected return %d\n", (int) ret);
+		exit(1);
+	}
+}
+
+/* prepare and deallocate a statement, statement is kept in the cache */
+static void
+prepare(void)
+{
+	check_call(ct_dynamic, (cmd, CS_PREPARE, "stmt", CS_NULLTERM, "select count(*) from sysobjects", CS_NULLTERM));
+	check_call(ct_send, (cmd));
+	check_results();
+
+	check_call(ct_dynamic, (cmd, CS_DEALLOC, "stmt", CS_NULLTERM, NULL, CS_UNUSED));
+	check_call(ct_send, (cmd));
+	check_results();
+}
+
+static void
+check_cache(CS_INT hits, CS_INT misses)
+{
+	CS_INT value;
+
+	check_call(ct_con_props, (conn, CS_GET, CS_STMT_CACHE_HITS, &value, CS_UNUSED, NULL));
+	if (value != hits) {
+		fprintf(stderr, "statement cache hits %d, expected %d\n", (int) value, (int) hits);
+		exit(1);
+	}
+	check_call(ct_con_props, (conn, CS_GET, CS_STMT_CACHE_MISSES, &value, CS_UNUSED, NULL));
+	if (value != misses) {
+		fprintf(stderr, "statement cache misses %d, expected %d\n", (int) value, (int) misses);
+		exit(1);
+	}
+}
+
+int
+main(void)
+{
+	CS_INT hits, misses, size = 4;
+
+	printf("%s: check statement cache and database changes\n", __FILE__);
+	check_call(try_ctlogin, (&ctx, &conn, &cmd, 0));
+
+	check_call(ct_con_props, (conn, CS_SET, CS_STMT_CACHE_SIZE, &size, CS_UNUSED, NULL));
+
+	/* start from a known database, statement could be already cached or not */
+	check_call(run_command, (cmd, "use master"));
+	prepare();
+	check_call(ct_con_props, (conn, CS_GET, CS_STMT_CACHE_HITS, &hits, CS_UNUSED, NULL));
+	check_call(ct_con_props, (conn, CS_GET, CS_STMT_CACHE_MISSES, &misses, CS_UNUSED, NULL));
+
+	/* same text in another database must be prepared again */
+	check_call(run_command, (cmd, "use tempdb"));
+	prepare();
+	check_cache(hits, misses + 1);
+
+	/* then reused in the same database */
+	prepare();
+	check_cache(hits + 1, misses + 1);
+
+	/* statement prepared in first database is still valid */
+	check_call(run_command, (cmd, "use master"));
+	prepare();
+	check_cache(hits + 2, misses + 1);
+
+	check_call(try_ctlogout, (ctx, conn, cmd, 0));
+
+	printf("Done.\n");
+	return 0;
+}
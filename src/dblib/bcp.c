@@ -43,6 +43,7 @@
 #include <freetds/tds.h>
 #include <freetds/iconv.h>
 #include <freetds/convert.h>
+#include <freetds/stream.h>
 #include <freetds/bytes.h>
 #include <freetds/utils/string.h>
 #include <freetds/encodings.h>
@@ -59,6 +60,9 @@
 #define MAX(a,b) ( (a) > (b) ? (a) : (b) )
 #endif
 
+/** size of buffers used to read and write host files */
+#define BCP_HOSTFILE_BUFSIZE 0x40000u
+
 #ifdef HAVE_FSEEKO
 typedef off_t offset_type;
 #elif defined(_WIN32) || defined(_WIN64)
@@ -78,6 +82,33 @@ typedef __int64 offset_type;
 typedef long offset_type;
 #endif
 
+/** buffered reader for host files */
+typedef struct
+{
+	FILE *file;
+	/** data read from file, valid from pos to len */
+	char *buf;
+	size_t pos, len, size;
+	/** file offset of buf[0] */
+	offset_type offset;
+	/** buffer for data converted to server encoding, reused between fields */
+	void *conv_buf;
+	size_t conv_size;
+} BCP_HOSTFILE;
+
+/** progress of a copy in, saved after every committed batch, see bcp_journal() */
+typedef struct
+{
+	/** offset of the first row not yet committed */
+	offset_type offset;
+	/** rows of host file read before offset, counted from range start */
+	int row;
+	/** rows committed */
+	DBINT rows;
+	/** batches committed */
+	int batch;
+} BCP_JOURNAL;
+
 static void _bcp_free_storage(DBPROCESS * dbproc);
 static void _bcp_free_columns(DBPROCESS * dbproc);
 static void _bcp_null_error(TDSBCPINFO *bcpinfo, int index, int offset);
@@ -86,7 +117,7 @@ static TDSRET _bcp_no_get_col_data(TDSBCPINFO *bcpinfo, TDSCOLUMN *bindcol, int
 
 static int rtrim(char *, int);
 static int rtrim_u16(uint16_t *str, int len, uint16_t space);
-static STATUS _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool skip);
+static STATUS _bcp_read_hostfile(DBPROCESS * dbproc, BCP_HOSTFILE * hostfile, bool *row_error, bool skip);
 static int _bcp_readfmt_colinfo(DBPROCESS * dbproc, char *buf, BCP_HOSTCOLINFO * ci);
 static int _bcp_get_term_var(const BYTE * pdata, const BYTE * term, int term_len);
 
@@ -582,12 +613,78 @@ bcp_control(DBPROCESS * dbproc, int field, DBINT value)
 	return SUCCEED;
 }
 
+/**
+ * \ingroup dblib_bcp
+ * \brief Restrict the part of the host file copied in.
+ *
+ * \param dbproc contains all information needed by db-lib to manage communications with the server.
+ * \param first_byte offset of the first row to read, must be the start of a row.
+ * \param end_byte rows starting at or after this offset are not read, 0 to read till end of file.
+ * \remarks This function is specific to FreeTDS.
+ *	Allows to load different parts of a file using multiple connections.
+ *	BCPFIRST and BCPLAST rows are counted from \a first_byte.
+ * \return SUCCEED or FAIL.
+ * \sa 	bcp_control(), bcp_exec(), bcp_init()
+ */
+RETCODE
+bcp_filerange(DBPROCESS * dbproc, DBBIGINT first_byte, DBBIGINT end_byte)
+{
+	tdsdump_log(TDS_DBG_FUNC, "bcp_filerange(%p, %" PRId64 ", %" PRId64 ")\n", dbproc, first_byte, end_byte);
+	CHECK_CONN(FAIL);
+	CHECK_PARAMETER(dbproc->bcpinfo, SYBEBCPI, FAIL);
+	CHECK_PARAMETER(dbproc->hostfileinfo, SYBEBIVI, FAIL);
+
+	if (first_byte < 0 || end_byte < 0 || (end_byte && end_byte < first_byte)) {
+		dbperror(dbproc, SYBEIFNB, 0);
+		return FAIL;
+	}
+	dbproc->hostfileinfo->range_start = first_byte;
+	dbproc->hostfileinfo->range_end = end_byte;
+	return SUCCEED;
+}
+
+/**
+ * \ingroup dblib_bcp
+ * \brief Keep a journal of the batches committed copying in.
+ *
+ * \param dbproc contains all information needed by db-lib to manage communications with the server.
+ * \param filename journal file, rewritten after every batch committed by bcp_exec(), NULL to disable.
+ * \param resume if TRUE and \a filename exists, continue a previous copy from the first row not committed.
+ * \remarks This function is specific to FreeTDS.
+ *	The journal records the host file offset after the last row committed,
+ *	the rows read and copied so far and the number of batches.
+ *	Rows are counted from the start of the file or of the range given to bcp_filerange(),
+ *	so BCPFIRST and BCPLAST keep their meaning when resuming.
+ *	Use BCPBATCH to commit more than once.
+ * \return SUCCEED or FAIL.
+ * \sa 	bcp_control(), bcp_exec(), bcp_filerange(), bcp_init()
+ */
+RETCODE
+bcp_journal(DBPROCESS * dbproc, const char *filename, int resume)
+{
+	char *name = NULL;
+
+	tdsdump_log(TDS_DBG_FUNC, "bcp_journal(%p, %s, %d)\n", dbproc, filename ? filename : "NULL", resume);
+	CHECK_CONN(FAIL);
+	CHECK_PARAMETER(dbproc->bcpinfo, SYBEBCPI, FAIL);
+	CHECK_PARAMETER(dbproc->hostfileinfo, SYBEBIVI, FAIL);
+
+	if (filename && (name = strdup(filename)) == NULL) {
+		dbperror(dbproc, SYBEMEM, errno);
+		return FAIL;
+	}
+	free(dbproc->hostfileinfo->journalfile);
+	dbproc->hostfileinfo->journalfile = name;
+	dbproc->hostfileinfo->journal_resume = name && resume;
+	return SUCCEED;
+}
+
 /*
  * \ingroup dblib_bcp
  * \brief Get BCP batch option
  * 
  * \param dbproc contains all information needed by db-lib to manage communications with the server.
- * \remarks This function is specific to FreeTDS.  
+ * \remarks This function is specific to FreeTDS.
  * 
  * \return the value that was set by bcp_control.
  * \sa 	bcp_batch(), bcp_control()
@@ -696,6 +793,48 @@ bcp_colptr(DBPROCESS * dbproc, BYTE * colptr, int table_column)
 	return SUCCEED;
 }
 
+/** 
+ * \ingroup dblib_bcp
+ * \brief Bind an array of host variables to a column, to send many rows with bcp_sendrows().
+ * 
+ * \param dbproc contains all information needed by db-lib to manage communications with the server.
+ * \param stride distance in bytes from a row to the next one, including any prefix or terminator.
+ *	Zero (the default) uses the same variable for all rows.
+ * \param table_column The 1-based column ordinal in the table.  
+ * \remarks Call after bcp_bind(), which resets the stride. Row \em n is read from
+ *	the bound address plus \em n * \a stride.
+ * \return SUCCEED or FAIL.
+ * \sa 	bcp_bind(), bcp_colptr(), bcp_sendrows() 
+ */
+RETCODE
+bcp_colstride(DBPROCESS * dbproc, DBINT stride, int table_column)
+{
+	TDSCOLUMN *curcol;
+
+	tdsdump_log(TDS_DBG_FUNC, "bcp_colstride(%p, %d, %d)\n", dbproc, stride, table_column);
+	CHECK_CONN(FAIL);
+	CHECK_PARAMETER(dbproc->bcpinfo, SYBEBCPI, FAIL);
+	CHECK_PARAMETER(dbproc->bcpinfo->bindinfo, SYBEBCPI, FAIL);
+
+	if (dbproc->bcpinfo->direction != DB_IN) {
+		dbperror(dbproc, SYBEBCPN, 0);
+		return FAIL;
+	}
+	if (table_column <= 0 || table_column > dbproc->bcpinfo->bindinfo->num_cols) {
+		dbperror(dbproc, SYBECNOR, 0);
+		return FAIL;
+	}
+	if (stride < 0) {
+		dbperror(dbproc, SYBEBCVLEN, 0);
+		return FAIL;
+	}
+
+	curcol = dbproc->bcpinfo->bindinfo->columns[table_column - 1];
+	curcol->bcp_stride = stride;
+
+	return SUCCEED;
+}
+
 
 /** 
  * \ingroup dblib_bcp
@@ -725,7 +864,7 @@ bcp_getl(LOGINREC * login)
  * - we need to make sure buffer is always at least a minimum bytes.
  */
 static int
-_bcp_convert_out(DBPROCESS * dbproc, TDSCOLUMN *curcol, BCP_HOSTCOLINFO *hostcol, TDS_UCHAR **p_data, const char *bcpdatefmt)
+_bcp_convert_out(DBPROCESS * dbproc, TDSCOLUMN *curcol, BCP_HOSTCOLINFO *hostcol, TDS_UCHAR **p_data, const TDSDATEFMT *bcpdatefmt)
 {
 	BYTE *src;
 	int srclen;
@@ -746,8 +885,7 @@ _bcp_convert_out(DBPROCESS * dbproc, TDSCOLUMN *curcol, BCP_HOSTCOLINFO *hostcol
 		TDSDATEREC when;
 
 		tds_datecrack(srctype, src, &when);
-		buflen = (int)tds_strftime((TDS_CHAR *)(*p_data), 256,
-					 bcpdatefmt, &when, 3);
+		buflen = (int)tds_datefmt_format(bcpdatefmt, (TDS_CHAR *)(*p_data), 256, &when, 3);
 	} else if (srclen == 0 && is_variable_type(curcol->column_type)
 		   && is_ascii_type(hostcol->datatype)) {
 		/*
@@ -776,16 +914,28 @@ _bcp_convert_out(DBPROCESS * dbproc, TDSCOLUMN *curcol, BCP_HOSTCOLINFO *hostcol
 	} else {
 		CONV_RESULT cr;
 
+		/*
+		 * Most values fit in our buffer (at least 256 bytes), try to
+		 * convert directly into it avoiding an allocation.
+		 */
+		buflen = -1;
+		if (is_ascii_type(hostcol->datatype)) {
+			cr.cc.c = (TDS_CHAR *) (*p_data);
+			cr.cc.len = 256;
+			buflen = tds_convert(dbproc->tds_socket->conn->tds_ctx, srctype, src, srclen, TDS_CONVERT_CHAR, &cr);
+		}
+
 		/*
 		 * For null columns, the above work to determine the output buffer size is moot,
 		 * because bcpcol->data_size is zero, so dbconvert() won't write anything,
 		 * and returns zero.
 		 */
-		buflen = tds_convert(dbproc->tds_socket->conn->tds_ctx, srctype, src, srclen, hostcol->datatype, (CONV_RESULT *) &cr);
-		if (buflen < 0)
+		if (buflen >= 0 && buflen <= 256) {
+			/* already converted */
+		} else if ((buflen = tds_convert(dbproc->tds_socket->conn->tds_ctx, srctype, src, srclen,
+					       hostcol->datatype, (CONV_RESULT *) &cr)) < 0) {
 			return buflen;
-
-		if (buflen >= 256) {
+		} else if (buflen >= 256) {
 			free(*p_data);
 			*p_data = (TDS_UCHAR *) cr.c;
 		} else {
@@ -888,7 +1038,8 @@ _bcp_exec_out(DBPROCESS * dbproc, DBINT * rows_copied)
 
 	int row_of_query;
 	int rows_written;
-	const char *bcpdatefmt;
+	const char *datefmt;
+	TDSDATEFMT *bcpdatefmt = NULL;
 	TDSRET tdsret;
 
 	tdsdump_log(TDS_DBG_FUNC, "_bcp_exec_out(%p, %p)\n", dbproc, rows_copied);
@@ -898,9 +1049,9 @@ _bcp_exec_out(DBPROCESS * dbproc, DBINT * rows_copied)
 	tds = dbproc->tds_socket;
 	assert(tds);
 
-	bcpdatefmt = getenv("FREEBCP_DATEFMT");
-	if (!bcpdatefmt)
-		bcpdatefmt = "%Y-%m-%d %H:%M:%S.%z";
+	datefmt = getenv("FREEBCP_DATEFMT");
+	if (!datefmt)
+		datefmt = "%Y-%m-%d %H:%M:%S.%z";
 
 	if (dbproc->bcpinfo->direction == DB_QUERYOUT ) {
 		if (TDS_FAILED(tds_submit_query(tds, tds_dstr_cstr(&dbproc->bcpinfo->tablename))))
@@ -928,7 +1079,9 @@ _bcp_exec_out(DBPROCESS * dbproc, DBINT * rows_copied)
 	/* allocate at least 256 bytes */
 	/* allocate data for buffer conversion */
 	data = tds_new(TDS_UCHAR, 256);
-	if (!data) {
+	/* parse date format once for all rows */
+	bcpdatefmt = tds_datefmt_compile(datefmt);
+	if (!data || !bcpdatefmt) {
 		dbperror(dbproc, SYBEMEM, errno);
 		goto Cleanup;
 	}
@@ -942,6 +1095,8 @@ _bcp_exec_out(DBPROCESS * dbproc, DBINT * rows_copied)
 		dbperror(dbproc, SYBEBCUO, errno);
 		goto Cleanup;
 	}
+	/* we write lot of small pieces, use a large buffer */
+	setvbuf(hostfile, NULL, _IOFBF, BCP_HOSTFILE_BUFSIZE);
 
 	/* fetch a row of data from the server */
 
@@ -955,7 +1110,7 @@ _bcp_exec_out(DBPROCESS * dbproc, DBINT * rows_copied)
 
 		/* skip rows outside of the firstrow/lastrow range, if specified */
 		if (dbproc->hostfileinfo->firstrow > row_of_query ||
-						      row_of_query > MAX(dbproc->hostfileinfo->lastrow, 0x7FFFFFFF))
+		    (dbproc->hostfileinfo->lastrow > 0 && row_of_query > dbproc->hostfileinfo->lastrow))
 			continue;
 
 		/* Go through the hostfile columns, finding those that relate to database columns. */
@@ -1017,6 +1172,7 @@ _bcp_exec_out(DBPROCESS * dbproc, DBINT * rows_copied)
 
 	*rows_copied = rows_written;
 	free(data);
+	tds_datefmt_free(bcpdatefmt);
 	return SUCCEED;
 
 write_error:
@@ -1026,9 +1182,142 @@ Cleanup:
 	if (hostfile)
 		fclose(hostfile);
 	free(data);
+	tds_datefmt_free(bcpdatefmt);
 	return FAIL;
 }
 
+/**
+ * Initialize buffered reader for an opened host file.
+ * \return false on memory error
+ */
+static bool
+_bcp_hostfile_init(BCP_HOSTFILE *hf, FILE *file)
+{
+	memset(hf, 0, sizeof(*hf));
+	hf->file = file;
+	hf->size = BCP_HOSTFILE_BUFSIZE;
+	hf->buf = tds_new(char, hf->size);
+	return hf->buf != NULL;
+}
+
+static void
+_bcp_hostfile_free(BCP_HOSTFILE *hf)
+{
+	free(hf->buf);
+	free(hf->conv_buf);
+	hf->buf = NULL;
+	hf->conv_buf = NULL;
+}
+
+/**
+ * Make sure at least \a need bytes are available in the buffer.
+ * \return false on end of file or error
+ */
+static bool
+_bcp_hostfile_fill(BCP_HOSTFILE *hf, size_t need)
+{
+	size_t readed;
+
+	while (hf->len - hf->pos < need) {
+		/* discard data already consumed */
+		if (hf->pos) {
+			memmove(hf->buf, hf->buf + hf->pos, hf->len - hf->pos);
+			hf->offset += hf->pos;
+			hf->len -= hf->pos;
+			hf->pos = 0;
+		}
+		if (hf->size < need) {
+			size_t size = MAX(hf->size * 2u, need);
+
+			if (!TDS_RESIZE(hf->buf, size))
+				return false;
+			hf->size = size;
+		}
+		readed = fread(hf->buf + hf->len, 1, hf->size - hf->len, hf->file);
+		if (!readed)
+			return false;
+		hf->len += readed;
+	}
+	return true;
+}
+
+/**
+ * Get next \a len bytes from host file.
+ * Returned data point into the read buffer and are valid till next read.
+ * \return pointer to data, NULL on end of file or error
+ */
+static const char *
+_bcp_hostfile_read(BCP_HOSTFILE *hf, size_t len)
+{
+	const char *p;
+
+	if (!_bcp_hostfile_fill(hf, len))
+		return NULL;
+	p = hf->buf + hf->pos;
+	hf->pos += len;
+	return p;
+}
+
+static offset_type
+_bcp_hostfile_tell(const BCP_HOSTFILE *hf)
+{
+	return hf->offset + (offset_type) hf->pos;
+}
+
+static bool
+_bcp_hostfile_seek(BCP_HOSTFILE *hf, offset_type pos)
+{
+	/* still in buffer ? */
+	if (pos >= hf->offset && pos <= hf->offset + (offset_type) hf->len) {
+		hf->pos = (size_t) (pos - hf->offset);
+		return true;
+	}
+	if (fseeko(hf->file, pos, SEEK_SET) != 0)
+		return false;
+	hf->offset = pos;
+	hf->pos = hf->len = 0;
+	return true;
+}
+
+/**
+ * Get next field from host file, up to given terminator.
+ * Returned data point into the read buffer and are valid till next read.
+ * \retval TDS_SUCCESS  success
+ * \retval TDS_FAIL     error reading the field or terminator not found
+ * \retval TDS_NO_MORE_RESULTS end of file detected
+ */
+static TDSRET
+_bcp_hostfile_field(BCP_HOSTFILE *hf, const char *term, size_t term_len, const char **field, size_t *field_len)
+{
+	size_t scanned = 0;
+
+	if (!_bcp_hostfile_fill(hf, term_len))
+		return hf->len == hf->pos && feof(hf->file) ? TDS_NO_MORE_RESULTS : TDS_FAIL;
+
+	for (;;) {
+		const char *start = hf->buf + hf->pos;
+		const char *p = start + scanned;
+		/* last position the terminator can start from */
+		const char *last = hf->buf + hf->len - term_len;
+
+		/* search first terminator byte with memchr, usually vectorized */
+		while (p <= last && (p = (const char *) memchr(p, term[0], last - p + 1)) != NULL) {
+			if (memcmp(p + 1, term + 1, term_len - 1) == 0) {
+				*field = start;
+				*field_len = p - start;
+				hf->pos += *field_len + term_len;
+				return TDS_SUCCESS;
+			}
+			++p;
+		}
+		scanned = last + 1 - start;
+
+		/* not found, read more data */
+		if (!_bcp_hostfile_fill(hf, hf->len - hf->pos + 1))
+			return TDS_FAIL;
+	}
+}
+
 static STATUS
 _bcp_check_eof(DBPROCESS * dbproc, FILE *file, int icol)
 {
@@ -1050,6 +1339,68 @@ _bcp_check_eof(DBPROCESS * dbproc, FILE *file, int icol)
 	return FAIL;
 }
 
+/**
+ * Check if data of a type can be copied as they are in a column of the same type.
+ * Numeric data must have the precision and scale of the column.
+ */
+static bool
+_bcp_same_format(TDS_SERVER_TYPE type, const TDS_CHAR *src, TDS_UINT srclen, const BCPCOLDATA *coldata)
+{
+	const TDS_NUMERIC *num;
+
+	if (type == SYBBIT)
+		return false;
+	if (!is_numeric_type(type))
+		return true;
+
+	num = (const TDS_NUMERIC *) coldata->data;
+	return srclen >= 2 && (TDS_UCHAR) src[0] == num->precision && (TDS_UCHAR) src[1] == num->scale
+		&& num->precision <= MAXPRECISION && srclen == tds_numeric_bytes_per_prec[num->precision] + 2u;
+}
+
+/**
+ * Copy data already in server format into bcp column.
+ */
+static TDSRET
+_bcp_copy_in(DBPROCESS *dbproc, const TDS_CHAR *src, TDS_UINT srclen, TDS_SERVER_TYPE desttype, BCPCOLDATA *coldata)
+{
+	coldata->is_null = false;
+	if ((TDS_INT) srclen > coldata->datasize) {
+		if (!TDS_RESIZE(coldata->data, srclen)) {
+			dbperror(dbproc, SYBEMEM, errno);
+			return TDS_FAIL;
+		}
+		coldata->datasize = srclen;
+	}
+	memcpy(coldata->data, src, srclen);
+	/* numeric are stored as TDS_NUMERIC like tds_convert does */
+	coldata->datalen = is_numeric_type(desttype) ? sizeof(TDS_NUMERIC) : srclen;
+	return TDS_SUCCESS;
+}
+
+/**
+ * Find host file columns having the type of the table column,
+ * data of these columns are copied without conversions.
+ */
+static void
+_bcp_passthrough_columns(DBPROCESS *dbproc)
+{
+	BCP_HOSTFILEINFO *hostfileinfo = dbproc->hostfileinfo;
+	int i;
+
+	for (i = 0; i < hostfileinfo->host_colcount; i++) {
+		BCP_HOSTCOLINFO *hostcol = hostfileinfo->host_columns[i];
+		TDSCOLUMN *bcpcol;
+
+		hostcol->passthrough = false;
+		if (hostcol->tab_colnum <= 0 || hostcol->tab_colnum > dbproc->bcpinfo->bindinfo->num_cols)
+			continue;
+		bcpcol = dbproc->bcpinfo->bindinfo->columns[hostcol->tab_colnum - 1];
+		hostcol->passthrough = hostcol->datatype == tds_get_conversion_type(bcpcol->column_type, bcpcol->column_size)
+			&& hostcol->datatype != SYBBIT;
+	}
+}
+
 /**
  * Convert column for input to a table
  */
@@ -1061,6 +1412,10 @@ _bcp_convert_in(DBPROCESS *dbproc, TDS_SERVER_TYPE srctype, const TDS_CHAR *src,
 	CONV_RESULT cr, *p_cr;
 	TDS_INT len;
 
+	/* same type, data can be copied as they are */
+	if (srctype == desttype && _bcp_same_format(desttype, src, srclen, coldata))
+		return _bcp_copy_in(dbproc, src, srclen, desttype, coldata);
+
 	coldata->is_null = false;
 
 	if (!is_variable_type(desttype)) {
@@ -1080,6 +1435,7 @@ _bcp_convert_in(DBPROCESS *dbproc, TDS_SERVER_TYPE srctype, const TDS_CHAR *src,
 	if (variable) {
 		free(coldata->data);
 		coldata->data = (TDS_UCHAR *) cr.c;
+		coldata->datasize = len;
 	}
 	return TDS_SUCCESS;
 }
@@ -1141,7 +1497,7 @@ rtrim_bcpcol(TDSCOLUMN *bcpcol)
  * \sa 	BCP_SETL(), bcp_batch(), bcp_bind(), bcp_colfmt(), bcp_colfmt_ps(), bcp_collen(), bcp_colptr(), bcp_columns(), bcp_control(), bcp_done(), bcp_exec(), bcp_getl(), bcp_init(), bcp_moretext(), bcp_options(), bcp_readfmt(), bcp_sendrow()
  */
 static STATUS
-_bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool skip)
+_bcp_read_hostfile(DBPROCESS * dbproc, BCP_HOSTFILE * hostfile, bool *row_error, bool skip)
 {
 	int i;
 
@@ -1155,7 +1511,7 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 	for (i = 0; i < dbproc->hostfileinfo->host_colcount; i++) {
 		TDSCOLUMN *bcpcol = NULL;
 		BCP_HOSTCOLINFO *hostcol;
-		TDS_CHAR *coldata;
+		const TDS_CHAR *coldata;
 		int collen = 0;
 		bool data_is_null = false;
 		offset_type col_start;
@@ -1194,20 +1550,25 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 				TDS_INT li;
 			} u;
 
+			const char *prefix;
+
 			switch (hostcol->prefix_len) {
 			case 1:
-				if (fread(&u.ti, 1, 1, hostfile) != 1)
-					return _bcp_check_eof(dbproc, hostfile, i);
+				if ((prefix = _bcp_hostfile_read(hostfile, 1)) == NULL)
+					return _bcp_check_eof(dbproc, hostfile->file, i);
+				memcpy(&u.ti, prefix, 1);
 				collen = u.ti ? u.ti : -1;
 				break;
 			case 2:
-				if (fread(&u.si, 2, 1, hostfile) != 1)
-					return _bcp_check_eof(dbproc, hostfile, i);
+				if ((prefix = _bcp_hostfile_read(hostfile, 2)) == NULL)
+					return _bcp_check_eof(dbproc, hostfile->file, i);
+				memcpy(&u.si, prefix, 2);
 				collen = u.si;
 				break;
 			case 4:
-				if (fread(&u.li, 4, 1, hostfile) != 1)
-					return _bcp_check_eof(dbproc, hostfile, i);
+				if ((prefix = _bcp_hostfile_read(hostfile, 4)) == NULL)
+					return _bcp_check_eof(dbproc, hostfile->file, i);
+				memcpy(&u.li, prefix, 4);
 				collen = u.li;
 				break;
 			default:
@@ -1242,7 +1603,7 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 		if (is_fixed_type(hostcol->datatype))
 			collen = tds_get_size_by_type(hostcol->datatype);
 
-		col_start = ftello(hostfile);
+		col_start = _bcp_hostfile_tell(hostfile);
 
 		/*
 		 * The data file either contains prefixes stating the length, or is delimited.  
@@ -1257,25 +1618,36 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 			 * Read and convert the data
 			 */
 			coldata = NULL;
-			conv_res = tds_bcp_fread(dbproc->tds_socket, bcpcol ? bcpcol->char_conv : NULL, hostfile,
-						 (const char *) hostcol->terminator, hostcol->term_len, &coldata, &col_bytes);
+			conv_res = _bcp_hostfile_field(hostfile, (const char *) hostcol->terminator, hostcol->term_len,
+						       &coldata, &col_bytes);
+			if (conv_res == TDS_SUCCESS && bcpcol && bcpcol->char_conv) {
+				TDSSTATICINSTREAM r;
+				TDSDYNAMICSTREAM w;
+
+				/* convert to server encoding reusing the same buffer */
+				tds_staticin_stream_init(&r, coldata, col_bytes);
+				conv_res = tds_dynamic_stream_init(&w, &hostfile->conv_buf, hostfile->conv_size);
+				if (TDS_SUCCEED(conv_res)) {
+					conv_res = tds_convert_stream(dbproc->tds_socket, bcpcol->char_conv, to_server,
+								      &r.stream, &w.stream);
+					hostfile->conv_size = w.allocated;
+					coldata = (const TDS_CHAR *) hostfile->conv_buf;
+					col_bytes = w.size;
+				}
+			}
 
 			if (TDS_FAILED(conv_res)) {
 				tdsdump_log(TDS_DBG_FUNC, "col %d: error converting %ld bytes!\n",
 							(i+1), (long) collen);
 				*row_error = true;
-				free(coldata);
 				dbperror(dbproc, SYBEBCOR, 0);
 				return FAIL;
 			}
 
-			if (conv_res == TDS_NO_MORE_RESULTS) {
-				free(coldata);
-				return _bcp_check_eof(dbproc, hostfile, i);
-			}
+			if (conv_res == TDS_NO_MORE_RESULTS)
+				return _bcp_check_eof(dbproc, hostfile->file, i);
 
 			if (col_bytes > 0x7fffffffl) {
-				free(coldata);
 				*row_error = true;
 				tdsdump_log(TDS_DBG_FUNC, "data from file is too large!\n");
 				dbperror(dbproc, SYBEBCOR, 0);
@@ -1297,29 +1669,19 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 			 */
 		} else {	/* unterminated field */
 
-			coldata = tds_new(TDS_CHAR, 1 + collen);
-			if (coldata == NULL) {
-				*row_error = true;
-				dbperror(dbproc, SYBEMEM, errno);
-				return FAIL;
-			}
-
-			coldata[collen] = 0;
+			coldata = "";
 			if (collen) {
 				/* 
-				 * Read and convert the data
-				 * TODO: Call tds_bcp_fread() instead of fread(3).
+				 * Read the data
+				 * TODO: Convert character data like delimited fields.
 				 *       The columns should each have their iconv cd set, and noncharacter data
-				 *       should have -1 as the iconv cd, causing tds_bcp_fread() to not attempt
-				 * 	 any conversion.  We do not need a datatype switch here to decide what to do.  
-				 *	 As of 0.62, this *should* actually work.  All that remains is to change the
-				 *	 call and test it. 
+				 *       should have -1 as the iconv cd, causing no conversion.
+				 *       We do not need a datatype switch here to decide what to do.  
 				 */
 				tdsdump_log(TDS_DBG_FUNC, "Reading %d bytes from hostfile.\n", collen);
-				if (fread(coldata, collen, 1, hostfile) != 1) {
-					free(coldata);
-					return _bcp_check_eof(dbproc, hostfile, i);
-				}
+				coldata = _bcp_hostfile_read(hostfile, collen);
+				if (!coldata)
+					return _bcp_check_eof(dbproc, hostfile->file, i);
 			}
 		}
 
@@ -1335,10 +1697,15 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 				TDSRET rc;
 				TDS_SERVER_TYPE desttype;
 
-				desttype = tds_get_conversion_type(bcpcol->column_type, bcpcol->column_size);
+				if (hostcol->passthrough
+				    && _bcp_same_format(hostcol->datatype, coldata, collen, bcpcol->bcp_column_data)) {
+					rc = _bcp_copy_in(dbproc, coldata, collen, hostcol->datatype, bcpcol->bcp_column_data);
+				} else {
+					desttype = tds_get_conversion_type(bcpcol->column_type, bcpcol->column_size);
 
-				rc = _bcp_convert_in(dbproc, hostcol->datatype, (const TDS_CHAR*) coldata, collen,
-						     desttype, bcpcol->bcp_column_data);
+					rc = _bcp_convert_in(dbproc, hostcol->datatype, (const TDS_CHAR*) coldata, collen,
+							     desttype, bcpcol->bcp_column_data);
+				}
 				if (TDS_FAILED(rc)) {
 					hostcol->column_error = HOST_COL_CONV_ERROR;
 					*row_error = true;
@@ -1362,7 +1729,6 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
 			}
 #endif
 		}
-		free(coldata);
 	}
 	return MORE_ROWS;
 }
@@ -1382,15 +1748,42 @@ _bcp_read_hostfile(DBPROCESS * dbproc, FILE * hostfile, bool *row_error, bool sk
  */
 RETCODE
 bcp_sendrow(DBPROCESS * dbproc)
+{
+	tdsdump_log(TDS_DBG_FUNC, "bcp_sendrow(%p)\n", dbproc);
+
+	return bcp_sendrows(dbproc, 1, NULL);
+}
+
+/** 
+ * \ingroup dblib_bcp
+ * \brief Write many rows to the server from arrays bound to the columns.
+ * 
+ * \param dbproc contains all information needed by db-lib to manage communications with the server.
+ * \param nrows number of rows to send, cannot be negative.
+ * \param rows_sent receives the number of rows sent successfully, can be NULL.
+ * 
+ * \remarks Same as calling bcp_sendrow() \a nrows times, moving every column
+ *	bound with bcp_colstride() to the next element each time.
+ *	Stops at the first row that cannot be sent.
+ * \return SUCCEED or FAIL.
+ * \sa 	bcp_batch(), bcp_bind(), bcp_colstride(), bcp_done(), bcp_sendrow()
+ */
+RETCODE
+bcp_sendrows(DBPROCESS * dbproc, DBINT nrows, DBINT * rows_sent)
 {
 	TDSSOCKET *tds;
+	DBINT row;
 
-	tdsdump_log(TDS_DBG_FUNC, "bcp_sendrow(%p)\n", dbproc);
+	tdsdump_log(TDS_DBG_FUNC, "bcp_sendrows(%p, %d, %p)\n", dbproc, nrows, rows_sent);
 	CHECK_CONN(FAIL);
 	CHECK_PARAMETER(dbproc->bcpinfo, SYBEBCPI, FAIL);
+	CHECK_PARAMETER(nrows >= 0, SYBEBCVLEN, FAIL);
 
 	tds = dbproc->tds_socket;
 
+	if (rows_sent)
+		*rows_sent = 0;
+
 	if (dbproc->bcpinfo->direction != DB_IN) {
 		dbperror(dbproc, SYBEBCPN, 0);
 		return FAIL;
@@ -1418,10 +1811,99 @@ bcp_sendrow(DBPROCESS * dbproc)
 	}
 
 	dbproc->bcpinfo->parent = dbproc;
-	return TDS_FAILED(tds_bcp_send_record(dbproc->tds_socket, dbproc->bcpinfo,
-			  _bcp_get_col_data, _bcp_null_error, 0)) ? FAIL : SUCCEED;
+	for (row = 0; row < nrows; ++row) {
+		if (TDS_FAILED(tds_bcp_send_record(tds, dbproc->bcpinfo, _bcp_get_col_data, _bcp_null_error, row)))
+			return FAIL;
+		if (rows_sent)
+			*rows_sent = row + 1;
+	}
+	return SUCCEED;
+}
+
+
+/**
+ * Read journal of a previous copy in, if we have to resume it.
+ * \return false if the journal is not valid
+ */
+static bool
+_bcp_journal_read(DBPROCESS * dbproc, BCP_JOURNAL * journal)
+{
+	BCP_HOSTFILEINFO *hfi = dbproc->hostfileinfo;
+	char line[128], *p, *end;
+	FILE *f;
+	TDS_INT8 offset;
+	long row, rows, batch;
+
+	memset(journal, 0, sizeof(*journal));
+	journal->offset = (offset_type) hfi->range_start;
+
+	if (!hfi->journal_resume)
+		return true;
+	/* no journal, nothing to resume */
+	if (!(f = fopen(hfi->journalfile, "r")))
+		return true;
+	p = fgets(line, sizeof(line), f);
+	fclose(f);
+	if (!p)
+		return false;
+
+	offset = tds_strtoll(p, &end, 10);
+	row = strtol(p = end, &end, 10);
+	rows = strtol(p = end, &end, 10);
+	batch = strtol(p = end, &end, 10);
+	if (p == end || (*end != '\n' && *end != 0)
+	    || offset < hfi->range_start || row < 0 || rows < 0 || rows > row || batch < 0)
+		return false;
+
+	journal->offset = (offset_type) offset;
+	journal->row = row;
+	journal->rows = rows;
+	journal->batch = batch;
+	tdsdump_log(TDS_DBG_INFO1, "resuming copy in from offset %" PRId64 " row %ld, %ld rows in %ld batches already copied\n",
+		    offset, row, rows, batch);
+	return true;
 }
 
+/**
+ * Save progress of copy in.
+ * A temporary file is renamed over the journal so a crash cannot leave it truncated.
+ * \return false on error
+ */
+static bool
+_bcp_journal_write(DBPROCESS * dbproc, const BCP_JOURNAL * journal)
+{
+	const char *filename = dbproc->hostfileinfo->journalfile;
+	char *tmp;
+	FILE *f;
+	bool ok;
+
+	if (!filename)
+		return true;
+
+	if (asprintf(&tmp, "%s.tmp", filename) < 0) {
+		dbperror(dbproc, SYBEMEM, errno);
+		return false;
+	}
+	ok = (f = fopen(tmp, "w")) != NULL;
+	if (ok) {
+		ok = fprintf(f, "%" PRId64 " %d %d %d\n", (TDS_INT8) journal->offset, journal->row,
+			     (int) journal->rows, journal->batch) > 0;
+		ok = (fclose(f) == 0) && ok;
+	}
+#ifdef _WIN32
+	/* rename does not replace existing files */
+	if (ok)
+		remove(filename);
+#endif
+	if (ok)
+		ok = rename(tmp, filename) == 0;
+	if (!ok) {
+		dbperror(dbproc, SYBEBCWE, errno);
+		remove(tmp);
+	}
+	free(tmp);
+	return ok;
+}
 
 /** 
  * \ingroup dblib_bcp_internal
@@ -1436,15 +1918,19 @@ bcp_sendrow(DBPROCESS * dbproc)
 static RETCODE
 _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 {
-	FILE *hostfile, *errfile = NULL;
+	FILE *errfile = NULL;
+	BCP_HOSTFILE hostfile;
 	TDSSOCKET *tds = dbproc->tds_socket;
 	BCP_HOSTCOLINFO *hostcol;
+	BCP_JOURNAL journal;
 	STATUS ret;
 
 	int i, row_of_hostfile, rows_written_so_far;
 	int row_error_count;
 	bool row_error;
 	offset_type row_start, row_end;
+	offset_type done_offset;
+	int done_row;
 	offset_type error_row_size;
 	const size_t chunk_size = 0x20000u;
 	
@@ -1454,18 +1940,45 @@ _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 
 	*rows_copied = 0;
 	
-	if (!(hostfile = fopen(dbproc->hostfileinfo->hostfile, "r"))) {
+	if (!(hostfile.file = fopen(dbproc->hostfileinfo->hostfile, "r"))) {
 		dbperror(dbproc, SYBEBCUO, 0);
 		return FAIL;
 	}
 
+	if (!_bcp_hostfile_init(&hostfile, hostfile.file)) {
+		fclose(hostfile.file);
+		_bcp_hostfile_free(&hostfile);
+		dbperror(dbproc, SYBEMEM, errno);
+		return FAIL;
+	}
+
+	if (!_bcp_journal_read(dbproc, &journal)) {
+		fclose(hostfile.file);
+		_bcp_hostfile_free(&hostfile);
+		dbperror(dbproc, SYBEBCRE, 0);
+		return FAIL;
+	}
+
+	if (journal.offset && !_bcp_hostfile_seek(&hostfile, journal.offset)) {
+		fclose(hostfile.file);
+		_bcp_hostfile_free(&hostfile);
+		dbperror(dbproc, SYBEBCRE, errno);
+		return FAIL;
+	}
+
 	if (TDS_FAILED(tds_bcp_start_copy_in(tds, dbproc->bcpinfo))) {
-		fclose(hostfile);
+		fclose(hostfile.file);
+		_bcp_hostfile_free(&hostfile);
 		return FAIL;
 	}
 
-	row_of_hostfile = 0;
+	_bcp_passthrough_columns(dbproc);
+
+	/* when resuming rows already read still count for BCPFIRST and BCPLAST */
+	row_of_hostfile = journal.row;
 	rows_written_so_far = 0;
+	done_offset = journal.offset;
+	done_row = journal.row;
 
 	row_error_count = 0;
 	dbproc->bcpinfo->parent = dbproc;
@@ -1473,16 +1986,27 @@ _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 	for (;;) {
 		bool skip;
 
-		row_start = ftello(hostfile);
+		row_start = _bcp_hostfile_tell(&hostfile);
 		row_error = false;
 
+		/* all rows before this one were handled */
+		done_offset = row_start;
+		done_row = row_of_hostfile;
+
+		if (dbproc->hostfileinfo->range_end && row_start >= dbproc->hostfileinfo->range_end) {
+			ret = NO_MORE_ROWS;
+			break;
+		}
+
 		row_of_hostfile++;
 
-		if (row_of_hostfile > MAX(dbproc->hostfileinfo->lastrow, 0x7FFFFFFF))
+		if (dbproc->hostfileinfo->lastrow > 0 && row_of_hostfile > dbproc->hostfileinfo->lastrow) {
+			ret = NO_MORE_ROWS;
 			break;
+		}
 
 		skip = dbproc->hostfileinfo->firstrow > row_of_hostfile;
-		ret = _bcp_read_hostfile(dbproc, hostfile, &row_error, skip);
+		ret = _bcp_read_hostfile(dbproc, &hostfile, &row_error, skip);
 		if (ret != MORE_ROWS)
 			break;
 
@@ -1490,16 +2014,16 @@ _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 			int count;
 
 			if (errfile == NULL && dbproc->hostfileinfo->errorfile) {
-				if (!(errfile = fopen(dbproc->hostfileinfo->errorfile, "w"))) {
-					fclose(hostfile);
+				/* do not lose errors of the copy we are resuming */
+				if (!(errfile = fopen(dbproc->hostfileinfo->errorfile, journal.batch ? "a" : "w"))) {
+					fclose(hostfile.file);
+					_bcp_hostfile_free(&hostfile);
 					dbperror(dbproc, SYBEBUOE, 0);
 					return FAIL;
 				}
 			}
 
 			if (errfile != NULL) {
-				char *row_in_error = NULL;
-
 				for (i = 0; i < dbproc->hostfileinfo->host_colcount; i++) {
 					hostcol = dbproc->hostfileinfo->host_columns[i];
 					if (hostcol->column_error == HOST_COL_CONV_ERROR) {
@@ -1520,33 +2044,27 @@ _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 					}
 				}
 
-				row_end = ftello(hostfile);
+				row_end = _bcp_hostfile_tell(&hostfile);
 
 				/* error data can be very long so split in chunks */
 				error_row_size = row_end - row_start;
-				fseeko(hostfile, row_start, SEEK_SET);
+				_bcp_hostfile_seek(&hostfile, row_start);
 
 				while (error_row_size > 0) {
 					size_t chunk = error_row_size > chunk_size ? chunk_size : (size_t) error_row_size;
+					const char *row_in_error = _bcp_hostfile_read(&hostfile, chunk);
 
 					if (!row_in_error) {
-						if ((row_in_error = tds_new(char, chunk)) == NULL) {
-							dbperror(dbproc, SYBEMEM, errno);
-						}
-					}
-
-					if (fread(row_in_error, chunk, 1, hostfile) != 1) {
 						tdsdump_log(TDS_DBG_ERROR, "BILL fread failed after fseek\n");
+						break;
 					}
-					count = (int)fwrite(row_in_error, chunk, 1, errfile);
-					if( (size_t)count < chunk ) {
+					if (fwrite(row_in_error, chunk, 1, errfile) != 1) {
 						dbperror(dbproc, SYBEBWEF, errno);
 					}
 					error_row_size -= chunk;
 				}
-				free(row_in_error);
 
-				fseeko(hostfile, row_end, SEEK_SET);
+				_bcp_hostfile_seek(&hostfile, row_end);
 				count = fprintf(errfile, "\n");
 				if( count < 0 ) {
 					dbperror(dbproc, SYBEBWEF, errno);
@@ -1570,12 +2088,25 @@ _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 				if (TDS_FAILED(tds_bcp_done(tds, &rows_written_so_far))) {
 					if (errfile)
 						fclose(errfile);
-					fclose(hostfile);
+					fclose(hostfile.file);
+					_bcp_hostfile_free(&hostfile);
 					return FAIL;
 				}
 
 				*rows_copied += rows_written_so_far;
+
+				journal.offset = _bcp_hostfile_tell(&hostfile);
+				journal.row = row_of_hostfile;
+				journal.rows += rows_written_so_far;
+				journal.batch++;
 				rows_written_so_far = 0;
+				if (!_bcp_journal_write(dbproc, &journal)) {
+					if (errfile)
+						fclose(errfile);
+					fclose(hostfile.file);
+					_bcp_hostfile_free(&hostfile);
+					return FAIL;
+				}
 
 				dbperror(dbproc, SYBEBBCI, 0); /* batch copied to server */
 
@@ -1593,13 +2124,23 @@ _bcp_exec_in(DBPROCESS * dbproc, DBINT * rows_copied)
 		dbperror(dbproc, SYBEBUCE, 0);
 	}
 
-	if (fclose(hostfile) != 0) {
+	_bcp_hostfile_free(&hostfile);
+	if (fclose(hostfile.file) != 0) {
 		dbperror(dbproc, SYBEBCUC, 0);
 		ret = FAIL;
 	}
 
-	tds_bcp_done(tds, &rows_written_so_far);
-	*rows_copied += rows_written_so_far;
+	if (TDS_SUCCEED(tds_bcp_done(tds, &rows_written_so_far))) {
+		*rows_copied += rows_written_so_far;
+
+		journal.offset = done_offset;
+		journal.row = done_row;
+		journal.rows += rows_written_so_far;
+		if (rows_written_so_far)
+			journal.batch++;
+		if (!_bcp_journal_write(dbproc, &journal))
+			ret = FAIL;
+	}
 
 	return ret == NO_MORE_ROWS? SUCCEED : FAIL;	/* (ret is returned from _bcp_read_hostfile) */
 }
@@ -2153,6 +2694,7 @@ bcp_bind(DBPROCESS * dbproc, BYTE * varaddr, int prefixlen, DBINT varlen,
 	colinfo->column_bindtype = vartype;
 	colinfo->column_bindlen  = varlen;
 	colinfo->bcp_prefix_len = prefixlen;
+	colinfo->bcp_stride = 0;
 
 	TDS_ZERO_FREE(colinfo->bcp_terminator);
 	colinfo->bcp_term_len = 0;
@@ -2186,7 +2728,7 @@ _bcp_null_error(TDSBCPINFO *bcpinfo, int index TDS_UNUSED, int offset TDS_UNUSED
  * \sa 	_bcp_add_fixed_columns, _bcp_add_variable_columns, _bcp_send_bcp_record
  */
 static TDSRET
-_bcp_get_col_data(TDSBCPINFO *bcpinfo, TDSCOLUMN *bindcol, int offset TDS_UNUSED)
+_bcp_get_col_data(TDSBCPINFO *bcpinfo, TDSCOLUMN *bindcol, int offset)
 {
 	TDS_SERVER_TYPE coltype, desttype;
 	int collen;
@@ -2195,11 +2737,12 @@ _bcp_get_col_data(TDSBCPINFO *bcpinfo, TDSCOLUMN *bindcol, int offset TDS_UNUSED
 	DBPROCESS *dbproc = (DBPROCESS *) bcpinfo->parent;
 	TDSRET rc;
 
-	tdsdump_log(TDS_DBG_FUNC, "_bcp_get_col_data(%p, %p)\n", bcpinfo, bindcol);
+	tdsdump_log(TDS_DBG_FUNC, "_bcp_get_col_data(%p, %p, %d)\n", bcpinfo, bindcol, offset);
 	CHECK_CONN(TDS_FAIL);
 	CHECK_NULP(bindcol, "_bcp_get_col_data", 2, TDS_FAIL);
 
-	dataptr = (BYTE *) bindcol->column_varaddr;
+	/* bcp_sendrows() passes the row number in offset */
+	dataptr = (BYTE *) bindcol->column_varaddr + (ptrdiff_t) offset * bindcol->bcp_stride;
 
 	collen = 0;
 
@@ -2387,6 +2930,7 @@ _bcp_free_storage(DBPROCESS * dbproc)
 	if (dbproc->hostfileinfo) {
 		TDS_ZERO_FREE(dbproc->hostfileinfo->hostfile);
 		TDS_ZERO_FREE(dbproc->hostfileinfo->errorfile);
+		TDS_ZERO_FREE(dbproc->hostfileinfo->journalfile);
 		_bcp_free_columns(dbproc);
 		TDS_ZERO_FREE(dbproc->hostfileinfo);
 	}
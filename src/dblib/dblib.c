@@ -1531,6 +1531,7 @@ dbclose(DBPROCESS * dbproc)
 	if (dbproc->hostfileinfo) {
 		free(dbproc->hostfileinfo->hostfile);
 		free(dbproc->hostfileinfo->errorfile);
+		free(dbproc->hostfileinfo->journalfile);
 		if (dbproc->hostfileinfo->host_columns) {
 			for (i = 0; i < dbproc->hostfileinfo->host_colcount; i++) {
 				free(dbproc->hostfileinfo->host_columns[i]->terminator);
@@ -0,0 +1,150 @@
+/*
+ * Purpose: Test bcp with arrays of host variables
+ * Functions: bcp_bind bcp_colstride bcp_done bcp_init bcp_sendrows
+ */
+
+#include "common.h"
+
+#define NUM_ROWS 100
+
+static void
+doexit(int value)
+{
+	dbexit();            /* always call dbexit before returning to OS */
+	exit(value);
+}
+
+static void
+exec_cmd(DBPROCESS * dbproc)
+{
+	RETCODE rc;
+
+	sql_cmd(dbproc);
+	if (dbsqlexec(dbproc) == FAIL)
+		doexit(1);
+	while ((rc=dbresults(dbproc)) == SUCCEED)
+		continue;
+	if (rc != NO_MORE_RESULTS)
+		doexit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	LOGINREC *login;
+	DBPROCESS *dbproc;
+	DBINT rows_sent, count = 0, sum = 0;
+	int i, msgno;
+
+	/* columnar host data */
+	DBINT ids[NUM_ROWS];
+	char names[NUM_ROWS][13];
+	char tag[] = "arr";
+
+	set_malloc_options();
+
+	read_login_info(argc, argv);
+
+	printf("Starting %s\n", argv[0]);
+
+	dbsetversion(DBVERSION_100);
+	dbinit();
+
+	dberrhandle(syb_err_handler);
+	dbmsghandle(syb_msg_handler);
+
+	printf("About to logon\n");
+
+	login = dblogin();
+	DBSETLPWD(login, PASSWORD);
+	DBSETLUSER(login, USER);
+	DBSETLAPP(login, "bcp_array.c unit test");
+	BCP_SETL(login, TRUE);
+
+	printf("About to open %s.%s\n", SERVER, DATABASE);
+
+	dbproc = dbopen(login, SERVER);
+	if (strlen(DATABASE))
+		dbuse(dbproc, DATABASE);
+	dbloginfree(login);
+
+	/* drop and create table */
+	exec_cmd(dbproc);
+	exec_cmd(dbproc);
+
+	for (i = 0; i < NUM_ROWS; ++i) {
+		ids[i] = i + 1;
+		/* empty strings are sent as NULL */
+		if (ids[i] % 7 == 0)
+			names[i][0] = 0;
+		else
+			sprintf(names[i], "row %d", (int) ids[i]);
+	}
+
+	if (bcp_init(dbproc, "bcp_array", NULL, "bcp.errors", DB_IN) != SUCCEED)
+		doexit(1);
+
+	bcp_bind(dbproc, (BYTE *) ids, 0, -1, NULL, 0, SYBINT4, 1);
+	bcp_bind(dbproc, (BYTE *) names, 0, -1, (BYTE *) "", 1, SYBCHAR, 2);
+	bcp_bind(dbproc, (BYTE *) tag, 0, -1, (BYTE *) "", 1, SYBCHAR, 3);
+	if (bcp_colstride(dbproc, sizeof(ids[0]), 1) != SUCCEED
+	    || bcp_colstride(dbproc, sizeof(names[0]), 2) != SUCCEED) {
+		fprintf(stderr, "bcp_colstride failed\n");
+		doexit(1);
+	}
+
+	/* negative number of rows is an error */
+	msgno = SYBEBCVLEN;
+	dbsetuserdata(dbproc, (BYTE*) &msgno);
+	if (bcp_sendrows(dbproc, -1, &rows_sent) != FAIL) {
+		fprintf(stderr, "send of negative rows succeeded\n");
+		doexit(1);
+	}
+	dbsetuserdata(dbproc, NULL);
+	if (msgno != 0) {
+		fprintf(stderr, "expected error not received\n");
+		doexit(1);
+	}
+
+	/* send in two calls, the second one moving the binding */
+	printf("Sending some rows... \n");
+	if (bcp_sendrows(dbproc, 60, &rows_sent) != SUCCEED || rows_sent != 60) {
+		fprintf(stderr, "send failed\n");
+		doexit(1);
+	}
+	bcp_colptr(dbproc, (BYTE *) (ids + 60), 1);
+	bcp_colptr(dbproc, (BYTE *) names[60], 2);
+	if (bcp_sendrows(dbproc, NUM_ROWS - 60, &rows_sent) != SUCCEED || rows_sent != NUM_ROWS - 60) {
+		fprintf(stderr, "send failed\n");
+		doexit(1);
+	}
+
+	if (bcp_done(dbproc) != NUM_ROWS) {
+		fprintf(stderr, "Bulk copy unsuccessful.\n");
+		doexit(1);
+	}
+
+	printf("done\n");
+
+	/* check all rows were inserted with the right values */
+	sql_cmd(dbproc);
+	dbsqlexec(dbproc);
+	while (dbresults(dbproc) != NO_MORE_RESULTS) {
+		dbbind(dbproc, 1, INTBIND, 0, (BYTE *) &count);
+		dbbind(dbproc, 2, INTBIND, 0, (BYTE *) &sum);
+		while (dbnextrow(dbproc) == REG_ROW)
+			continue;
+	}
+	if (count != NUM_ROWS || sum != NUM_ROWS * (NUM_ROWS + 1) / 2) {
+		fprintf(stderr, "Expected %d rows with sum %d, got %d rows with sum %d\n",
+			NUM_ROWS, NUM_ROWS * (NUM_ROWS + 1) / 2, (int) count, (int) sum);
+		doexit(1);
+	}
+
+	printf("Dropping table bcp_array\n");
+	exec_cmd(dbproc);
+	dbexit();
+
+	printf("%s OK\n", __FILE__);
+	return 0;
+}
@@ -0,0 +1,12 @@
+if exists (select 1 from sysobjects where type = 'U' and name = 'bcp_array') drop table bcp_array
+go
+CREATE TABLE bcp_array
+( id int not null,
+  name varchar(12) null,
+  tag char(4) not null )
+go
+select count(*), sum(id) from bcp_array where tag = 'arr'
+	and (name = 'row ' + convert(varchar(8), id) or (name is null and id % 7 = 0))
+go
+drop table bcp_array
+go
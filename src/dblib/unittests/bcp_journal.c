@@ -0,0 +1,181 @@
+/*
+ * Purpose: Test resuming a bcp copy in using a journal
+ * Functions: bcp_colfmt bcp_columns bcp_control bcp_exec bcp_init bcp_journal
+ */
+
+#include "common.h"
+
+#define NUM_ROWS 10
+
+static const char host_file[] = "bcp_journal.in";
+static const char journal_file[] = "bcp_journal.jnl";
+
+static void
+doexit(int value)
+{
+	dbexit();            /* always call dbexit before returning to OS */
+	exit(value);
+}
+
+static void
+exec_cmd(DBPROCESS * dbproc)
+{
+	RETCODE rc;
+
+	sql_cmd(dbproc);
+	if (dbsqlexec(dbproc) == FAIL)
+		doexit(1);
+	while ((rc=dbresults(dbproc)) == SUCCEED)
+		continue;
+	if (rc != NO_MORE_RESULTS)
+		doexit(1);
+}
+
+/* copy in the host file, return rows copied */
+static DBINT
+copy_in(DBPROCESS * dbproc, int resume, int lastrow)
+{
+	DBINT rows = -1;
+
+	if (bcp_init(dbproc, "bcp_journal", host_file, "bcp.errors", DB_IN) != SUCCEED
+	    || bcp_columns(dbproc, 2) != SUCCEED
+	    || bcp_colfmt(dbproc, 1, SYBCHAR, 0, -1, (const BYTE *) "\t", 1, 1) != SUCCEED
+	    || bcp_colfmt(dbproc, 2, SYBCHAR, 0, -1, (const BYTE *) "\n", 1, 2) != SUCCEED
+	    || bcp_control(dbproc, BCPBATCH, 3) != SUCCEED
+	    || bcp_control(dbproc, BCPLAST, lastrow) != SUCCEED
+	    || bcp_journal(dbproc, journal_file, resume) != SUCCEED) {
+		fprintf(stderr, "bcp setup failed\n");
+		doexit(1);
+	}
+	if (bcp_exec(dbproc, &rows) != SUCCEED) {
+		fprintf(stderr, "bcp_exec failed\n");
+		doexit(1);
+	}
+	return rows;
+}
+
+static void
+check_journal(long offset, int row, int rows, int batch)
+{
+	FILE *f;
+	long j_offset;
+	int j_row, j_rows, j_batch;
+
+	f = fopen(journal_file, "r");
+	if (!f || fscanf(f, "%ld %d %d %d", &j_offset, &j_row, &j_rows, &j_batch) != 4) {
+		fprintf(stderr, "error reading journal\n");
+		doexit(1);
+	}
+	fclose(f);
+	if (j_offset != offset || j_row != row || j_rows != rows || j_batch != batch) {
+		fprintf(stderr, "Wrong journal %ld %d %d %d, expected %ld %d %d %d\n",
+			j_offset, j_row, j_rows, j_batch, offset, row, rows, batch);
+		doexit(1);
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	LOGINREC *login;
+	DBPROCESS *dbproc;
+	DBINT rows, count = 0, sum = 0;
+	long offsets[NUM_ROWS + 1];
+	FILE *f;
+	int i;
+
+	set_malloc_options();
+
+	read_login_info(argc, argv);
+
+	printf("Starting %s\n", argv[0]);
+
+	dbsetversion(DBVERSION_100);
+	dbinit();
+
+	dberrhandle(syb_err_handler);
+	dbmsghandle(syb_msg_handler);
+
+	printf("About to logon\n");
+
+	login = dblogin();
+	DBSETLPWD(login, PASSWORD);
+	DBSETLUSER(login, USER);
+	DBSETLAPP(login, "bcp_journal.c unit test");
+	BCP_SETL(login, TRUE);
+
+	printf("About to open %s.%s\n", SERVER, DATABASE);
+
+	dbproc = dbopen(login, SERVER);
+	if (strlen(DATABASE))
+		dbuse(dbproc, DATABASE);
+	dbloginfree(login);
+
+	/* drop and create table */
+	exec_cmd(dbproc);
+	exec_cmd(dbproc);
+
+	f = fopen(host_file, "wb");
+	if (!f) {
+		fprintf(stderr, "error creating host file\n");
+		doexit(1);
+	}
+	offsets[0] = 0;
+	for (i = 1; i <= NUM_ROWS; ++i)
+		offsets[i] = offsets[i - 1] + fprintf(f, "%d\trow %d\n", i, i);
+	fclose(f);
+	remove(journal_file);
+
+	/* simulate an interrupted copy, last batch is incomplete */
+	printf("Copying first rows\n");
+	rows = copy_in(dbproc, FALSE, 7);
+	if (rows != 7) {
+		fprintf(stderr, "Expected 7 rows copied, got %d\n", (int) rows);
+		doexit(1);
+	}
+	check_journal(offsets[7], 7, 7, 3);
+
+	/* resume, only remaining rows should be copied */
+	printf("Resuming copy\n");
+	rows = copy_in(dbproc, TRUE, 0);
+	if (rows != NUM_ROWS - 7) {
+		fprintf(stderr, "Expected %d rows copied, got %d\n", NUM_ROWS - 7, (int) rows);
+		doexit(1);
+	}
+	check_journal(offsets[NUM_ROWS], NUM_ROWS, NUM_ROWS, 4);
+
+	/* copy completed, nothing to do */
+	rows = copy_in(dbproc, TRUE, 0);
+	if (rows != 0) {
+		fprintf(stderr, "Expected no rows copied, got %d\n", (int) rows);
+		doexit(1);
+	}
+	check_journal(offsets[NUM_ROWS], NUM_ROWS, NUM_ROWS, 4);
+
+	printf("done\n");
+
+	/* check all rows were inserted once */
+	sql_cmd(dbproc);
+	dbsqlexec(dbproc);
+	while (dbresults(dbproc) != NO_MORE_RESULTS) {
+		dbbind(dbproc, 1, INTBIND, 0, (BYTE *) &count);
+		dbbind(dbproc, 2, INTBIND, 0, (BYTE *) &sum);
+		while (dbnextrow(dbproc) == REG_ROW)
+			continue;
+	}
+	if (count != NUM_ROWS || sum != NUM_ROWS * (NUM_ROWS + 1) / 2) {
+		fprintf(stderr, "Expected %d rows with sum %d, got %d rows with sum %d\n",
+			NUM_ROWS, NUM_ROWS * (NUM_ROWS + 1) / 2, (int) count, (int) sum);
+		doexit(1);
+	}
+
+	remove(host_file);
+	remove(journal_file);
+
+	printf("Dropping table bcp_journal\n");
+	exec_cmd(dbproc);
+	dbexit();
+
+	printf("%s OK\n", __FILE__);
+	return 0;
+}
@@ -0,0 +1,10 @@
+if exists (select 1 from sysobjects where type = 'U' and name = 'bcp_journal') drop table bcp_journal
+go
+CREATE TABLE bcp_journal
+( id int not null,
+  name varchar(12) null )
+go
+select count(*), sum(id) from bcp_journal where name = 'row ' + convert(varchar(8), id)
+go
+drop table bcp_journal
+go
@@ -23,6 +23,8 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <assert.h>
+#include <ctype.h>
+#include <errno.h>
 
 #if HAVE_STRING_H
 #include <string.h>
@@ -277,6 +279,69 @@ odbc_bcp_sendrow(TDS_DBC *dbc)
 		ODBCBCP_ERROR_RETURN("HY000");
 }
 
+/**
+ * \ingroup odbc_bcp
+ * \brief Write many rows to the table taking data from column buffers.
+ *
+ * \param dbc ODBC database connection object
+ * \param columns array of BCPCOLUMNDATA, one for every column in the table
+ * \param num_columns number of elements in \a columns
+ * \param num_rows number of rows to send
+ *
+ * \remarks Data are in the layout used by Apache Arrow, so columnar data
+ *	can be sent without converting them to rows. Variables bound with
+ *	bcp_bind() are not used.
+ * \return Count of rows sent, -1 on errors before sending any row.
+ *	In case of error rows before the failing one are sent.
+ * \sa 	odbc_bcp_batch(), odbc_bcp_done(), odbc_bcp_sendrow()
+ */
+int
+odbc_bcp_sendcolumns(TDS_DBC *dbc, const void *columns, int num_columns, int num_rows)
+{
+	const BCPCOLUMNDATA *coldata = (const BCPCOLUMNDATA *) columns;
+	TDSBCPCOLBUF *bufs;
+	TDSSOCKET *tds;
+	TDS_INT rows_sent = 0;
+	TDSRET rc;
+	int i;
+
+	tdsdump_log(TDS_DBG_FUNC, "bcp_sendcolumns(%p, %p, %d, %d)\n", dbc, columns, num_columns, num_rows);
+	if (dbc->bcpinfo == NULL || dbc->bcpinfo->bindinfo == NULL)
+		ODBCBCP_ERROR_DBINT("HY010");
+
+	tds = dbc->tds_socket;
+
+	if (dbc->bcpinfo->direction != BCP_DIRECTION_IN)
+		ODBCBCP_ERROR_DBINT("HY010");
+	if (!coldata || num_columns != dbc->bcpinfo->bindinfo->num_cols || num_rows < 0)
+		ODBCBCP_ERROR_DBINT("HY009");
+
+	if (!dbc->bcpinfo->xfer_init) {
+		if (TDS_FAILED(tds_bcp_start_copy_in(tds, dbc->bcpinfo)))
+			ODBCBCP_ERROR_DBINT("HY000");
+
+		dbc->bcpinfo->xfer_init = true;
+	}
+
+	bufs = tds_new(TDSBCPCOLBUF, num_columns);
+	if (!bufs)
+		ODBCBCP_ERROR_DBINT("HY001");
+	for (i = 0; i < num_columns; ++i) {
+		bufs[i].type = (TDS_SERVER_TYPE) coldata[i].vartype;
+		bufs[i].values = coldata[i].values;
+		bufs[i].offsets = (const TDS_INT *) coldata[i].offsets;
+		bufs[i].validity = coldata[i].validity;
+	}
+
+	dbc->bcpinfo->parent = dbc;
+	rc = tds_bcp_send_columns(tds, dbc->bcpinfo, bufs, num_rows, NULL, &rows_sent);
+	free(bufs);
+	if (TDS_FAILED(rc))
+		odbc_errs_add(&dbc->errs, "HY000", NULL);
+
+	return rows_sent;
+}
+
 
 /**
  * \ingroup odbc_bcp
@@ -679,6 +744,413 @@ _bcp_get_term_var(const TDS_CHAR * pdata, const TDS_CHAR * term, int term_len)
 	return bufpos;
 }
 
+/*
+ * Parameter arrays sent as bulk copy.
+ *
+ * A plain "INSERT [INTO] table (columns) VALUES (?, ...)" executed with
+ * SQL_ATTR_PARAMSET_SIZE > 1 can be sent as a single bulk copy stream
+ * instead of one INSERT for every parameter row.
+ */
+
+static const char *
+odbc_bcp_skip_spaces(const char *p)
+{
+	for (;;) {
+		if (isspace((unsigned char) *p))
+			++p;
+		else if ((p[0] == '-' && p[1] == '-') || (p[0] == '/' && p[1] == '*'))
+			p = tds_skip_comment(p);
+		else
+			return p;
+	}
+}
+
+static bool
+odbc_bcp_is_name_char(char c)
+{
+	return isalnum((unsigned char) c) || c == '_' || c == '@' || c == '#' || c == '$' || (c & 0x80) != 0;
+}
+
+/* skip given keyword, returns NULL if not found */
+static const char *
+odbc_bcp_skip_keyword(const char *p, const char *keyword)
+{
+	size_t len = strlen(keyword);
+
+	p = odbc_bcp_skip_spaces(p);
+	if (strncasecmp(p, keyword, len) != 0 || odbc_bcp_is_name_char(p[len]))
+		return NULL;
+	return p + len;
+}
+
+/* skip a (possibly quoted and qualified) name, returns NULL if not found */
+static const char *
+odbc_bcp_skip_name(const char *p)
+{
+	const char *start = p;
+
+	for (;;) {
+		if (*p == '[' || *p == '"') {
+			p = tds_skip_quoted(p);
+		} else {
+			while (odbc_bcp_is_name_char(*p))
+				++p;
+		}
+		if (*p != '.')
+			break;
+		++p;
+	}
+	return p == start ? NULL : p;
+}
+
+/**
+ * Check if query is a simple INSERT of placeholders only.
+ * \param query      query to check
+ * \param num_params number of parameters of the statement
+ * \param table      filled with table name
+ * \param columns    filled with comma separated list of columns
+ * \return true if the query can be sent as bulk copy
+ */
+static bool
+odbc_bcp_parse_insert(const char *query, int num_params, DSTR *table, DSTR *columns)
+{
+	const char *p, *start;
+	int n, i;
+
+	if ((p = odbc_bcp_skip_keyword(query, "insert")) == NULL)
+		return false;
+	if ((start = odbc_bcp_skip_keyword(p, "into")) != NULL)
+		p = start;
+
+	start = odbc_bcp_skip_spaces(p);
+	if ((p = odbc_bcp_skip_name(start)) == NULL)
+		return false;
+	if (!tds_dstr_copyn(table, start, p - start))
+		return false;
+
+	p = odbc_bcp_skip_spaces(p);
+	if (*p != '(')
+		return false;
+	start = p + 1;
+	for (n = 1;; ++n) {
+		p = odbc_bcp_skip_spaces(p + 1);
+		if ((p = odbc_bcp_skip_name(p)) == NULL)
+			return false;
+		p = odbc_bcp_skip_spaces(p);
+		if (*p == ')')
+			break;
+		if (*p != ',')
+			return false;
+	}
+	if (n != num_params || !tds_dstr_copyn(columns, start, p - start))
+		return false;
+
+	if ((p = odbc_bcp_skip_keyword(p + 1, "values")) == NULL)
+		return false;
+	p = odbc_bcp_skip_spaces(p);
+	if (*p != '(')
+		return false;
+	for (i = 0; i < n; ++i) {
+		p = odbc_bcp_skip_spaces(p + 1);
+		if (*p != '?')
+			return false;
+		p = odbc_bcp_skip_spaces(p + 1);
+		if (*p != (i + 1 < n ? ',' : ')'))
+			return false;
+	}
+	p = odbc_bcp_skip_spaces(p + 1);
+	if (*p == ';')
+		p = odbc_bcp_skip_spaces(p + 1);
+	return *p == 0;
+}
+
+/**
+ * Check parameters can be copied to table columns without
+ * changing semantic of the INSERT.
+ */
+static bool
+odbc_bcp_paramset_compatible(TDSPARAMINFO *params, TDSRESULTINFO *bindinfo)
+{
+	int i;
+
+	if (!params || params->num_cols != bindinfo->num_cols)
+		return false;
+
+	for (i = 0; i < bindinfo->num_cols; ++i) {
+		TDSCOLUMN *param = params->columns[i];
+		TDSCOLUMN *bindcol = bindinfo->columns[i];
+		TDS_SERVER_TYPE srctype = tds_get_conversion_type(param->column_type, param->column_size);
+		TDS_SERVER_TYPE desttype = tds_get_conversion_type(bindcol->column_type, bindcol->column_size);
+
+		if (param->column_output || bindcol->column_identity || bindcol->column_timestamp
+		    || bindcol->column_computed || is_blob_col(bindcol))
+			return false;
+
+		if (is_char_type(desttype)) {
+			/* parameter data is converted to server encoding as is */
+			if (!is_char_type(srctype) || is_unicode_type(srctype) != is_unicode_type(desttype))
+				return false;
+			continue;
+		}
+		if (is_binary_type(desttype)) {
+			if (!is_binary_type(srctype))
+				return false;
+			continue;
+		}
+		if (is_char_type(srctype) || is_binary_type(srctype) || !tds_willconvert(srctype, desttype))
+			return false;
+
+		switch (desttype) {
+		case SYBINT1:
+		case SYBINT2:
+		case SYBINT4:
+		case SYBINT8:
+		case SYBFLT8:
+		case SYBREAL:
+		case SYBBIT:
+		case SYBMONEY:
+		case SYBMONEY4:
+		case SYBDATETIME:
+		case SYBDATETIME4:
+		case SYBNUMERIC:
+		case SYBDECIMAL:
+		case SYBUNIQUE:
+		case SYBMSDATE:
+		case SYBMSTIME:
+		case SYBMSDATETIME2:
+		case SYBMSDATETIMEOFFSET:
+			break;
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Fill bulk data of a column from current parameter row.
+ * Errors are added to the statement.
+ */
+static bool
+odbc_bcp_param_data(TDS_STMT *stmt, TDSCOLUMN *param, TDSCOLUMN *bindcol)
+{
+	BCPCOLDATA *coldata = bindcol->bcp_column_data;
+	TDS_SERVER_TYPE srctype = tds_get_conversion_type(param->column_type, param->column_size);
+	TDS_SERVER_TYPE desttype = tds_get_conversion_type(bindcol->column_type, bindcol->column_size);
+	const TDS_CHAR *src = (const TDS_CHAR *) param->column_data;
+	size_t srclen = param->column_cur_size;
+	size_t destlen = bindcol->on_server.column_size;
+	CONV_RESULT cr;
+	TDS_INT len;
+
+	coldata->is_null = false;
+	if (param->column_cur_size < 0) {
+		if (!bindcol->column_nullable) {
+			odbc_errs_add(&stmt->errs, "23000", NULL);
+			return false;
+		}
+		coldata->is_null = true;
+		coldata->datalen = 0;
+		return true;
+	}
+	if (is_blob_col(param))
+		src = ((TDSBLOB *) src)->textvalue;
+
+	/* buffer could be smaller than column */
+	if ((is_char_type(desttype) || is_binary_type(desttype)) && coldata->datasize < (TDS_INT) destlen) {
+		if (!TDS_RESIZE(coldata->data, destlen)) {
+			odbc_errs_add(&stmt->errs, "HY001", NULL);
+			return false;
+		}
+		coldata->datasize = (TDS_INT) destlen;
+	}
+
+	if (is_char_type(desttype)) {
+		char *dest = (char *) coldata->data;
+
+		if (!param->char_conv) {
+			if (srclen > destlen) {
+				odbc_errs_add(&stmt->errs, "22001", NULL);
+				return false;
+			}
+			memcpy(dest, src, srclen);
+			coldata->datalen = srclen;
+			return true;
+		}
+		if (tds_iconv(stmt->tds, param->char_conv, to_server, &src, &srclen, &dest, &destlen) == (size_t) -1
+		    || srclen) {
+			odbc_errs_add(&stmt->errs, srclen && errno == E2BIG ? "22001" : "22018", NULL);
+			return false;
+		}
+		coldata->datalen = dest - (char *) coldata->data;
+		return true;
+	}
+
+	if (is_binary_type(desttype) || (srctype == desttype && !is_numeric_type(desttype))) {
+		if (srclen > destlen) {
+			odbc_errs_add(&stmt->errs, "22001", NULL);
+			return false;
+		}
+		memcpy(coldata->data, src, srclen);
+		coldata->datalen = srclen;
+		return true;
+	}
+
+	if (is_numeric_type(desttype)) {
+		cr.n.precision = bindcol->column_prec;
+		cr.n.scale = bindcol->column_scale;
+	}
+	len = tds_convert(stmt->dbc->env->tds_ctx, srctype, src, srclen, desttype, &cr);
+	if (len < 0) {
+		odbc_convert_err_set(&stmt->errs, len);
+		return false;
+	}
+	memcpy(coldata->data, &cr, len);
+	coldata->datalen = len;
+	return true;
+}
+
+/* data are already filled by odbc_bcp_param_data */
+static TDSRET
+_bcp_get_param_data(TDSBCPINFO *bcpinfo TDS_UNUSED, TDSCOLUMN *bindcol TDS_UNUSED, int offset TDS_UNUSED)
+{
+	return TDS_SUCCESS;
+}
+
+static void
+odbc_bcp_paramset_status(TDS_STMT *stmt, SQLULEN processed, SQLULEN first, SQLULEN last, SQLUSMALLINT status)
+{
+	SQLUSMALLINT *status_ptr = stmt->ipd->header.sql_desc_array_status_ptr;
+
+	if (status_ptr)
+		for (; first < last; ++first)
+			status_ptr[first] = status;
+	if (stmt->ipd->header.sql_desc_rows_processed_ptr)
+		*stmt->ipd->header.sql_desc_rows_processed_ptr = processed;
+}
+
+/**
+ * Execute a statement with multiple parameter rows using bulk copy.
+ * Statement should be locked and parameters of first row already parsed.
+ * On return the statement is left idle unless a network error occurred.
+ * \return SQL_NO_DATA if the statement cannot be sent using bulk copy,
+ * caller should execute it as usual
+ */
+SQLRETURN
+odbc_bcp_paramset(TDS_STMT *stmt)
+{
+	TDSSOCKET *tds = stmt->tds;
+	TDSBCPINFO *bcpinfo;
+	DSTR table = DSTR_INITIALIZER, columns = DSTR_INITIALIZER;
+	char *select = NULL;
+	SQLULEN row, num_rows = stmt->num_param_rows;
+	int i, rows_copied = 0;
+
+	tdsdump_log(TDS_DBG_FUNC, "odbc_bcp_paramset(%p)\n", stmt);
+
+	if (!IS_TDS71_PLUS(tds->conn) || !TDS_IS_MSSQL(tds) || stmt->prepared_query_is_func || !stmt->params
+	    || !odbc_bcp_parse_insert(tds_dstr_cstr(&stmt->query), stmt->param_count, &table, &columns)) {
+		tds_dstr_free(&table);
+		tds_dstr_free(&columns);
+		return SQL_NO_DATA;
+	}
+
+	bcpinfo = tds_alloc_bcpinfo();
+	if (!bcpinfo) {
+		tds_dstr_free(&table);
+		tds_dstr_free(&columns);
+		odbc_errs_add(&stmt->errs, "HY001", NULL);
+		return SQL_ERROR;
+	}
+
+	/* retrieve format of inserted columns, in the order used by the query */
+	bcpinfo->direction = TDS_BCP_QUERYOUT;
+	if (asprintf(&select, "select %s from %s", tds_dstr_cstr(&columns), tds_dstr_cstr(&table)) < 0)
+		select = NULL;
+	if (!select || !tds_dstr_set(&bcpinfo->tablename, select)) {
+		free(select);
+		tds_free_bcpinfo(bcpinfo);
+		tds_dstr_free(&table);
+		tds_dstr_free(&columns);
+		odbc_errs_add(&stmt->errs, "HY001", NULL);
+		return SQL_ERROR;
+	}
+	tds_dstr_free(&columns);
+	if (TDS_FAILED(tds_bcp_init(tds, bcpinfo))) {
+		tds_free_bcpinfo(bcpinfo);
+		tds_dstr_free(&table);
+		odbc_bcp_paramset_status(stmt, num_rows, 0, num_rows, SQL_PARAM_ERROR);
+		return SQL_ERROR;
+	}
+	if (!odbc_bcp_paramset_compatible(stmt->params, bcpinfo->bindinfo)) {
+		tdsdump_log(TDS_DBG_INFO1, "odbc_bcp_paramset: parameters not compatible, using normal INSERT\n");
+		tds_free_bcpinfo(bcpinfo);
+		tds_dstr_free(&table);
+		return SQL_NO_DATA;
+	}
+
+	/* hints keep INSERT semantic */
+	bcpinfo->direction = TDS_BCP_IN;
+	bcpinfo->parent = stmt;
+	if (!tds_dstr_dup(&bcpinfo->tablename, &table)
+	    || !tds_dstr_copy(&bcpinfo->hint, "CHECK_CONSTRAINTS, FIRE_TRIGGERS, KEEP_NULLS")) {
+		tds_free_bcpinfo(bcpinfo);
+		tds_dstr_free(&table);
+		odbc_errs_add(&stmt->errs, "HY001", NULL);
+		return SQL_ERROR;
+	}
+	tds_dstr_free(&table);
+
+	if (TDS_FAILED(tds_bcp_start_copy_in(tds, bcpinfo))) {
+		tds_free_bcpinfo(bcpinfo);
+		odbc_bcp_paramset_status(stmt, num_rows, 0, num_rows, SQL_PARAM_ERROR);
+		return SQL_ERROR;
+	}
+
+	for (row = 0; row < num_rows; ++row) {
+		if (row) {
+			stmt->curr_param_row = row;
+			if (start_parse_prepared_query(stmt, true) != SQL_SUCCESS)
+				break;
+			/* types of following rows could differ */
+			if (!odbc_bcp_paramset_compatible(stmt->params, bcpinfo->bindinfo)) {
+				odbc_errs_add(&stmt->errs, "HY000", "Parameter type changed in parameter array");
+				break;
+			}
+		}
+		/* convert all columns before sending anything for this row */
+		for (i = 0; i < bcpinfo->bindinfo->num_cols; ++i)
+			if (!odbc_bcp_param_data(stmt, stmt->params->columns[i], bcpinfo->bindinfo->columns[i]))
+				break;
+		if (i < bcpinfo->bindinfo->num_cols)
+			break;
+		if (TDS_FAILED(tds_bcp_send_record(tds, bcpinfo, _bcp_get_param_data, NULL, 0))) {
+			tds_free_bcpinfo(bcpinfo);
+			odbc_bcp_paramset_status(stmt, num_rows, 0, num_rows, SQL_PARAM_ERROR);
+			return SQL_ERROR;
+		}
+	}
+	tds_free_bcpinfo(bcpinfo);
+	stmt->curr_param_row = 0;
+
+	/* rows already sent are inserted even if a following row failed */
+	if (TDS_FAILED(tds_bcp_done(tds, &rows_copied))) {
+		odbc_bcp_paramset_status(stmt, row, 0, row, SQL_PARAM_ERROR);
+		return SQL_ERROR;
+	}
+	stmt->row_count = rows_copied;
+	stmt->row_status = PRE_NORMAL_ROW;
+
+	if (row < num_rows) {
+		odbc_bcp_paramset_status(stmt, row + 1, 0, row, SQL_PARAM_SUCCESS);
+		odbc_bcp_paramset_status(stmt, row + 1, row, row + 1, SQL_PARAM_ERROR);
+		odbc_bcp_paramset_status(stmt, row + 1, row + 1, num_rows, SQL_PARAM_UNUSED);
+		return SQL_ERROR;
+	}
+	odbc_bcp_paramset_status(stmt, num_rows, 0, num_rows, SQL_PARAM_SUCCESS);
+	return stmt->errs.lastrc == SQL_SUCCESS_WITH_INFO ? SQL_SUCCESS_WITH_INFO : SQL_SUCCESS;
+}
+
 void
 odbc_bcp_free_storage(TDS_DBC *dbc)
 {
@@ -294,6 +294,12 @@ odbc_get_dsn_info(TDS_ERRS *errs, const char *DSN, TDSLOGIN * login)
 		}
 	}
 
+	if (myGetPrivateProfileString(DSN, odbc_param_StatementCacheSize, tmp) > 0)
+		login->stmt_cache_size = atoi(tmp);
+
+	if (myGetPrivateProfileString(DSN, odbc_param_BulkParamsets, tmp) > 0)
+		login->bulk_paramsets = tds_config_boolean(odbc_param_BulkParamsets, tmp, login);
+
 	return true;
 }
 
@@ -516,6 +522,10 @@ odbc_parse_connect_string(TDS_ERRS *errs, const char *connect_string, const char
 			tds_parse_conf_section(TDS_STR_TIMEOUT, tds_dstr_cstr(&value), login);
 		} else if (CHK_PARAM(HostNameInCertificate)) {
 			dest_s = &login->certificate_host_name;
+		} else if (CHK_PARAM(StatementCacheSize)) {
+			login->stmt_cache_size = atoi(tds_dstr_cstr(&value));
+		} else if (CHK_PARAM(BulkParamsets)) {
+			login->bulk_paramsets = tds_config_boolean(odbc_param_BulkParamsets, tds_dstr_cstr(&value), login);
 		}
 
 		if (num_param >= 0 && parsed_params) {
@@ -276,6 +276,18 @@ odbc_convert_to_binary(TDSCOLUMN *curcol, int srctype, TDS_CHAR * src, TDS_UINT
 	return ret;
 }
 
+static void
+odbc_daterec_to_timestamp(const TDSDATEREC *dr, TIMESTAMP_STRUCT *tssp)
+{
+	tssp->year = dr->year;
+	tssp->month = dr->month + 1;
+	tssp->day = dr->day;
+	tssp->hour = dr->hour;
+	tssp->minute = dr->minute;
+	tssp->second = dr->second;
+	tssp->fraction = dr->decimicrosecond * 100u;
+}
+
 static SQLLEN
 odbc_tds2sql(TDS_STMT * stmt, TDSCOLUMN *curcol, int srctype, TDS_CHAR * src, TDS_UINT srclen,
 	     int desttype, TDS_CHAR * dest, SQLULEN destlen,
@@ -528,14 +540,7 @@ normal_conversion:
 			 * now decompose date into constituent parts...
 			 */
 			tds_datecrack(SYBMSDATETIME2, &(ores.dt), &dr);
-
-			tssp->year = dr.year;
-			tssp->month = dr.month + 1;
-			tssp->day = dr.day;
-			tssp->hour = dr.hour;
-			tssp->minute = dr.minute;
-			tssp->second = dr.second;
-			tssp->fraction = dr.decimicrosecond * 100u;
+			odbc_daterec_to_timestamp(&dr, tssp);
 
 			ret = sizeof(TIMESTAMP_STRUCT);
 		}
@@ -644,3 +649,91 @@ SQLLEN odbc_tds2sql_int4(TDS_STMT * stmt, TDS_INT *src, int desttype, TDS_CHAR *
 	return odbc_tds2sql(stmt, NULL, SYBINT4, (TDS_CHAR *) src, sizeof(*src),
 			    desttype, dest, destlen, NULL);
 }
+
+/**
+ * Choose how to copy a column to a bound buffer of a given C type.
+ * Types having the same representation on wire and in C are simply
+ * copied, avoiding the generic conversion for every row.
+ */
+void
+odbc_tds2sql_plan(TDS_ODBC_COL_PLAN *plan, TDSCOLUMN *curcol, int desttype)
+{
+	int srctype = tds_get_conversion_type(curcol->on_server.column_type, curcol->on_server.column_size);
+	unsigned int size = 0;
+
+	plan->kind = ODBC_COPY_CONVERT;
+	plan->srctype = srctype;
+	plan->size = 0;
+
+	switch (desttype) {
+	case SQL_C_LONG:
+	case SQL_C_SLONG:
+		if (srctype == SYBINT4)
+			size = sizeof(TDS_INT);
+		break;
+	case SQL_C_SHORT:
+	case SQL_C_SSHORT:
+		if (srctype == SYBINT2)
+			size = sizeof(TDS_SMALLINT);
+		break;
+	case SQL_C_UTINYINT:
+		if (srctype == SYBINT1)
+			size = sizeof(TDS_TINYINT);
+		break;
+#ifdef SQL_C_SBIGINT
+	case SQL_C_SBIGINT:
+		if (srctype == SYBINT8)
+			size = sizeof(TDS_INT8);
+		break;
+#endif
+	case SQL_C_DOUBLE:
+		if (srctype == SYBFLT8)
+			size = sizeof(TDS_FLOAT);
+		break;
+	case SQL_C_FLOAT:
+		if (srctype == SYBREAL)
+			size = sizeof(TDS_REAL);
+		break;
+#ifdef SQL_C_GUID
+	case SQL_C_GUID:
+		if (srctype == SYBUNIQUE)
+			size = sizeof(TDS_UNIQUE);
+		break;
+#endif
+	case SQL_C_TYPE_TIMESTAMP:
+	case SQL_C_TIMESTAMP:
+		if (srctype == SYBDATETIME || srctype == SYBDATETIME4)
+			plan->kind = ODBC_COPY_TIMESTAMP;
+		return;
+	}
+
+	if (size && (unsigned int) curcol->column_size == size) {
+		plan->kind = ODBC_COPY_FIXED;
+		plan->size = size;
+	}
+}
+
+/**
+ * Copy a not NULL column using a plan computed by odbc_tds2sql_plan.
+ * \return length of data copied
+ */
+SQLLEN
+odbc_tds2sql_fast(const TDS_ODBC_COL_PLAN *plan, TDSCOLUMN *curcol, TDS_CHAR * dest)
+{
+	TDSDATEREC dr;
+
+	switch (plan->kind) {
+	case ODBC_COPY_FIXED:
+		memcpy(dest, curcol->column_data, plan->size);
+		return plan->size;
+	case ODBC_COPY_TIMESTAMP:
+		/* same result of conversion to SYBMSDATETIME2 done by odbc_tds2sql */
+		tds_datecrack(plan->srctype, curcol->column_data, &dr);
+		odbc_daterec_to_timestamp(&dr, (TIMESTAMP_STRUCT *) dest);
+		return sizeof(TIMESTAMP_STRUCT);
+	default:
+		break;
+	}
+	assert(0);
+	return SQL_NULL_DATA;
+}
@@ -75,6 +75,10 @@ static void odbc_upper_column_names(TDS_STMT * stmt);
 static void odbc_col_setname(TDS_STMT * stmt, int colpos, const char *name);
 static SQLRETURN odbc_stat_execute(TDS_STMT * stmt _WIDE, const char *begin, int nparams, ...);
 static SQLRETURN odbc_free_dynamic(TDS_STMT * stmt);
+static bool odbc_stmt_cache_get(TDS_STMT * stmt);
+static bool odbc_stmt_cache_put(TDS_STMT * stmt);
+static void odbc_stmt_cache_trim(TDS_DBC * dbc, unsigned int max_entries);
+static char *odbc_stmt_cache_signature(TDS_STMT * stmt);
 static SQLRETURN odbc_free_cursor(TDS_STMT * stmt);
 static SQLRETURN odbc_update_ird(TDS_STMT *stmt, TDS_ERRS *errs);
 static SQLRETURN odbc_prepare(TDS_STMT *stmt);
@@ -431,6 +435,8 @@ odbc_connect(TDS_DBC * dbc, TDSLOGIN * login)
 #endif
 
 	dbc->default_query_timeout = dbc->tds_socket->query_timeout;
+	dbc->stmt_cache_size = login->stmt_cache_size > 0 ? login->stmt_cache_size : 0;
+	dbc->bulk_paramsets = login->bulk_paramsets;
 
 	if (IS_TDS7_PLUS(dbc->tds_socket->conn))
 		dbc->cursor_support = 1;
@@ -510,6 +516,10 @@ odbc_prepare(TDS_STMT *stmt)
 	TDSSOCKET *tds = stmt->tds;
 	bool in_row = false;
 
+	/* IRD is filled from prepare results so do not take from cache but allow to store it later */
+	free(stmt->dyn_signature);
+	stmt->dyn_signature = stmt->dbc->stmt_cache_size ? odbc_stmt_cache_signature(stmt) : NULL;
+
 	if (TDS_FAILED(tds_submit_prepare(tds, tds_dstr_cstr(&stmt->query), NULL, &stmt->dyn, stmt->params))) {
 		ODBC_SAFE_ERROR(stmt);
 		return SQL_ERROR;
@@ -1765,6 +1775,7 @@ odbc_SQLAllocEnv(SQLHENV FAR * phenv, SQLINTEGER odbc_version)
 	ctx->locale->date_fmt = strdup("%Y-%m-%d");
 	free(ctx->locale->time_fmt);
 	ctx->locale->time_fmt = strdup("%H:%M:%S.%z");
+	tds_locale_compile_formats(ctx->locale);
 
 	tds_mutex_init(&env->mtx);
 	*phenv = (SQLHENV) env;
@@ -2464,6 +2475,10 @@ SQLDisconnect(SQLHDBC hdbc)
 		}
 	}
 
+	/* connection mutex is still held here, as required by odbc_stmt_cache_trim */
+	tdsdump_log(TDS_DBG_INFO1, "statement cache: %u hits, %u misses\n", dbc->stmt_cache_hits, dbc->stmt_cache_misses);
+	odbc_stmt_cache_trim(dbc, 0);
+
 #ifdef ENABLE_ODBC_WIDE
 	dbc->mb_conv = NULL;
 #endif
@@ -2511,6 +2526,18 @@ odbc_errmsg_handler(const TDSCONTEXT * ctx, TDSSOCKET * tds, TDSMESSAGE * msg)
 		stmt = odbc_get_stmt(tds);
 		if (stmt)
 			errs = &stmt->errs;
+
+		/* prepared handle is no longer valid, do not reuse any cached one */
+		if (msg->msgno == 8179 && TDS_IS_MSSQL(tds)) {
+			dbc->stmt_cache_flush = 1;
+			if (stmt && stmt->dyn) {
+				/* server does not know this handle, forget it without unpreparing */
+				tds_dynamic_deallocated(tds->conn, stmt->dyn);
+				free(stmt->dyn_signature);
+				stmt->dyn_signature = NULL;
+				stmt->need_reprepare = 1;
+			}
+		}
 	} else if (ctx->parent) {
 		errs = &((TDS_ENV *) ctx->parent)->errs;
 	}
@@ -3467,6 +3494,22 @@ odbc_SQLExecute(TDS_STMT * stmt)
 
 	stmt->row_count = TDS_NO_COUNT;
 
+	if (stmt->num_param_rows > 1 && stmt->dbc->bulk_paramsets && !stmt->prepared_query_is_rpc
+	    && stmt->attr.cursor_type == SQL_CURSOR_FORWARD_ONLY && stmt->attr.concurrency == SQL_CONCUR_READ_ONLY) {
+		/* try to send all parameter rows with a single bulk copy */
+		SQLRETURN res = odbc_bcp_paramset(stmt);
+
+		if (res != SQL_NO_DATA) {
+			if (res == SQL_ERROR)
+				ODBC_SAFE_ERROR(stmt);
+			if (tds->state == TDS_IDLE) {
+				odbc_populate_ird(stmt);
+				odbc_unlock_statement(stmt);
+			}
+			ODBC_RETURN(stmt, res);
+		}
+	}
+
 	if (stmt->prepared_query_is_rpc) {
 		/* TODO support stmt->apd->header.sql_desc_array_size for RPC */
 		/* get rpc name */
@@ -3520,7 +3563,18 @@ odbc_SQLExecute(TDS_STMT * stmt)
 					ODBC_RETURN(stmt, SQL_ERROR);
 			}
 			stmt->need_reprepare = 0;
-			ret = tds71_submit_prepexec(tds, tds_dstr_cstr(&stmt->query), NULL, &stmt->dyn, stmt->params);
+			if (odbc_stmt_cache_get(stmt)) {
+				/* handle already prepared by another statement, just execute it */
+				TDSDYNAMIC *dyn = stmt->dyn;
+
+				tds_free_input_params(dyn);
+				dyn->params = stmt->params;
+				/* prevent double free */
+				stmt->params = NULL;
+				ret = tds_submit_execute(tds, dyn);
+			} else {
+				ret = tds71_submit_prepexec(tds, tds_dstr_cstr(&stmt->query), NULL, &stmt->dyn, stmt->params);
+			}
 	} else {
 		/* TODO cursor change way of calling */
 		/* SQLPrepare */
@@ -3536,18 +3590,20 @@ odbc_SQLExecute(TDS_STMT * stmt)
 			}
 			stmt->need_reprepare = 0;
 
-			tdsdump_log(TDS_DBG_INFO1, "Creating prepared statement\n");
-			/* TODO use tds_submit_prepexec (mssql2k, tds71) */
-			if (TDS_FAILED(tds_submit_prepare(tds, tds_dstr_cstr(&stmt->query), NULL, &stmt->dyn, stmt->params))) {
-				/* TODO ?? tds_free_param_results(params); */
-				ODBC_SAFE_ERROR(stmt);
-				return SQL_ERROR;
-			}
-			if (TDS_FAILED(tds_process_simple_query(tds))) {
-				tds_release_dynamic(&stmt->dyn);
-				/* TODO ?? tds_free_param_results(params); */
-				ODBC_SAFE_ERROR(stmt);
-				return SQL_ERROR;
+			if (!odbc_stmt_cache_get(stmt)) {
+				tdsdump_log(TDS_DBG_INFO1, "Creating prepared statement\n");
+				/* TODO use tds_submit_prepexec (mssql2k, tds71) */
+				if (TDS_FAILED(tds_submit_prepare(tds, tds_dstr_cstr(&stmt->query), NULL, &stmt->dyn, stmt->params))) {
+					/* TODO ?? tds_free_param_results(params); */
+					ODBC_SAFE_ERROR(stmt);
+					return SQL_ERROR;
+				}
+				if (TDS_FAILED(tds_process_simple_query(tds))) {
+					tds_release_dynamic(&stmt->dyn);
+					/* TODO ?? tds_free_param_results(params); */
+					ODBC_SAFE_ERROR(stmt);
+					return SQL_ERROR;
+				}
 			}
 		}
 		stmt->row_count = TDS_NO_COUNT;
@@ -3900,8 +3956,40 @@ odbc_fix_data_type_col(TDS_STMT *stmt, int idx)
 	}
 }
 
+/**
+ * Compute how to copy every bound column, used for array fetches to
+ * avoid to compute types and conversions for every row.
+ * \return plan with an entry for every ARD record, NULL on memory error
+ */
+static const TDS_ODBC_COL_PLAN *
+odbc_build_fetch_plan(TDS_STMT * stmt, TDSRESULTINFO * resinfo)
+{
+	const TDS_DESC *const ard = stmt->ard;
+	int i, num_cols = ODBC_MIN(resinfo->num_cols, ard->header.sql_desc_count);
+
+	if (num_cols > stmt->fetch_plan_alloc) {
+		if (!TDS_RESIZE(stmt->fetch_plan, num_cols))
+			return NULL;
+		stmt->fetch_plan_alloc = num_cols;
+	}
+
+	for (i = 0; i < num_cols; i++) {
+		const struct _drecord *drec_ard = &ard->records[i];
+		TDS_ODBC_COL_PLAN *plan = &stmt->fetch_plan[i];
+		int c_type;
+
+		c_type = drec_ard->sql_desc_concise_type;
+		if (c_type == SQL_C_DEFAULT)
+			c_type = odbc_sql_to_c_type_default(stmt->ird->records[i].sql_desc_concise_type);
+		plan->c_type = c_type;
+		plan->octet_len = odbc_get_octet_len(c_type, drec_ard);
+		odbc_tds2sql_plan(plan, resinfo->columns[i], c_type);
+	}
+	return stmt->fetch_plan;
+}
+
 static SQLUSMALLINT
-copy_row(TDS_STMT * const stmt, const SQLLEN row_offset, const SQLULEN curr_row)
+copy_row(TDS_STMT * const stmt, const SQLLEN row_offset, const SQLULEN curr_row, const TDS_ODBC_COL_PLAN * plan)
 {
 	const TDS_DESC *const ard = stmt->ard;
 	TDSRESULTINFO *const resinfo = stmt->tds->current_results;
@@ -3942,22 +4030,35 @@ copy_row(TDS_STMT * const stmt, const SQLLEN row_offset, const SQLULEN curr_row)
 
 			colinfo->column_text_sqlgetdatapos = 0;
 			colinfo->column_iconv_left = 0;
-			c_type = drec_ard->sql_desc_concise_type;
-			if (c_type == SQL_C_DEFAULT)
-				c_type = odbc_sql_to_c_type_default(stmt->ird->records[i].sql_desc_concise_type);
-			if (row_offset || curr_row == 0) {
-				data_ptr += row_offset;
+			if (plan) {
+				c_type = plan[i].c_type;
+				if (row_offset || curr_row == 0)
+					data_ptr += row_offset;
+				else
+					data_ptr += plan[i].octet_len * curr_row;
 			} else {
-				data_ptr += odbc_get_octet_len(c_type, drec_ard) * curr_row;
+				c_type = drec_ard->sql_desc_concise_type;
+				if (c_type == SQL_C_DEFAULT)
+					c_type = odbc_sql_to_c_type_default(stmt->ird->records[i].sql_desc_concise_type);
+				if (row_offset || curr_row == 0) {
+					data_ptr += row_offset;
+				} else {
+					data_ptr += odbc_get_octet_len(c_type, drec_ard) * curr_row;
+				}
 			}
-			len = odbc_tds2sql_col(stmt, colinfo, c_type, data_ptr, drec_ard->sql_desc_octet_length, drec_ard);
-			if (len == SQL_NULL_DATA)
-				return SQL_ROW_ERROR;
-
-			if ((c_type == SQL_C_CHAR && len >= drec_ard->sql_desc_octet_length)
-			    || (c_type == SQL_C_BINARY && len > drec_ard->sql_desc_octet_length)) {
-				truncated = true;
-				stmt->errs.lastrc = SQL_SUCCESS_WITH_INFO;
+			if (plan && plan[i].kind != ODBC_COPY_CONVERT) {
+				/* fixed size data, cannot fail or be truncated */
+				len = odbc_tds2sql_fast(&plan[i], colinfo, data_ptr);
+			} else {
+				len = odbc_tds2sql_col(stmt, colinfo, c_type, data_ptr, drec_ard->sql_desc_octet_length, drec_ard);
+				if (len == SQL_NULL_DATA)
+					return SQL_ROW_ERROR;
+
+				if ((c_type == SQL_C_CHAR && len >= drec_ard->sql_desc_octet_length)
+				    || (c_type == SQL_C_BINARY && len > drec_ard->sql_desc_octet_length)) {
+					truncated = true;
+					stmt->errs.lastrc = SQL_SUCCESS_WITH_INFO;
+				}
 			}
 		}
 		if (drec_ard->sql_desc_octet_length_ptr)
@@ -3988,6 +4089,7 @@ odbc_SQLFetch(TDS_STMT * stmt, SQLSMALLINT FetchOrientation, SQLLEN FetchOffset)
 	bool truncated = false;
 
 	SQLLEN row_offset = 0;
+	const TDS_ODBC_COL_PLAN *plan = NULL;
 
 	tdsdump_log(TDS_DBG_FUNC, "odbc_SQLFetch(%p, %d, %d)\n", stmt, (int)FetchOrientation, (int)FetchOffset);
 
@@ -4161,7 +4263,10 @@ odbc_SQLFetch(TDS_STMT * stmt, SQLSMALLINT FetchOrientation, SQLLEN FetchOffset)
 
 		/* we got a row, return a row readed even if error (for ODBC specifications) */
 		++(*fetched_ptr);
-		row_status = copy_row(stmt, row_offset, curr_row);
+		/* bindings and columns cannot change while filling the rowset */
+		if (curr_row == 0 && num_rows > 1)
+			plan = odbc_build_fetch_plan(stmt, resinfo);
+		row_status = copy_row(stmt, row_offset, curr_row, plan);
 		if (row_status == SQL_ROW_SUCCESS_WITH_INFO)
 			truncated = true;
 
@@ -4410,6 +4515,8 @@ odbc_SQLFreeStmt(SQLHSTMT hstmt, SQLUSMALLINT fOption, int force)
 		tds_mutex_unlock(&stmt->dbc->mtx);
 
 		tds_dstr_free(&stmt->query);
+		free(stmt->dyn_signature);
+		free(stmt->fetch_plan);
 		tds_free_param_results(stmt->params);
 		odbc_errs_reset(&stmt->errs);
 		odbc_unlock_statement(stmt);
@@ -6099,6 +6206,9 @@ odbc_SQLGetInfo(TDS_DBC * dbc, SQLUSMALLINT fInfoType, SQLPOINTER rgbInfoValue,
 			return SQL_ERROR;
 		ULVAL = dbc->tds_socket->conn->s;
 		break;
+	case SQL_INFO_FREETDS_STMT_CACHE_HITS:
+		UIVAL = dbc->stmt_cache_hits;
+		break;
 	default:
 		odbc_log_unimplemented_type("SQLGetInfo", fInfoType);
 		odbc_errs_add(&dbc->errs, "HY092", "Option not supported");
@@ -6598,6 +6708,15 @@ ODBC_FUNC(SQLSetConnectAttr, (P(SQLHDBC,hdbc), P(SQLINTEGER,Attribute), P(SQLPOI
 				      params->terminator, params->termlen, params->vartype, params->table_column);
 		}
 		break;
+	case SQL_COPT_TDSODBC_IMPL_BCP_SENDCOLUMNS:
+		if (!ValuePtr)
+			odbc_errs_add(&dbc->errs, "HY009", NULL);
+		else {
+			struct tdsodbc_impl_bcp_sendcolumns_params *params =
+				(struct tdsodbc_impl_bcp_sendcolumns_params*)ValuePtr;
+			params->rows_sent = odbc_bcp_sendcolumns(dbc, params->columns, params->num_columns, params->num_rows);
+		}
+		break;
 	default:
 		odbc_errs_add(&dbc->errs, "HY092", NULL);
 		break;
@@ -7625,10 +7744,16 @@ odbc_free_dynamic(TDS_STMT * stmt)
 
 	tds = stmt->dbc->tds_socket;
 	if (!tds_needs_unprepare(tds->conn, stmt->dyn)) {
+		free(stmt->dyn_signature);
+		stmt->dyn_signature = NULL;
 		tds_release_dynamic(&stmt->dyn);
 		return SQL_SUCCESS;
 	}
 
+	/* keep it prepared for another statement */
+	if (odbc_stmt_cache_put(stmt))
+		return SQL_SUCCESS;
+
 	if (odbc_lock_statement(stmt)) {
 		if (TDS_SUCCEED(tds_submit_unprepare(stmt->tds, stmt->dyn))
 		    && TDS_SUCCEED(tds_process_simple_query(stmt->tds))) {
@@ -7647,6 +7772,198 @@ odbc_free_dynamic(TDS_STMT * stmt)
 	return SQL_ERROR;
 }
 
+/**
+ * Compute a string describing current database and parameter types.
+ * Server handle can be reused only if parameters are declared the same way
+ * and names in the query refer to the same objects.
+ */
+static char *
+odbc_stmt_cache_signature(TDS_STMT * stmt)
+{
+	TDSPARAMINFO *params = stmt->params;
+	const char *database = stmt->dbc->tds_socket->conn->env.database;
+	char *signature, *p;
+	int i, num_cols = params ? params->num_cols : 0;
+
+	if (!database)
+		database = "";
+
+	/* database with its length, then 6 numbers for each parameter */
+	signature = tds_new(char, 12 + strlen(database) + num_cols * 6 * 12 + 1);
+	if (!signature)
+		return NULL;
+
+	p = signature + sprintf(signature, "%u:%s;", (unsigned int) strlen(database), database);
+	for (i = 0; i < num_cols; ++i) {
+		const TDSCOLUMN *col = params->columns[i];
+
+		p += sprintf(p, "%d,%d,%d,%d,%d,%d;", col->column_type, col->on_server.column_type,
+			     col->on_server.column_size, col->column_prec, col->column_scale, col->column_output);
+	}
+	*p = 0;
+	return signature;
+}
+
+/**
+ * Check if a prepared statement is still usable
+ */
+static bool
+odbc_stmt_cache_alive(TDSCONNECTION * conn, TDSDYNAMIC * dyn)
+{
+	TDSDYNAMIC *cur;
+
+	if (dyn->defer_close || !tds_needs_unprepare(conn, dyn))
+		return false;
+
+	for (cur = conn->dyns; cur; cur = cur->next)
+		if (cur == dyn)
+			return true;
+	return false;
+}
+
+static void
+odbc_stmt_cache_free_entry(TDS_DBC * dbc, TDS_STMT_CACHE_ENTRY * entry)
+{
+	if (dbc->tds_socket && odbc_stmt_cache_alive(dbc->tds_socket->conn, entry->dyn))
+		tds_deferred_unprepare(dbc->tds_socket->conn, entry->dyn);
+	tds_release_dynamic(&entry->dyn);
+	tds_dstr_free(&entry->query);
+	free(entry->signature);
+	free(entry);
+}
+
+/**
+ * Remove least recently used prepared statements from connection cache.
+ * Must be called with connection mutex locked.
+ * \param max_entries  entries to keep, 0 to empty the cache
+ */
+static void
+odbc_stmt_cache_trim(TDS_DBC * dbc, unsigned int max_entries)
+{
+	TDS_STMT_CACHE_ENTRY **prev = &dbc->stmt_cache, *entry;
+	unsigned int n;
+
+	if (!max_entries)
+		dbc->stmt_cache_flush = 0;
+
+	for (n = 0; *prev && n < max_entries; ++n)
+		prev = &(*prev)->next;
+
+	while ((entry = *prev) != NULL) {
+		*prev = entry->next;
+		--dbc->stmt_cache_count;
+		tdsdump_log(TDS_DBG_INFO1, "statement cache: dropping %s\n", entry->dyn->id);
+		odbc_stmt_cache_free_entry(dbc, entry);
+	}
+}
+
+/**
+ * Take a prepared statement for current query and parameters from
+ * connection cache.
+ * If not found compute signature so statement prepared later can be
+ * stored in the cache.
+ * \return true if stmt->dyn has been set
+ */
+static bool
+odbc_stmt_cache_get(TDS_STMT * stmt)
+{
+	TDS_DBC *dbc = stmt->dbc;
+	TDS_STMT_CACHE_ENTRY **prev, *entry;
+	const char *query;
+
+	free(stmt->dyn_signature);
+	stmt->dyn_signature = NULL;
+	if (!dbc->stmt_cache_size)
+		return false;
+
+	stmt->dyn_signature = odbc_stmt_cache_signature(stmt);
+	if (!stmt->dyn_signature)
+		return false;
+
+	query = tds_dstr_cstr(&stmt->query);
+
+	tds_mutex_lock(&dbc->mtx);
+	if (dbc->stmt_cache_flush)
+		odbc_stmt_cache_trim(dbc, 0);
+
+	for (prev = &dbc->stmt_cache; (entry = *prev) != NULL; prev = &entry->next) {
+		if (strcmp(entry->signature, stmt->dyn_signature) == 0
+		    && strcmp(tds_dstr_cstr(&entry->query), query) == 0) {
+			*prev = entry->next;
+			--dbc->stmt_cache_count;
+			break;
+		}
+	}
+
+	if (entry && !odbc_stmt_cache_alive(dbc->tds_socket->conn, entry->dyn)) {
+		odbc_stmt_cache_free_entry(dbc, entry);
+		entry = NULL;
+	}
+
+	if (!entry) {
+		++dbc->stmt_cache_misses;
+		tds_mutex_unlock(&dbc->mtx);
+		tdsdump_log(TDS_DBG_INFO1, "statement cache: miss\n");
+		return false;
+	}
+
+	++dbc->stmt_cache_hits;
+	tds_mutex_unlock(&dbc->mtx);
+
+	tdsdump_log(TDS_DBG_INFO1, "statement cache: reusing %s\n", entry->dyn->id);
+	stmt->dyn = entry->dyn;
+	tds_dstr_free(&entry->query);
+	free(entry->signature);
+	free(entry);
+	return true;
+}
+
+/**
+ * Give statement prepared handle to connection cache instead of
+ * unpreparing it.
+ * \return true if stmt->dyn has been moved to the cache
+ */
+static bool
+odbc_stmt_cache_put(TDS_STMT * stmt)
+{
+	TDS_DBC *dbc = stmt->dbc;
+	TDS_STMT_CACHE_ENTRY *entry;
+	char *signature = stmt->dyn_signature;
+
+	stmt->dyn_signature = NULL;
+	if (!signature || !dbc->stmt_cache_size || !odbc_stmt_cache_alive(dbc->tds_socket->conn, stmt->dyn)) {
+		free(signature);
+		return false;
+	}
+
+	entry = tds_new0(TDS_STMT_CACHE_ENTRY, 1);
+	if (!entry) {
+		free(signature);
+		return false;
+	}
+	tds_dstr_init(&entry->query);
+	if (!tds_dstr_dup(&entry->query, &stmt->query)) {
+		free(entry);
+		free(signature);
+		return false;
+	}
+	entry->signature = signature;
+	entry->dyn = stmt->dyn;
+	stmt->dyn = NULL;
+
+	tdsdump_log(TDS_DBG_INFO1, "statement cache: storing %s\n", entry->dyn->id);
+
+	tds_mutex_lock(&dbc->mtx);
+	if (dbc->stmt_cache_flush)
+		odbc_stmt_cache_trim(dbc, 0);
+	entry->next = dbc->stmt_cache;
+	dbc->stmt_cache = entry;
+	++dbc->stmt_cache_count;
+	odbc_stmt_cache_trim(dbc, dbc->stmt_cache_size);
+	tds_mutex_unlock(&dbc->mtx);
+	return true;
+}
+
 /**
  * Close server cursors
  */
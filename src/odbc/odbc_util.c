@@ -35,7 +35,7 @@
 #include <freetds/utils/string.h>
 #include <freetds/convert.h>
 #include <freetds/enum_cap.h>
-#include <freetds/utils/bjoern-utf8.h>
+#include <freetds/utils/utf8.h>
 #include <odbcss.h>
 
 /**
@@ -324,8 +324,32 @@ odbc_set_string_flag(TDS_DBC *dbc, SQLPOINTER buffer, SQLINTEGER cbBuffer, void
 #ifndef NDEBUG
 		initial_size = cbBuffer;
 #endif
+		if (!dest) {
+			size_t chars, units;
+
+			tds_utf8_count(p, len, &chars, &units);
+			out_len = SIZEOF_SQLWCHAR == 2 ? units : chars;
+			p = p_end;
+		}
 		while (p < p_end) {
 			uint32_t u, state = UTF8_ACCEPT;
+			SQLINTEGER n = tds_utf8_ascii_len(p, p_end - p), i, copy;
+
+			/* copy ASCII characters directly */
+			if (n) {
+				out_len += n;
+				copy = cbBuffer > 1 ? cbBuffer - 1 : 0;
+				if (copy >= n)
+					copy = n;
+				else
+					result = SQL_SUCCESS_WITH_INFO;
+				for (i = 0; i < copy; ++i)
+					dest[i] = p[i];
+				dest += copy;
+				cbBuffer -= copy;
+				p += n;
+				continue;
+			}
 
 			while (decode_utf8(&state, &u, *p++) > UTF8_REJECT && p < p_end)
 				continue;
@@ -335,8 +359,6 @@ odbc_set_string_flag(TDS_DBC *dbc, SQLPOINTER buffer, SQLINTEGER cbBuffer, void
 			++out_len;
 			if (SIZEOF_SQLWCHAR == 2 && u >= 0x10000 && u < 0x110000u)
 				++out_len;
-			if (!dest)
-				continue;
 			if (SIZEOF_SQLWCHAR == 2 && u >= 0x10000) {
 				if (cbBuffer > 2 && u < 0x110000u) {
 					*dest++ = (SQLWCHAR) (0xd7c0 + (u >> 10));
@@ -374,8 +396,31 @@ odbc_set_string_flag(TDS_DBC *dbc, SQLPOINTER buffer, SQLINTEGER cbBuffer, void
 #ifndef NDEBUG
 		initial_size = cbBuffer;
 #endif
+		if (!dest) {
+			size_t chars;
+
+			tds_utf8_count(p, len, &chars, NULL);
+			out_len = chars;
+			p = p_end;
+		}
 		while (p < p_end) {
 			uint32_t u, state = UTF8_ACCEPT;
+			SQLINTEGER n = tds_utf8_ascii_len(p, p_end - p), copy;
+
+			/* copy ASCII characters directly */
+			if (n) {
+				out_len += n;
+				copy = cbBuffer > 1 ? cbBuffer - 1 : 0;
+				if (copy >= n)
+					copy = n;
+				else
+					result = SQL_SUCCESS_WITH_INFO;
+				memmove(dest, p, copy);
+				dest += copy;
+				cbBuffer -= copy;
+				p += n;
+				continue;
+			}
 
 			while (decode_utf8(&state, &u, *p++) > UTF8_REJECT && p < p_end)
 				continue;
@@ -383,8 +428,6 @@ odbc_set_string_flag(TDS_DBC *dbc, SQLPOINTER buffer, SQLINTEGER cbBuffer, void
 				break;
 
 			++out_len;
-			if (!dest)
-				continue;
 			if (cbBuffer > 1) {
 				*dest++ = u > 0x100 ? '?' : u;
 				--cbBuffer;
@@ -120,6 +120,65 @@ query_test(const char* expected, const char *expected_status)
 	ODBC_FREE();
 }
 
+/* fixed types copied directly to bound arrays */
+typedef struct
+{
+	SQLINTEGER i;
+	SQLLEN i_len;
+	SQLDOUBLE f;
+	SQLLEN f_len;
+	TIMESTAMP_STRUCT ts;
+	SQLLEN ts_len;
+} FixedRecord;
+
+static void
+fixed_test(int row_bind)
+{
+	FixedRecord recs[ARRAY_SIZE];
+	SQLINTEGER ints[ARRAY_SIZE];
+	SQLDOUBLE floats[ARRAY_SIZE];
+	TIMESTAMP_STRUCT tss[ARRAY_SIZE];
+	SQLLEN lens[3][ARRAY_SIZE];
+	SQLULEN processed;
+	unsigned int n;
+
+	odbc_reset_statement();
+
+	SQLSetStmtAttr(odbc_stmt, SQL_ATTR_ROW_ARRAY_SIZE, (void *) ARRAY_SIZE, 0);
+	SQLSetStmtAttr(odbc_stmt, SQL_ATTR_ROWS_FETCHED_PTR, &processed, 0);
+	if (row_bind) {
+		SQLSetStmtAttr(odbc_stmt, SQL_ATTR_ROW_BIND_TYPE, TDS_INT2PTR(sizeof(FixedRecord)), 0);
+		CHKBindCol(1, SQL_C_SLONG, &recs[0].i, 0, &recs[0].i_len, "S");
+		CHKBindCol(2, SQL_C_DOUBLE, &recs[0].f, 0, &recs[0].f_len, "S");
+		CHKBindCol(3, SQL_C_TYPE_TIMESTAMP, &recs[0].ts, 0, &recs[0].ts_len, "S");
+	} else {
+		SQLSetStmtAttr(odbc_stmt, SQL_ATTR_ROW_BIND_TYPE, SQL_BIND_BY_COLUMN, 0);
+		CHKBindCol(1, SQL_C_SLONG, ints, 0, lens[0], "S");
+		CHKBindCol(2, SQL_C_DOUBLE, floats, 0, lens[1], "S");
+		CHKBindCol(3, SQL_C_TYPE_TIMESTAMP, tss, 0, lens[2], "S");
+	}
+
+	CHKExecDirect(T("SELECT i, CONVERT(FLOAT, i) / 4, DATEADD(ms, i * 10, CONVERT(DATETIME, '2012-03-04 05:06:07')) "
+			"FROM #odbc_test ORDER BY i"), SQL_NTS, "S");
+	CHKFetch("S");
+
+	assert(processed == ARRAY_SIZE);
+	for (n = 0; n < processed; ++n) {
+		const SQLINTEGER i = row_bind ? recs[n].i : ints[n];
+		const SQLDOUBLE f = row_bind ? recs[n].f : floats[n];
+		const TIMESTAMP_STRUCT *ts = row_bind ? &recs[n].ts : &tss[n];
+		const SQLLEN ts_len = row_bind ? recs[n].ts_len : lens[2][n];
+
+		if (i != n + 1 || f != (n + 1) / 4.0 || ts_len != sizeof(TIMESTAMP_STRUCT)
+		    || ts->year != 2012 || ts->month != 3 || ts->day != 4 || ts->hour != 5 || ts->minute != 6
+		    || ts->second != 7 || ts->fraction != (n + 1) * 10000000u) {
+			fprintf(stderr, "Invalid fixed result at row %u\n", n);
+			exit(1);
+		}
+	}
+	CHKFetch("No");
+}
+
 int
 main(void)
 {
@@ -157,6 +216,11 @@ main(void)
 	printf("test line %d\n", __LINE__);
 	query_test("I", "!!!!!!!!!!");
 
+	printf("test line %d\n", __LINE__);
+	fixed_test(0);
+	printf("test line %d\n", __LINE__);
+	fixed_test(1);
+
 	/* TODO bind offset, SQLGetData, no bind, error */
 
 	odbc_disconnect();
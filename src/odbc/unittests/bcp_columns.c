@@ -0,0 +1,130 @@
+#include "common.h"
+#define TDSODBC_BCP
+#include <odbcss.h>
+
+/*
+ * Test bulk copy from column buffers (bcp_sendcolumns).
+ * Check data sent as is, converted and NULLs from validity bitmaps.
+ * Check also numbers converted to national strings and data longer
+ * than column size.
+ */
+
+#ifdef UNICODE
+typedef SQLWCHAR bcp_init_char_t;
+#else
+typedef char bcp_init_char_t;
+#endif
+
+#define NUM_ROWS 1000
+
+static int ids[NUM_ROWS];
+static char names[NUM_ROWS * 16];
+static int name_offsets[NUM_ROWS + 1];
+static unsigned char name_validity[(NUM_ROWS + 7) / 8];
+static double amounts[NUM_ROWS];
+static char codes[NUM_ROWS * 8];
+static int code_offsets[NUM_ROWS + 1];
+static char tags[NUM_ROWS * 8];
+static int tag_offsets[NUM_ROWS + 1];
+
+static void
+set_attr(void)
+{
+	SQLSetConnectAttr(odbc_conn, SQL_COPT_SS_BCP, (SQLPOINTER)SQL_BCP_ON, 0);
+}
+
+static void
+report_bcp_error(const char *errmsg, int line, const char *file)
+{
+	odbc_stmt = NULL;
+	odbc_report_error(errmsg, line, file);
+}
+
+static void
+fill_columns(void)
+{
+	int i, pos = 0, code_pos = 0;
+
+	for (i = 0; i < NUM_ROWS; ++i) {
+		ids[i] = i + 1;
+		name_offsets[i] = pos;
+		/* every 5th name is NULL */
+		if (i % 5 != 4) {
+			name_validity[i / 8] |= 1 << (i % 8);
+			pos += sprintf(names + pos, "name %d", i + 1);
+		}
+		amounts[i] = i * 0.5;
+		code_offsets[i] = code_pos;
+		code_pos += sprintf(codes + code_pos, "%d", (i + 1) * 7);
+		/* longer than column, should be truncated */
+		tag_offsets[i] = i * 8;
+		memcpy(tags + i * 8, "abcdefgh", 8);
+	}
+	name_offsets[NUM_ROWS] = pos;
+	code_offsets[NUM_ROWS] = code_pos;
+	tag_offsets[NUM_ROWS] = NUM_ROWS * 8;
+}
+
+int
+main(void)
+{
+	BCPCOLUMNDATA columns[6];
+	int rows_sent;
+
+	odbc_set_conn_attr = set_attr;
+	odbc_connect();
+
+	odbc_command("if exists (select 1 from sysobjects where type = 'U' and name = 'bcp_columns_unittest') "
+		     "drop table bcp_columns_unittest");
+	odbc_command("create table bcp_columns_unittest (id int not null, name varchar(20) null, "
+		     "amount float not null, code int not null, "
+		     "label nvarchar(20) not null, tag varbinary(4) not null)");
+
+	fill_columns();
+
+	memset(columns, 0, sizeof(columns));
+	/* same type, sent as is */
+	columns[0].vartype = BCP_TYPE_SQLINT4;
+	columns[0].values = ids;
+	/* strings with NULLs */
+	columns[1].vartype = BCP_TYPE_SQLVARCHAR;
+	columns[1].values = names;
+	columns[1].offsets = name_offsets;
+	columns[1].validity = name_validity;
+	columns[2].vartype = BCP_TYPE_SQLFLT8;
+	columns[2].values = amounts;
+	/* strings converted to int */
+	columns[3].vartype = BCP_TYPE_SQLVARCHAR;
+	columns[3].values = codes;
+	columns[3].offsets = code_offsets;
+	/* int converted to national strings */
+	columns[4].vartype = BCP_TYPE_SQLINT4;
+	columns[4].values = ids;
+	/* binary sent as is */
+	columns[5].vartype = BCP_TYPE_SQLVARBINARY;
+	columns[5].values = tags;
+	columns[5].offsets = tag_offsets;
+
+	if (bcp_init(odbc_conn, (bcp_init_char_t *) T("bcp_columns_unittest"), NULL, NULL, BCP_DIRECTION_IN) == FAIL)
+		report_bcp_error("bcp_init", __LINE__, __FILE__);
+
+	if (bcp_sendcolumns(odbc_conn, columns, 6, NUM_ROWS, &rows_sent) == FAIL || rows_sent != NUM_ROWS)
+		report_bcp_error("bcp_sendcolumns", __LINE__, __FILE__);
+
+	if (bcp_done(odbc_conn) != NUM_ROWS)
+		report_bcp_error("bcp_done", __LINE__, __FILE__);
+
+	odbc_check_no_row("IF (SELECT COUNT(*) FROM bcp_columns_unittest) <> 1000 SELECT 1");
+	odbc_check_no_row("IF (SELECT SUM(id) FROM bcp_columns_unittest) <> 500500 SELECT 1");
+	odbc_check_no_row("IF (SELECT COUNT(*) FROM bcp_columns_unittest WHERE name IS NULL) <> 200 SELECT 1");
+	odbc_check_no_row("IF EXISTS(SELECT * FROM bcp_columns_unittest WHERE name <> 'name ' + CONVERT(VARCHAR(10), id) "
+			  "OR amount <> (id - 1) * 0.5 OR code <> id * 7 "
+			  "OR label <> CONVERT(NVARCHAR(20), id) OR tag <> 0x61626364) SELECT 1");
+
+	odbc_command("drop table bcp_columns_unittest");
+
+	odbc_disconnect();
+
+	printf("Done.\n");
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include "common.h"
+
+/*
+ * Test INSERT with parameter arrays sent as bulk copy
+ * (BulkParamsets connection option).
+ * Check all rows are inserted with correct values and that
+ * statements not eligible for bulk copy still work.
+ * A trigger logs every INSERT statement, bulk copy fires it once.
+ */
+
+#define ARRAY_SIZE 100
+/* wider than the initial bulk copy buffer */
+#define BIG_SIZE 5000
+
+static SQLINTEGER ids[ARRAY_SIZE];
+static SQLLEN id_lens[ARRAY_SIZE];
+static char names[ARRAY_SIZE][20];
+static SQLLEN name_lens[ARRAY_SIZE];
+static double amounts[ARRAY_SIZE];
+static SQLLEN amount_lens[ARRAY_SIZE];
+static char bigs[ARRAY_SIZE][BIG_SIZE + 1];
+static SQLLEN big_lens[ARRAY_SIZE];
+static long big_total;
+static SQLUSMALLINT statuses[ARRAY_SIZE];
+static SQLULEN processed;
+
+static void
+bind_params(void)
+{
+	int i;
+
+	big_total = 0;
+	for (i = 0; i < ARRAY_SIZE; ++i) {
+		int len = BIG_SIZE - ARRAY_SIZE + i;
+
+		ids[i] = i + 1;
+		id_lens[i] = 0;
+		sprintf(names[i], "name %d \xf4", i);
+		name_lens[i] = SQL_NTS;
+		amounts[i] = i * 0.5;
+		/* some NULLs */
+		amount_lens[i] = (i % 10) == 3 ? SQL_NULL_DATA : 0;
+		memset(bigs[i], 'a' + i % 26, len);
+		bigs[i][len] = 0;
+		big_lens[i] = SQL_NTS;
+		big_total += len;
+		statuses[i] = SQL_PARAM_DIAG_UNAVAILABLE;
+	}
+	processed = ARRAY_SIZE + 1;
+
+	odbc_reset_statement();
+	CHKSetStmtAttr(SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER) SQL_PARAM_BIND_BY_COLUMN, 0, "S");
+	CHKSetStmtAttr(SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER) ARRAY_SIZE, 0, "S");
+	CHKSetStmtAttr(SQL_ATTR_PARAM_STATUS_PTR, statuses, 0, "S");
+	CHKSetStmtAttr(SQL_ATTR_PARAMS_PROCESSED_PTR, &processed, 0, "S");
+	CHKBindParameter(1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, ids, 0, id_lens, "S");
+	CHKBindParameter(2, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, 19, 0, names, sizeof(names[0]), name_lens, "S");
+	CHKBindParameter(3, SQL_PARAM_INPUT, SQL_C_DOUBLE, SQL_NUMERIC, 10, 2, amounts, 0, amount_lens, "S");
+	CHKBindParameter(4, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, BIG_SIZE, 0, bigs, sizeof(bigs[0]), big_lens, "S");
+}
+
+static void
+check_insert(const char *query, bool bulk)
+{
+	SQLLEN rows;
+	int i;
+	char sql[256];
+
+	odbc_command("DELETE FROM bulk_paramset");
+	odbc_command("DELETE FROM bulk_paramset_log");
+	bind_params();
+
+	CHKExecDirect(T(query), SQL_NTS, "S");
+	CHKRowCount(&rows, "S");
+	if (rows != ARRAY_SIZE || processed != ARRAY_SIZE) {
+		fprintf(stderr, "Wrong row count %d processed %d\n", (int) rows, (int) processed);
+		exit(1);
+	}
+	for (i = 0; i < ARRAY_SIZE; ++i) {
+		if (statuses[i] != SQL_PARAM_SUCCESS) {
+			fprintf(stderr, "Wrong status %d for row %d\n", statuses[i], i);
+			exit(1);
+		}
+	}
+
+	odbc_reset_statement();
+	odbc_check_no_row("IF (SELECT COUNT(*) FROM bulk_paramset) <> 100 SELECT 1");
+	odbc_check_no_row("IF (SELECT SUM(id) FROM bulk_paramset) <> 5050 SELECT 1");
+	odbc_check_no_row("IF NOT EXISTS(SELECT * FROM bulk_paramset WHERE id = 8 AND name = 'name 7 \xf4' "
+			  "AND amount = 3.5 AND n = 0) SELECT 1");
+	odbc_check_no_row("IF (SELECT COUNT(*) FROM bulk_paramset WHERE amount IS NULL) <> 10 SELECT 1");
+	sprintf(sql, "IF (SELECT SUM(CAST(DATALENGTH(big) AS BIGINT)) FROM bulk_paramset) <> %ld SELECT 1", big_total);
+	odbc_check_no_row(sql);
+	odbc_check_no_row("IF NOT EXISTS(SELECT * FROM bulk_paramset WHERE id = 3 "
+			  "AND big = REPLICATE('c', 4902)) SELECT 1");
+
+	/* bulk copy fires the trigger once for all rows */
+	if (bulk)
+		odbc_check_no_row("IF (SELECT COUNT(*) FROM bulk_paramset_log) <> 1 SELECT 1");
+	else
+		odbc_check_no_row("IF (SELECT COUNT(*) FROM bulk_paramset_log) <> 100 SELECT 1");
+}
+
+int
+main(void)
+{
+	odbc_conn_additional_params = "BulkParamsets=Yes;";
+
+	odbc_connect();
+	if (!odbc_db_is_microsoft() || !odbc_driver_is_freetds()) {
+		odbc_disconnect();
+		printf("Test for MSSQL using FreeTDS driver only, exiting\n");
+		odbc_test_skipped();
+		return 0;
+	}
+
+	odbc_command("IF OBJECT_ID('bulk_paramset') IS NOT NULL DROP TABLE bulk_paramset");
+	odbc_command("IF OBJECT_ID('bulk_paramset_log') IS NOT NULL DROP TABLE bulk_paramset_log");
+	odbc_command("CREATE TABLE bulk_paramset (id INT NOT NULL, name VARCHAR(20) NULL, "
+		     "n INT NOT NULL DEFAULT 0, amount NUMERIC(10,2) NULL, big VARCHAR(5000) NULL)");
+	odbc_command("CREATE TABLE bulk_paramset_log (num_rows INT NOT NULL)");
+	odbc_command("CREATE TRIGGER bulk_paramset_trg ON bulk_paramset AFTER INSERT AS SET NOCOUNT ON "
+		     "INSERT INTO bulk_paramset_log SELECT COUNT(*) FROM inserted");
+
+	/* sent using bulk copy */
+	check_insert("INSERT INTO bulk_paramset(id, name, amount, big) VALUES(?, ?, ?, ?)", true);
+	check_insert("insert [bulk_paramset] ( [id], name,amount, big ) values ( ?,?, ? ,?) ;", true);
+	/* not eligible for bulk copy, executed as usual */
+	check_insert("INSERT INTO bulk_paramset(id, name, amount, big) VALUES(?, ?, ? + 0, ?)", false);
+
+	odbc_reset_statement();
+	odbc_command("DROP TABLE bulk_paramset");
+	odbc_command("DROP TABLE bulk_paramset_log");
+
+	odbc_disconnect();
+
+	printf("Done.\n");
+	return 0;
+}
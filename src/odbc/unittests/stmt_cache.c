@@ -0,0 +1,128 @@
+#include "common.h"
+#include <odbcss.h>
+
+/*
+ * Test prepared statement cache (StatementCacheSize connection option).
+ * Statements with same query and parameter types reuse the handle
+ * prepared by a previous statement, check results are still correct
+ * and that changing parameter types or database prepare the query again.
+ */
+
+static SQLUINTEGER
+cache_hits(void)
+{
+	SQLUINTEGER hits = 0;
+	SQLSMALLINT len;
+
+	CHKGetInfo(SQL_INFO_FREETDS_STMT_CACHE_HITS, &hits, sizeof(hits), &len, "S");
+	return hits;
+}
+
+static void
+check_hits(SQLUINTEGER expected)
+{
+	SQLUINTEGER hits = cache_hits();
+
+	if (hits != expected) {
+		fprintf(stderr, "Wrong cache hits %u expected %u\n", (unsigned) hits, (unsigned) expected);
+		exit(1);
+	}
+}
+
+static void
+use_database(const char *name)
+{
+	char sql[600];
+
+	CHKAllocStmt(&odbc_stmt, "S");
+	sprintf(sql, "USE %s", name);
+	odbc_command(sql);
+	CHKFreeStmt(SQL_DROP, "S");
+	odbc_stmt = SQL_NULL_HSTMT;
+}
+
+static void
+Test(int n, SQLSMALLINT sql_type, SQLULEN size)
+{
+	SQLINTEGER in = n, out = 0;
+	char buf[16];
+	SQLLEN ind = 0, out_ind = 0;
+
+	CHKAllocStmt(&odbc_stmt, "S");
+
+	if (sql_type == SQL_INTEGER) {
+		CHKBindParameter(1, SQL_PARAM_INPUT, SQL_C_SLONG, SQL_INTEGER, 0, 0, &in, 0, &ind, "S");
+	} else {
+		sprintf(buf, "%d", n);
+		ind = strlen(buf);
+		CHKBindParameter(1, SQL_PARAM_INPUT, SQL_C_CHAR, sql_type, size, 0, buf, sizeof(buf), &ind, "S");
+	}
+
+	CHKPrepare(T("SELECT CONVERT(INT, ?) + 1"), SQL_NTS, "S");
+	CHKExecute("S");
+
+	CHKBindCol(1, SQL_C_SLONG, &out, 0, &out_ind, "S");
+	CHKFetch("S");
+	if (out != n + 1) {
+		fprintf(stderr, "Wrong result %d expected %d\n", (int) out, n + 1);
+		exit(1);
+	}
+	CHKFetch("No");
+	CHKMoreResults("No");
+
+	CHKFreeStmt(SQL_DROP, "S");
+	odbc_stmt = SQL_NULL_HSTMT;
+}
+
+int
+main(void)
+{
+	int i;
+
+	odbc_conn_additional_params = "StatementCacheSize=2;";
+
+	odbc_connect();
+	if (!odbc_driver_is_freetds()) {
+		odbc_disconnect();
+		printf("Driver is not FreeTDS, exiting\n");
+		odbc_test_skipped();
+		return 0;
+	}
+
+	/* connection statement is not used */
+	CHKFreeStmt(SQL_DROP, "S");
+	odbc_stmt = SQL_NULL_HSTMT;
+
+	/* two signatures fit in the cache, all but first executions reuse handles */
+	for (i = 0; i < 4; ++i) {
+		Test(i, SQL_INTEGER, 0);
+		Test(i + 10, SQL_VARCHAR, 10);
+	}
+	check_hits(6);
+
+	/* other parameter types need new handles */
+	Test(20, SQL_VARCHAR, 20);
+	Test(30, SQL_WVARCHAR, 10);
+	check_hits(6);
+	Test(31, SQL_WVARCHAR, 10);
+	check_hits(7);
+
+	/* handles prepared in another database are not reused */
+	if (odbc_database[0]) {
+		use_database(strcasecmp(odbc_database, "tempdb") == 0 ? "master" : "tempdb");
+		Test(32, SQL_WVARCHAR, 10);
+		check_hits(7);
+		Test(33, SQL_WVARCHAR, 10);
+		check_hits(8);
+
+		/* back to original database, its handle is still cached */
+		use_database(odbc_database);
+		Test(34, SQL_WVARCHAR, 10);
+		check_hits(9);
+	}
+
+	odbc_disconnect();
+
+	printf("Done.\n");
+	return 0;
+}
@@ -45,7 +45,7 @@
 #include <freetds/bytes.h>
 #include <freetds/iconv.h>
 #include <freetds/bool.h>
-#include <freetds/utils/bjoern-utf8.h>
+#include <freetds/utils/utf8.h>
 
 #include "iconv_charsets.h"
 
@@ -56,7 +56,9 @@
 
 enum ICONV_CD_VALUE
 {
-	Like_to_Like = 0x100
+	Like_to_Like = 0x100,
+	/* (UTF-8 << 4) | UTF-16LE, see tds_sys_iconv_open */
+	Utf8_to_Utf16le = 0x62
 };
 
 typedef uint32_t ICONV_CHAR;
@@ -441,6 +443,8 @@ tds_sys_iconv (iconv_t cd, const char* * inbuf, size_t *inbytesleft, char* * out
 		il -= copybytes;
 	} else if (CD & ~0xff) {
 		local_errno = EINVAL;
+	} else if (CD == Utf8_to_Utf16le) {
+		local_errno = tds_utf8_to_utf16le(&ib, &il, &ob, &ol);
 	} else {
 		iconv_get_t get_func = iconv_gets[(CD>>4) & 15];
 		iconv_put_t put_func = iconv_puts[ CD     & 15];
@@ -44,6 +44,8 @@
 #include <freetds/iconv.h>
 #include <freetds/stream.h>
 #include <freetds/convert.h>
+#define TDS_DONT_DEFINE_DEFAULT_FUNCTIONS
+#include <freetds/data.h>
 #include <freetds/utils/string.h>
 #include <freetds/replacements.h>
 
@@ -73,6 +75,7 @@ static int tds5_bcp_add_fixed_columns(TDSBCPINFO *bcpinfo, tds_bcp_get_col_data
 static int tds5_bcp_add_variable_columns(TDSBCPINFO *bcpinfo, tds_bcp_get_col_data get_col_data, tds_bcp_null_error null_error,
 					 int offset, TDS_UCHAR *rowbuffer, int start, int *pncols);
 static void tds_bcp_row_free(TDSRESULTINFO* result, unsigned char *row);
+static TDSRET tds_bcp_build_plan(TDSSOCKET *tds, TDSBCPINFO *bcpinfo);
 static TDSRET tds5_process_insert_bulk_reply(TDSSOCKET * tds, TDSBCPINFO *bcpinfo);
 
 /**
@@ -326,6 +329,48 @@ tds_bcp_start_insert_stmt(TDSSOCKET * tds, TDSBCPINFO * bcpinfo)
 	return TDS_SUCCESS;
 }
 
+/**
+ * Write data of a column which can be written directly, without calling put_data.
+ * Follows what tds_generic_put does for these types.
+ */
+static void
+tds7_bcp_put_simple(TDSSOCKET *tds, const TDSBCPCOLPLAN *plan, const BCPCOLDATA *coldata)
+{
+	const TDSCOLUMN *bindcol = plan->col;
+	const unsigned char *src = coldata->data;
+	TDS_INT len = plan->size;
+#ifdef WORDS_BIGENDIAN
+	unsigned char buf[64];
+#endif
+
+	if (plan->writer != TDS_BCP_WRITE_FIXED) {
+		if (coldata->is_null) {
+			if (plan->writer == TDS_BCP_WRITE_BYTELEN)
+				tds_put_byte(tds, 0);
+			else
+				tds_put_smallint(tds, -1);
+			return;
+		}
+		if (coldata->datalen < len)
+			len = coldata->datalen;
+		if (plan->writer == TDS_BCP_WRITE_BYTELEN)
+			tds_put_byte(tds, len);
+		else
+			tds_put_smallint(tds, len);
+	}
+
+#ifdef WORDS_BIGENDIAN
+	if (len < 64) {
+		memcpy(buf, src, len);
+		tds_swap_datatype(tds_get_conversion_type(bindcol->column_type, len), buf);
+		src = buf;
+	}
+#else
+	(void) bindcol;
+#endif
+	tds_put_n(tds, src, len);
+}
+
 static TDSRET
 tds7_send_record(TDSSOCKET *tds, TDSBCPINFO *bcpinfo,
 		 tds_bcp_get_col_data get_col_data, tds_bcp_null_error null_error, int offset)
@@ -333,53 +378,51 @@ tds7_send_record(TDSSOCKET *tds, TDSBCPINFO *bcpinfo,
 	int i;
 
 	tds_put_byte(tds, TDS_ROW_TOKEN);   /* 0xd1 */
-	for (i = 0; i < bcpinfo->bindinfo->num_cols; i++) {
+	for (i = 0; i < bcpinfo->plan_count; i++) {
 
+		const TDSBCPCOLPLAN *plan = &bcpinfo->plan[i];
 		TDS_INT save_size;
 		unsigned char *save_data;
 		TDSBLOB blob;
-		TDSCOLUMN  *bindcol;
+		TDSCOLUMN  *bindcol = plan->col;
+		BCPCOLDATA *coldata;
 		TDSRET rc;
 
-		bindcol = bcpinfo->bindinfo->columns[i];
-
-		/*
-		 * Don't send the (meta)data for timestamp columns or
-		 * identity columns unless indentity_insert is enabled.
-		 */
-
-		if ((!bcpinfo->identity_insert_on && bindcol->column_identity) ||
-			bindcol->column_timestamp ||
-			bindcol->column_computed) {
-			continue;
-		}
+		/* timestamp, computed and (if not inserting) identity columns are not in the plan */
 
 		rc = get_col_data(bcpinfo, bindcol, offset);
 		if (TDS_FAILED(rc)) {
-			tdsdump_log(TDS_DBG_INFO1, "get_col_data (column %d) failed\n", i + 1);
+			tdsdump_log(TDS_DBG_INFO1, "get_col_data (column %d) failed\n", plan->index + 1);
 			return rc;
 		}
+		coldata = bindcol->bcp_column_data;
 		tdsdump_log(TDS_DBG_INFO1, "gotten column %d length %d null %d\n",
-				i + 1, bindcol->bcp_column_data->datalen, bindcol->bcp_column_data->is_null);
+				plan->index + 1, coldata->datalen, coldata->is_null);
+
+		if (coldata->is_null && !plan->nullable) {
+			if (null_error)
+				null_error(bcpinfo, plan->index, offset);
+			return TDS_FAIL;
+		}
+
+		if (plan->writer != TDS_BCP_WRITE_GENERIC && !(coldata->is_null && plan->writer == TDS_BCP_WRITE_FIXED)) {
+			tds7_bcp_put_simple(tds, plan, coldata);
+			continue;
+		}
 
 		save_size = bindcol->column_cur_size;
 		save_data = bindcol->column_data;
 		assert(bindcol->column_data == NULL);
-		if (bindcol->bcp_column_data->is_null) {
-			if (!bindcol->column_nullable && !is_nullable_type(bindcol->on_server.column_type)) {
-				if (null_error)
-					null_error(bcpinfo, i, offset);
-				return TDS_FAIL;
-			}
+		if (coldata->is_null) {
 			bindcol->column_cur_size = -1;
 		} else if (is_blob_col(bindcol)) {
-			bindcol->column_cur_size = bindcol->bcp_column_data->datalen;
+			bindcol->column_cur_size = coldata->datalen;
 			memset(&blob, 0, sizeof(blob));
-			blob.textvalue = (TDS_CHAR *) bindcol->bcp_column_data->data;
+			blob.textvalue = (TDS_CHAR *) coldata->data;
 			bindcol->column_data = (unsigned char *) &blob;
 		} else {
-			bindcol->column_cur_size = bindcol->bcp_column_data->datalen;
-			bindcol->column_data = bindcol->bcp_column_data->data;
+			bindcol->column_cur_size = coldata->datalen;
+			bindcol->column_data = coldata->data;
 		}
 		rc = bindcol->funcs->put_data(tds, bindcol, 1);
 		bindcol->column_cur_size = save_size;
@@ -436,24 +479,22 @@ tds5_send_record(TDSSOCKET *tds, TDSBCPINFO *bcpinfo,
 
 	blob_cols = 0;
 
-	for (i = 0; i < bcpinfo->bindinfo->num_cols; i++) {
-		TDSCOLUMN  *bindcol = bcpinfo->bindinfo->columns[i];
-		if (is_blob_type(bindcol->on_server.column_type)) {
-			TDS_PROPAGATE(get_col_data(bcpinfo, bindcol, offset));
-			/* unknown but zero */
-			tds_put_smallint(tds, 0);
-			TDS_PUT_BYTE(tds, bindcol->on_server.column_type);
-			tds_put_byte(tds, 0xff - blob_cols);
-			/*
-			 * offset of txptr we stashed during variable
-			 * column processing
-			 */
-			tds_put_smallint(tds, bindcol->column_textpos);
-			tds_put_int(tds, bindcol->bcp_column_data->datalen);
-			tds_put_n(tds, bindcol->bcp_column_data->data, bindcol->bcp_column_data->datalen);
-			blob_cols++;
+	for (i = bcpinfo->plan_fixed + bcpinfo->plan_variable; i < bcpinfo->plan_count; i++) {
+		TDSCOLUMN  *bindcol = bcpinfo->plan[i].col;
 
-		}
+		TDS_PROPAGATE(get_col_data(bcpinfo, bindcol, offset));
+		/* unknown but zero */
+		tds_put_smallint(tds, 0);
+		TDS_PUT_BYTE(tds, bindcol->on_server.column_type);
+		tds_put_byte(tds, 0xff - blob_cols);
+		/*
+		 * offset of txptr we stashed during variable
+		 * column processing
+		 */
+		tds_put_smallint(tds, bindcol->column_textpos);
+		tds_put_int(tds, bindcol->bcp_column_data->datalen);
+		tds_put_n(tds, bindcol->bcp_column_data->data, bindcol->bcp_column_data->datalen);
+		blob_cols++;
 	}
 	return TDS_SUCCESS;
 }
@@ -488,6 +529,350 @@ tds_bcp_send_record(TDSSOCKET *tds, TDSBCPINFO *bcpinfo,
 	return rc;
 }
 
+/** Number of rows converted at once by tds_bcp_send_columns */
+#define TDS_BCP_COLUMNS_CHUNK 256
+
+/** How data of a column buffer are converted */
+enum tds_bcp_colbuf_kernel
+{
+	TDS_BCP_COLBUF_DIRECT,	/**< data sent as is, no copy */
+	TDS_BCP_COLBUF_ICONV,	/**< character data converted to server encoding */
+	TDS_BCP_COLBUF_CONVERT	/**< data converted to column type */
+};
+
+/** Conversion state of a column for tds_bcp_send_columns */
+typedef struct tds_bcp_colbuf_state
+{
+	const TDSBCPCOLBUF *buf;
+	TDSCOLUMN *col;
+	enum tds_bcp_colbuf_kernel kernel;
+	TDS_SERVER_TYPE desttype;
+	/** size of source values for fixed types */
+	TDS_INT elem_size;
+	/** data allocated for bcp_column_data, restored at the end */
+	TDS_UCHAR *saved_data;
+	/** converted data of current chunk */
+	TDS_UCHAR *staging;
+	size_t staging_size;
+	/** position of data of each row, in values or staging */
+	size_t pos[TDS_BCP_COLUMNS_CHUNK];
+	/** length of data of each row, -1 for NULL */
+	TDS_INT len[TDS_BCP_COLUMNS_CHUNK];
+} TDSBCPCOLBUFSTATE;
+
+/* data are already filled by tds_bcp_send_columns */
+static TDSRET
+tds_bcp_colbuf_get_col_data(TDSBCPINFO *bcpinfo TDS_UNUSED, TDSCOLUMN *bindcol TDS_UNUSED, int offset TDS_UNUSED)
+{
+	return TDS_SUCCESS;
+}
+
+static bool
+tds_bcp_colbuf_reserve(TDSBCPCOLBUFSTATE *state, size_t used, size_t needed)
+{
+	if (used + needed <= state->staging_size)
+		return true;
+	needed = MAX(used + needed, state->staging_size * 2);
+	if (!TDS_RESIZE(state->staging, needed))
+		return false;
+	state->staging_size = needed;
+	return true;
+}
+
+/**
+ * Convert rows of a column buffer.
+ * Type checks are done once per column so the loops do only the copy or
+ * conversion needed.
+ * \return number of rows converted, less than num_rows on error
+ */
+static TDS_INT
+tds_bcp_colbuf_convert(TDSSOCKET *tds, TDSBCPCOLBUFSTATE *state, TDS_INT first, TDS_INT num_rows)
+{
+	const TDSBCPCOLBUF *buf = state->buf;
+	const TDS_UCHAR *values = (const TDS_UCHAR *) buf->values;
+	const TDS_INT *offsets = buf->offsets;
+	TDSCOLUMN *col = state->col;
+	size_t used = 0;
+	TDS_INT i;
+
+	/* NULLs first, data loops below skip them */
+	for (i = 0; i < num_rows; ++i) {
+		const TDS_INT row = first + i;
+
+		state->len[i] = 0;
+		if (!values || (buf->validity && !(buf->validity[row >> 3] & (1 << (row & 7)))))
+			state->len[i] = -1;
+	}
+
+	switch (state->kernel) {
+	case TDS_BCP_COLBUF_DIRECT:
+		if (offsets) {
+			for (i = 0; i < num_rows; ++i) {
+				if (state->len[i] < 0)
+					continue;
+				state->pos[i] = offsets[first + i];
+				state->len[i] = offsets[first + i + 1] - offsets[first + i];
+				/* truncate data too long, as tds_generic_put does */
+				if (state->len[i] > col->column_size)
+					state->len[i] = col->column_size;
+			}
+		} else {
+			for (i = 0; i < num_rows; ++i) {
+				if (state->len[i] < 0)
+					continue;
+				state->pos[i] = (size_t) (first + i) * state->elem_size;
+				state->len[i] = state->elem_size;
+			}
+		}
+		break;
+
+	case TDS_BCP_COLBUF_ICONV:
+		for (i = 0; i < num_rows; ++i) {
+			const char *src;
+			char *dest;
+			size_t srclen, destlen;
+
+			if (state->len[i] < 0)
+				continue;
+			src = (const char *) values + offsets[first + i];
+			srclen = offsets[first + i + 1] - offsets[first + i];
+			state->pos[i] = used;
+			for (;;) {
+				if (!tds_bcp_colbuf_reserve(state, used, srclen * 2 + 4))
+					return i;
+				dest = (char *) state->staging + used;
+				destlen = state->staging_size - used;
+				if (tds_iconv(tds, col->char_conv, to_server, &src, &srclen, &dest, &destlen) != (size_t) -1)
+					break;
+				used = dest - (char *) state->staging;
+				if (errno != E2BIG)
+					return i;
+			}
+			used = dest - (char *) state->staging;
+			state->len[i] = (TDS_INT) (used - state->pos[i]);
+		}
+		break;
+
+	case TDS_BCP_COLBUF_CONVERT:
+		if (!is_char_type(state->desttype) && !is_binary_type(state->desttype)) {
+			/* fixed results, convert the whole chunk in a single call */
+			const void *srcs[TDS_BCP_COLUMNS_CHUNK];
+			TDS_UINT srclens[TDS_BCP_COLUMNS_CHUNK];
+			unsigned char nulls[TDS_BCP_COLUMNS_CHUNK];
+			CONV_RESULT *cr;
+			TDS_INT converted;
+
+			if (!tds_bcp_colbuf_reserve(state, 0, num_rows * sizeof(CONV_RESULT)))
+				return 0;
+			cr = (CONV_RESULT *) state->staging;
+			for (i = 0; i < num_rows; ++i) {
+				state->pos[i] = i * sizeof(CONV_RESULT);
+				nulls[i] = state->len[i] < 0;
+				srcs[i] = NULL;
+				srclens[i] = 0;
+				if (nulls[i])
+					continue;
+				if (offsets) {
+					srcs[i] = values + offsets[first + i];
+					srclens[i] = offsets[first + i + 1] - offsets[first + i];
+				} else {
+					srcs[i] = values + (size_t) (first + i) * state->elem_size;
+					srclens[i] = state->elem_size;
+				}
+				if (is_numeric_type(state->desttype)) {
+					cr[i].n.precision = col->column_prec;
+					cr[i].n.scale = col->column_scale;
+				}
+			}
+			converted = tds_convert_batch(tds_get_ctx(tds), buf->type, srcs, srclens, num_rows,
+						      state->desttype, cr, state->len, nulls);
+			for (i = 0; i < converted; ++i)
+				if (nulls[i])
+					state->len[i] = -1;
+			return converted;
+		}
+
+		for (i = 0; i < num_rows; ++i) {
+			const TDS_UCHAR *src;
+			TDS_UINT srclen;
+			TDS_INT len;
+
+			if (state->len[i] < 0)
+				continue;
+			if (offsets) {
+				src = values + offsets[first + i];
+				srclen = offsets[first + i + 1] - offsets[first + i];
+			} else {
+				src = values + (size_t) (first + i) * state->elem_size;
+				srclen = state->elem_size;
+			}
+
+			/* character or binary results, retry if buffer was too small */
+			len = (TDS_INT) srclen * 2 + 64;
+			do {
+				CONV_RESULT res;
+
+				if (!tds_bcp_colbuf_reserve(state, used, len))
+					return i;
+				res.cc.c = (TDS_CHAR *) state->staging + used;
+				res.cc.len = (TDS_UINT) (state->staging_size - used);
+				len = tds_convert(tds_get_ctx(tds), buf->type, src, srclen,
+						  is_char_type(state->desttype) ? TDS_CONVERT_CHAR : TDS_CONVERT_BINARY, &res);
+				if (len < 0)
+					return i;
+			} while ((size_t) len > state->staging_size - used);
+			state->pos[i] = used;
+			state->len[i] = len;
+			used += len;
+
+			/* converted text is in client encoding, convert it again for the server */
+			if (is_char_type(state->desttype) && col->char_conv
+			    && !(col->char_conv->flags & TDS_ENCODING_MEMCPY)) {
+				size_t srcpos = state->pos[i], srclen = len, destlen;
+				const char *conv_src;
+				char *dest;
+
+				state->pos[i] = used;
+				for (;;) {
+					if (!tds_bcp_colbuf_reserve(state, used, srclen * 2 + 4))
+						return i;
+					/* staging could be moved by tds_bcp_colbuf_reserve */
+					conv_src = (const char *) state->staging + srcpos;
+					dest = (char *) state->staging + used;
+					destlen = state->staging_size - used;
+					if (tds_iconv(tds, col->char_conv, to_server, &conv_src, &srclen, &dest, &destlen) != (size_t) -1)
+						break;
+					used = dest - (char *) state->staging;
+					srcpos = conv_src - (const char *) state->staging;
+					if (errno != E2BIG)
+						return i;
+				}
+				used = dest - (char *) state->staging;
+				state->len[i] = (TDS_INT) (used - state->pos[i]);
+			}
+		}
+		break;
+	}
+	return num_rows;
+}
+
+/**
+ * Send many rows to server taking data from column buffers.
+ * Data are converted one column at a time for a chunk of rows, then the
+ * rows are encoded as tds_bcp_send_record does.
+ * Character data not converted (same type family) should be already in
+ * server encoding, as in other bulk copy functions.
+ * \tds
+ * \param bcpinfo BCP information, tds_bcp_start_copy_in should be already called
+ * \param columns data of columns, one for every column in bcpinfo->bindinfo
+ * \param num_rows number of rows to send
+ * \param null_error function to call if we try to send NULL if not allowed,
+ *        offset is the row number
+ * \param rows_sent receives the number of rows sent, can be NULL
+ * \return TDS_SUCCESS or TDS_FAIL.
+ */
+TDSRET
+tds_bcp_send_columns(TDSSOCKET *tds, TDSBCPINFO *bcpinfo, const TDSBCPCOLBUF *columns, TDS_INT num_rows,
+		     tds_bcp_null_error null_error, TDS_INT *rows_sent)
+{
+	TDSBCPCOLBUFSTATE *states;
+	const int num_cols = bcpinfo->bindinfo->num_cols;
+	TDS_INT first, chunk, converted, i;
+	TDSRET rc = TDS_SUCCESS;
+	int n;
+
+	tdsdump_log(TDS_DBG_FUNC, "tds_bcp_send_columns(%p, %p, %p, %d, %p, %p)\n",
+		    tds, bcpinfo, columns, num_rows, null_error, rows_sent);
+
+	if (rows_sent)
+		*rows_sent = 0;
+
+	states = tds_new0(TDSBCPCOLBUFSTATE, num_cols);
+	if (!states)
+		return TDS_FAIL;
+
+	/* choose how to convert every column */
+	for (n = 0; n < num_cols; ++n) {
+		TDSBCPCOLBUFSTATE *state = &states[n];
+		const TDSBCPCOLBUF *buf = &columns[n];
+		TDSCOLUMN *col = bcpinfo->bindinfo->columns[n];
+
+		state->buf = buf;
+		state->col = col;
+		state->saved_data = col->bcp_column_data->data;
+		state->desttype = tds_get_conversion_type(col->column_type, col->column_size);
+		if (!buf->values)
+			continue;
+
+		if (!is_tds_type_valid(buf->type) || (is_fixed_type(buf->type) != (buf->offsets == NULL))) {
+			tdsdump_log(TDS_DBG_ERROR, "tds_bcp_send_columns: wrong buffer for column %d\n", n + 1);
+			rc = TDS_FAIL;
+			goto cleanup;
+		}
+		state->elem_size = buf->offsets ? 0 : tds_get_size_by_type(buf->type);
+
+		if (buf->offsets && is_char_type(buf->type) && is_char_type(state->desttype))
+			state->kernel = col->char_conv && !(col->char_conv->flags & TDS_ENCODING_MEMCPY)
+					? TDS_BCP_COLBUF_ICONV : TDS_BCP_COLBUF_DIRECT;
+		else if (buf->offsets && is_binary_type(buf->type) && is_binary_type(state->desttype))
+			state->kernel = TDS_BCP_COLBUF_DIRECT;
+		else if (buf->type == state->desttype && !is_numeric_type(buf->type))
+			state->kernel = TDS_BCP_COLBUF_DIRECT;
+		else
+			state->kernel = TDS_BCP_COLBUF_CONVERT;
+	}
+
+	for (first = 0; first < num_rows; first += chunk) {
+		chunk = num_rows - first;
+		if (chunk > TDS_BCP_COLUMNS_CHUNK)
+			chunk = TDS_BCP_COLUMNS_CHUNK;
+
+		/* convert column by column, stop at first row with errors */
+		converted = chunk;
+		for (n = 0; n < num_cols; ++n) {
+			i = tds_bcp_colbuf_convert(tds, &states[n], first, converted);
+			if (i < converted) {
+				tdsdump_log(TDS_DBG_ERROR, "tds_bcp_send_columns: error converting column %d row %d\n",
+					    n + 1, first + i + 1);
+				converted = i;
+				rc = TDS_FAIL;
+			}
+		}
+
+		for (i = 0; i < converted; ++i) {
+			for (n = 0; n < num_cols; ++n) {
+				TDSBCPCOLBUFSTATE *state = &states[n];
+				BCPCOLDATA *coldata = state->col->bcp_column_data;
+
+				coldata->is_null = state->len[i] < 0;
+				coldata->datalen = coldata->is_null ? 0 : state->len[i];
+				if (coldata->is_null)
+					coldata->data = state->saved_data;
+				else if (state->kernel == TDS_BCP_COLBUF_DIRECT)
+					coldata->data = (TDS_UCHAR *) state->buf->values + state->pos[i];
+				else
+					coldata->data = state->staging + state->pos[i];
+			}
+			if (TDS_FAILED(tds_bcp_send_record(tds, bcpinfo, tds_bcp_colbuf_get_col_data, null_error, first + i))) {
+				rc = TDS_FAIL;
+				goto cleanup;
+			}
+			if (rows_sent)
+				*rows_sent = first + i + 1;
+		}
+		if (TDS_FAILED(rc))
+			break;
+	}
+
+cleanup:
+	for (n = 0; n < num_cols; ++n) {
+		states[n].col->bcp_column_data->data = states[n].saved_data;
+		free(states[n].staging);
+	}
+	free(states);
+	return rc;
+}
+
 static inline void
 tds5_swap_data(const TDSCOLUMN *col TDS_UNUSED, void *p TDS_UNUSED)
 {
@@ -522,33 +907,26 @@ tds5_bcp_add_fixed_columns(TDSBCPINFO *bcpinfo, tds_bcp_get_col_data get_col_dat
 	tdsdump_log(TDS_DBG_FUNC, "tds5_bcp_add_fixed_columns(%p, %p, %p, %d, %p, %d)\n",
 		    bcpinfo, get_col_data, null_error, offset, rowbuffer, start);
 
-	for (i = 0; i < bcpinfo->bindinfo->num_cols; i++) {
-
-		TDSCOLUMN *const bcpcol = bcpinfo->bindinfo->columns[i];
-		const TDS_INT column_size = bcpcol->on_server.column_size;
+	for (i = 0; i < bcpinfo->plan_fixed; i++) {
 
-		/* if possible check information from server */
-		if (bcpinfo->sybase_count > i) {
-			if (bcpinfo->sybase_colinfo[i].offset < 0)
-				continue;
-		} else {
-			if (is_nullable_type(bcpcol->on_server.column_type) || bcpcol->column_nullable)
-				continue;
-		}
+		TDSCOLUMN *const bcpcol = bcpinfo->plan[i].col;
+		const TDS_INT column_size = bcpinfo->plan[i].size;
 
-		tdsdump_log(TDS_DBG_FUNC, "tds5_bcp_add_fixed_columns column %d (%s) is a fixed column\n", i + 1, tds_dstr_cstr(&bcpcol->column_name));
+		tdsdump_log(TDS_DBG_FUNC, "tds5_bcp_add_fixed_columns column %d (%s) is a fixed column\n",
+			    bcpinfo->plan[i].index + 1, tds_dstr_cstr(&bcpcol->column_name));
 
 		if (TDS_FAILED(get_col_data(bcpinfo, bcpcol, offset))) {
-			tdsdump_log(TDS_DBG_INFO1, "get_col_data (column %d) failed\n", i + 1);
+			tdsdump_log(TDS_DBG_INFO1, "get_col_data (column %d) failed\n", bcpinfo->plan[i].index + 1);
 			return -1;
 		}
 
 		/* We have no way to send a NULL at this point, return error to client */
 		if (bcpcol->bcp_column_data->is_null) {
-			tdsdump_log(TDS_DBG_ERROR, "tds5_bcp_add_fixed_columns column %d is a null column\n", i + 1);
+			tdsdump_log(TDS_DBG_ERROR, "tds5_bcp_add_fixed_columns column %d is a null column\n",
+				    bcpinfo->plan[i].index + 1);
 			/* No value or default value available and NULL not allowed. */
 			if (null_error)
-				null_error(bcpinfo, i, offset);
+				null_error(bcpinfo, bcpinfo->plan[i].index, offset);
 			return -1;
 		}
 
@@ -604,6 +982,7 @@ tds5_bcp_add_variable_columns(TDSBCPINFO *bcpinfo, tds_bcp_get_col_data get_col_
 	TDS_USMALLINT offsets[256];
 	unsigned int i, row_pos;
 	unsigned int ncols = 0;
+	const TDSBCPCOLPLAN *plan = bcpinfo->plan + bcpinfo->plan_fixed;
 
 	assert(bcpinfo);
 	assert(rowbuffer);
@@ -629,23 +1008,12 @@ tds5_bcp_add_variable_columns(TDSBCPINFO *bcpinfo, tds_bcp_get_col_data get_col_
 
 	tdsdump_log(TDS_DBG_FUNC, "%4s %8s %8s %8s\n", "col", "ncols", "row_pos", "cpbytes");
 
-	for (i = 0; i < bcpinfo->bindinfo->num_cols; i++) {
+	/* columns of "variable" type, i.e. NULLable or naturally variable length e.g. VARCHAR */
+	for (i = 0; i < (unsigned int) bcpinfo->plan_variable; i++) {
 		unsigned int cpbytes = 0;
-		TDSCOLUMN *bcpcol = bcpinfo->bindinfo->columns[i];
-
-		/*
-		 * Is this column of "variable" type, i.e. NULLable
-		 * or naturally variable length e.g. VARCHAR
-		 */
-		if (bcpinfo->sybase_count > (TDS_INT) i) {
-			if (bcpinfo->sybase_colinfo[i].offset >= 0)
-				continue;
-		} else {
-			if (!is_nullable_type(bcpcol->on_server.column_type) && !bcpcol->column_nullable)
-				continue;
-		}
+		TDSCOLUMN *bcpcol = plan[i].col;
 
-		tdsdump_log(TDS_DBG_FUNC, "%4d %8d %8d %8d\n", i, ncols, row_pos, cpbytes);
+		tdsdump_log(TDS_DBG_FUNC, "%4d %8d %8d %8d\n", plan[i].index, ncols, row_pos, cpbytes);
 
 		if (TDS_FAILED(get_col_data(bcpinfo, bcpcol, offset)))
 			return -1;
@@ -655,7 +1023,7 @@ tds5_bcp_add_variable_columns(TDSBCPINFO *bcpinfo, tds_bcp_get_col_data get_col_
 		if (!bcpcol->column_nullable && bcpcol->bcp_column_data->is_null) {
 			/* No value or default value available and NULL not allowed. */
 			if (null_error)
-				null_error(bcpinfo, i, offset);
+				null_error(bcpinfo, plan[i].index, offset);
 			return -1;
 		}
 
@@ -1153,6 +1521,110 @@ tds_bcp_start_copy_in(TDSSOCKET *tds, TDSBCPINFO *bcpinfo)
 		}
 	}
 
+	return tds_bcp_build_plan(tds, bcpinfo);
+}
+
+/**
+ * Tell if a column is sent in the fixed part of a TDS 5.0 row.
+ */
+static bool
+tds5_bcp_is_fixed_col(TDSBCPINFO *bcpinfo, int i)
+{
+	TDSCOLUMN *bcpcol = bcpinfo->bindinfo->columns[i];
+
+	/* if possible check information from server */
+	if (bcpinfo->sybase_count > i)
+		return bcpinfo->sybase_colinfo[i].offset >= 0;
+	return !is_nullable_type(bcpcol->on_server.column_type) && !bcpcol->column_nullable;
+}
+
+/**
+ * Build the list of columns to send for every row, so per row
+ * functions do not have to check column attributes again.
+ * For TDS 5.0 fixed columns come first, then variable ones, then blobs.
+ * \tds
+ * \param bcpinfo BCP information, bindinfo should be already filled
+ */
+static TDSRET
+tds_bcp_build_plan(TDSSOCKET *tds, TDSBCPINFO *bcpinfo)
+{
+	TDSBCPCOLPLAN *plan;
+	TDSCOLUMN *bcpcol;
+	int i, pass, num_cols = bcpinfo->bindinfo->num_cols;
+
+	TDS_ZERO_FREE(bcpinfo->plan);
+	bcpinfo->plan_count = bcpinfo->plan_fixed = bcpinfo->plan_variable = 0;
+	if (!num_cols)
+		return TDS_SUCCESS;
+
+	/* TDS 5.0 blobs are both variable columns and in the blob list */
+	plan = bcpinfo->plan = tds_new0(TDSBCPCOLPLAN, num_cols * 2);
+	if (!plan)
+		return TDS_FAIL;
+
+	if (IS_TDS7_PLUS(tds->conn)) {
+		for (i = 0; i < num_cols; i++) {
+			bcpcol = bcpinfo->bindinfo->columns[i];
+
+			/*
+			 * Don't send the (meta)data for timestamp columns or
+			 * identity columns unless indentity_insert is enabled.
+			 */
+			if ((!bcpinfo->identity_insert_on && bcpcol->column_identity) ||
+			    bcpcol->column_timestamp || bcpcol->column_computed)
+				continue;
+
+			plan->col = bcpcol;
+			plan->index = i;
+			plan->nullable = bcpcol->column_nullable || is_nullable_type(bcpcol->on_server.column_type);
+			plan->writer = TDS_BCP_WRITE_GENERIC;
+			if (bcpcol->funcs->put_data == tds_generic_put && !is_blob_col(bcpcol)) {
+				switch (bcpcol->column_varint_size) {
+				case 0:
+					plan->writer = TDS_BCP_WRITE_FIXED;
+					plan->size = tds_get_size_by_type(bcpcol->on_server.column_type);
+					break;
+				case 1:
+					plan->writer = TDS_BCP_WRITE_BYTELEN;
+					plan->size = (TDS_INT) tds_fix_column_size(tds, bcpcol);
+					break;
+				case 2:
+					plan->writer = TDS_BCP_WRITE_SHORTLEN;
+					plan->size = (TDS_INT) tds_fix_column_size(tds, bcpcol);
+					break;
+				}
+			}
+			++plan;
+		}
+		bcpinfo->plan_count = (TDS_INT) (plan - bcpinfo->plan);
+		return TDS_SUCCESS;
+	}
+
+	/* pass 0 fixed columns, pass 1 variable columns, pass 2 blobs */
+	for (pass = 0; pass < 3; ++pass) {
+		for (i = 0; i < num_cols; i++) {
+			bcpcol = bcpinfo->bindinfo->columns[i];
+
+			if (pass == 2) {
+				if (!is_blob_type(bcpcol->on_server.column_type))
+					continue;
+			} else if (tds5_bcp_is_fixed_col(bcpinfo, i) != (pass == 0)) {
+				continue;
+			}
+
+			plan->col = bcpcol;
+			plan->index = i;
+			plan->nullable = pass != 0;
+			plan->writer = TDS_BCP_WRITE_GENERIC;
+			plan->size = bcpcol->on_server.column_size;
+			++plan;
+		}
+		if (pass == 0)
+			bcpinfo->plan_fixed = (TDS_INT) (plan - bcpinfo->plan);
+		else if (pass == 1)
+			bcpinfo->plan_variable = (TDS_INT) (plan - bcpinfo->plan) - bcpinfo->plan_fixed;
+	}
+	bcpinfo->plan_count = (TDS_INT) (plan - bcpinfo->plan);
 	return TDS_SUCCESS;
 }
 
@@ -31,6 +31,7 @@
 #if HAVE_ERRNO_H
 #include <errno.h>
 #endif /* HAVE_ERRNO_H */
+#include <float.h>
 
 #if HAVE_STDLIB_H
 #include <stdlib.h>
@@ -64,8 +65,12 @@ struct tds_time
 };
 
 static TDS_INT tds_convert_int(TDS_INT num, int desttype, CONV_RESULT * cr);
+static size_t tds_locale_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEFMT *compiled,
+				  const TDSDATEREC * dr, int prec);
 static TDS_INT tds_convert_uint8(const TDS_UINT8 * src, int desttype, CONV_RESULT * cr);
 static int string_to_datetime(const char *datestr, TDS_UINT len, int desttype, CONV_RESULT * cr);
+static bool parse_iso_datetime(const char *s, const char *end, struct tds_time *t);
+static int tds_time_to_result(const struct tds_time *t, int desttype, CONV_RESULT * cr);
 static bool is_dd_mon_yyyy(char *t);
 static int store_dd_mon_yyy_date(char *datestr, struct tds_time *t);
 static const char *parse_numeric(const char *buf, const char *pend,
@@ -167,6 +172,94 @@ static const char *tds_prtype(int token);
 
 const char tds_hex_digits[] = "0123456789abcdef";
 
+/** hexadecimal representation of all bytes, lower case */
+static const char hex_pairs[513] =
+	"000102030405060708090a0b0c0d0e0f"
+	"101112131415161718191a1b1c1d1e1f"
+	"202122232425262728292a2b2c2d2e2f"
+	"303132333435363738393a3b3c3d3e3f"
+	"404142434445464748494a4b4c4d4e4f"
+	"505152535455565758595a5b5c5d5e5f"
+	"606162636465666768696a6b6c6d6e6f"
+	"707172737475767778797a7b7c7d7e7f"
+	"808182838485868788898a8b8c8d8e8f"
+	"909192939495969798999a9b9c9d9e9f"
+	"a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+	"b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+	"c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+	"d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+	"e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+	"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/** hexadecimal representation of all bytes, upper case */
+static const char hex_pairs_upper[513] =
+	"000102030405060708090A0B0C0D0E0F"
+	"101112131415161718191A1B1C1D1E1F"
+	"202122232425262728292A2B2C2D2E2F"
+	"303132333435363738393A3B3C3D3E3F"
+	"404142434445464748494A4B4C4D4E4F"
+	"505152535455565758595A5B5C5D5E5F"
+	"606162636465666768696A6B6C6D6E6F"
+	"707172737475767778797A7B7C7D7E7F"
+	"808182838485868788898A8B8C8D8E8F"
+	"909192939495969798999A9B9C9D9E9F"
+	"A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+	"B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+	"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+	"D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+	"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+	"F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/** value of hexadecimal digits, X (invalid) for other characters */
+#define X 0xff
+static const unsigned char hex_values[256] = {
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, X, X, X, X, X, X,
+	X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, 10, 11, 12, 13, 14, 15, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+	X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X,
+};
+#undef X
+
+/** write bytes in hexadecimal using a table, 2 characters for each byte */
+static inline char *
+bin2hex(char *dest, const TDS_UCHAR *src, size_t len, const char *pairs)
+{
+	for (; len; --len) {
+		memcpy(dest, pairs + *src++ * 2u, 2);
+		dest += 2;
+	}
+	return dest;
+}
+
+/**
+ * Copy a string of given length to result and return len or TDS_CONVERT_NOMEM
+ */
+static TDS_INT
+string_len_to_result(int desttype, const char *s, size_t len, CONV_RESULT * cr)
+{
+	if (desttype != TDS_CONVERT_CHAR) {
+		cr->c = tds_new(TDS_CHAR, len + 1);
+		test_alloc(cr->c);
+		memcpy(cr->c, s, len);
+		cr->c[len] = 0;
+	} else {
+		memcpy(cr->cc.c, s, len < cr->cc.len ? len : cr->cc.len);
+	}
+	return (TDS_INT)len;
+}
+
 /**
  * Copy a terminated string to result and return len or TDS_CONVERT_NOMEM
  */
@@ -185,6 +278,23 @@ string_to_result(int desttype, const char *s, CONV_RESULT * cr)
 	return (TDS_INT)len;
 }
 
+/**
+ * Format an integer to result, without using sprintf
+ * @param num       absolute value of the number
+ * @param negative  number is negative
+ */
+static TDS_INT
+int_to_result(int desttype, TDS_UINT8 num, bool negative, CONV_RESULT * cr)
+{
+	char tmp_str[24];
+	char *const end = tmp_str + sizeof(tmp_str);
+	char *p = tds_format_uint8(num, end);
+
+	if (negative)
+		*--p = '-';
+	return string_len_to_result(desttype, p, end - p, cr);
+}
+
 /**
  * Copy binary data to to result and return len or TDS_CONVERT_NOMEM
  */
@@ -221,7 +331,6 @@ static TDS_INT
 tds_convert_binary(const TDS_UCHAR * src, TDS_INT srclen, int desttype, CONV_RESULT * cr)
 {
 	int cplen;
-	int s;
 	char *c;
 
 	switch (desttype) {
@@ -230,13 +339,9 @@ tds_convert_binary(const TDS_UCHAR * src, TDS_INT srclen, int desttype, CONV_RES
 		if ((TDS_UINT)cplen > cr->cc.len)
 			cplen = cr->cc.len;
 
-		c = cr->cc.c;
-		for (s = 0; cplen >= 2; ++s, cplen -= 2) {
-			*c++ = tds_hex_digits[src[s]>>4];
-			*c++ = tds_hex_digits[src[s]&0xF];
-		}
-		if (cplen)
-			*c = tds_hex_digits[src[s]>>4];
+		c = bin2hex(cr->cc.c, src, cplen / 2, hex_pairs);
+		if (cplen & 1)
+			*c = tds_hex_digits[src[cplen / 2]>>4];
 		return srclen * 2;
 
 	case CASE_ALL_CHAR:
@@ -252,13 +357,7 @@ tds_convert_binary(const TDS_UCHAR * src, TDS_INT srclen, int desttype, CONV_RES
 		cr->c = tds_new(TDS_CHAR, (srclen * 2) + 1);
 		test_alloc(cr->c);
 
-		c = cr->c;
-
-		for (s = 0; s < srclen; s++) {
-			*c++ = tds_hex_digits[src[s]>>4];
-			*c++ = tds_hex_digits[src[s]&0xF];
-		}
-
+		c = bin2hex(cr->c, src, srclen, hex_pairs);
 		*c = '\0';
 		return (srclen * 2);
 		break;
@@ -303,42 +402,34 @@ tds_convert_binary(const TDS_UCHAR * src, TDS_INT srclen, int desttype, CONV_RES
 TDS_INT
 tds_char2hex(TDS_CHAR *dest, TDS_UINT destlen, const TDS_CHAR * src, TDS_UINT srclen)
 {
-	unsigned int i;
-	unsigned char hex1, c = 0;
+	const TDS_UCHAR *s = (const TDS_UCHAR *) src;
+	TDS_UINT i = 0, len = srclen / 2u + (srclen & 1);
+	unsigned char hi, lo;
 
 	/* if srclen if odd we must add a "0" before ... */
-	i = 0;		/* number where to start converting */
 	if (srclen & 1) {
-		++srclen;
+		lo = hex_values[*s++];
+		if (lo > 0xf)
+			goto syntax_error;
+		if (destlen)
+			dest[0] = lo;
 		i = 1;
-		--src;
 	}
-	for (; i < srclen; ++i) {
-		hex1 = src[i];
-
-		if ('0' <= hex1 && hex1 <= '9')
-			hex1 &= 0x0f;
-		else {
-			hex1 &= 0x20 ^ 0xff;	/* mask off 0x20 to ensure upper case */
-			if ('A' <= hex1 && hex1 <= 'F') {
-				hex1 -= ('A' - 10);
-			} else {
-				tdsdump_log(TDS_DBG_INFO1,
-					    "error_handler:  attempt to convert data stopped by syntax error in source field \n");
-				return TDS_CONVERT_SYNTAX;
-			}
-		}
-		assert(hex1 < 0x10);
-
-		if ((i/2u) >= destlen)
-			continue;
-
-		if (i & 1)
-			dest[i / 2u] = c | hex1;
-		else
-			c = hex1 << 4;
+	/* convert two digits at a time, check all digits but store only destlen bytes */
+	for (; i < len; ++i, s += 2) {
+		hi = hex_values[s[0]];
+		lo = hex_values[s[1]];
+		if ((hi | lo) > 0xf)
+			goto syntax_error;
+		if (i < destlen)
+			dest[i] = (hi << 4) | lo;
 	}
-	return srclen / 2u;
+	return len;
+
+syntax_error:
+	tdsdump_log(TDS_DBG_INFO1,
+		    "error_handler:  attempt to convert data stopped by syntax error in source field \n");
+	return TDS_CONVERT_SYNTAX;
 }
 
 static TDS_INT
@@ -491,8 +582,13 @@ tds_convert_char(const TDS_CHAR * src, TDS_UINT srclen, int desttype, CONV_RESUL
 		return string_to_numeric(src, src + srclen, cr);
 		break;
 	case SYBUNIQUE:{
-			unsigned n = 0;
-			char c;
+			/* positions of digit pairs, up to fourth group */
+			static const unsigned char unique_pos[10] = {
+				0, 2, 4, 6, 9, 11, 14, 16, 19, 21
+			};
+			TDS_UCHAR bytes[16];
+			unsigned char hi, lo, invalid = 0;
+			const char *last;
 
 			/* 
 			 * format:	 XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX 
@@ -511,56 +607,30 @@ tds_convert_char(const TDS_CHAR * src, TDS_UINT srclen, int desttype, CONV_RESUL
 				++src;
 			}
 
-			/* 
-			 * Test each character and get value.  
-			 * sscanf works if the number terminates with less digits. 
-			 */
-			for (i = 0; i < 32 + 3; ++i) {
-				c = src[i];
-				switch (i) {
-				case 8:
-					if (c != '-')
-						return TDS_CONVERT_SYNTAX;
-					cr->u.Data1 = n;
-					n = 0;
-					break;
-				case 8+1 + 4:
-					if (c != '-')
-						return TDS_CONVERT_SYNTAX;
-					cr->u.Data2 = n;
-					n = 0;
-					break;
-				case 8+1 + 4+1 + 4:
-					if (c != '-')
-						return TDS_CONVERT_SYNTAX;
-					cr->u.Data3 = n;
-					n = 0;
-					break;
-				case 8+1 + 4+1 + 4+1 + 4:
-					/* skip last (optional) dash */
-					if (c == '-') {
-						if (--srclen < 32 + 3)
-							return TDS_CONVERT_SYNTAX;
-						c = (++src)[i];
-					}
-					/* fall through */
-				default:
-					n = n << 4;
-					if (c >= '0' && c <= '9')
-						n += c - '0';
-					else {
-						c &= 0x20 ^ 0xff;
-						if (c >= 'A' && c <= 'F')
-							n += c - ('A' - 10);
-						else
-							return TDS_CONVERT_SYNTAX;
-					}
-					if (i > (16 + 2) && !(i & 1)) {
-						cr->u.Data4[(i >> 1) - 10] = n;
-						n = 0;
-					}
-				}
+			if (src[8] != '-' || src[8+1 + 4] != '-' || src[8+1 + 4+1 + 4] != '-')
+				return TDS_CONVERT_SYNTAX;
+			/* skip last (optional) dash */
+			last = src + 8+1 + 4+1 + 4+1 + 4;
+			if (*last == '-') {
+				if (srclen < 32 + 4)
+					return TDS_CONVERT_SYNTAX;
+				++last;
+			}
+
+			/* get bytes from digit pairs, check all digits are valid at the end */
+			for (i = 0; i < 16; ++i) {
+				const char *p = i < 10 ? src + unique_pos[i] : last + (i - 10) * 2;
+				hi = hex_values[(unsigned char) p[0]];
+				lo = hex_values[(unsigned char) p[1]];
+				invalid |= hi | lo;
+				bytes[i] = (hi << 4) | lo;
 			}
+			if (invalid > 0xf)
+				return TDS_CONVERT_SYNTAX;
+			cr->u.Data1 = TDS_GET_UA4BE(bytes);
+			cr->u.Data2 = TDS_GET_UA2BE(bytes + 4);
+			cr->u.Data3 = TDS_GET_UA2BE(bytes + 6);
+			memcpy(cr->u.Data4, bytes + 8, 8);
 		}
 		return sizeof(TDS_UNIQUE);
 	default:
@@ -644,13 +714,12 @@ tds_convert_int8_numeric(unsigned char scale,
 static TDS_INT
 tds_convert_int(TDS_INT num, int desttype, CONV_RESULT * cr)
 {
-	TDS_CHAR tmp_str[16];
-
 	switch (desttype) {
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
-		sprintf(tmp_str, "%d", num);
-		return string_to_result(desttype, tmp_str, cr);
+		if (num < 0)
+			return int_to_result(desttype, 0u - (TDS_UINT) num, true, cr);
+		return int_to_result(desttype, (TDS_UINT) num, false, cr);
 		break;
 	case SYBSINT1:
 		if (!IS_SINT1(num))
@@ -744,7 +813,6 @@ static TDS_INT
 tds_convert_int8(const TDS_INT8 *src, int desttype, CONV_RESULT * cr)
 {
 	TDS_INT8 buf;
-	TDS_CHAR tmp_str[24];
 
 	memcpy(&buf, src, sizeof(buf));
 	if (INT_IS_INT(buf))
@@ -753,8 +821,9 @@ tds_convert_int8(const TDS_INT8 *src, int desttype, CONV_RESULT * cr)
 	switch (desttype) {
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
-		sprintf(tmp_str, "%" PRId64, buf);
-		return string_to_result(desttype, tmp_str, cr);
+		if (buf < 0)
+			return int_to_result(desttype, 0u - (TDS_UINT8) buf, true, cr);
+		return int_to_result(desttype, (TDS_UINT8) buf, false, cr);
 		break;
 	case SYBINT1:
 	case SYBSINT1:
@@ -822,7 +891,6 @@ static TDS_INT
 tds_convert_uint8(const TDS_UINT8 *src, int desttype, CONV_RESULT * cr)
 {
 	TDS_UINT8 buf;
-	TDS_CHAR tmp_str[24];
 
 	memcpy(&buf, src, sizeof(buf));
 	/* INT_IS_INT does not work here due to unsigned/signed conversions */
@@ -832,8 +900,7 @@ tds_convert_uint8(const TDS_UINT8 *src, int desttype, CONV_RESULT * cr)
 	switch (desttype) {
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
-		sprintf(tmp_str, "%" PRIu64, buf);
-		return string_to_result(desttype, tmp_str, cr);
+		return int_to_result(desttype, buf, false, cr);
 		break;
 	case SYBINT1:
 	case SYBSINT1:
@@ -1326,6 +1393,7 @@ tds_convert_datetimeall(const TDSCONTEXT * tds_ctx, int srctype, const TDS_DATET
 {
 	char whole_date_string[64];
 	const char *datetime_fmt;
+	const TDSDATEFMT *compiled;
 	TDSDATEREC when;
 
 	switch (desttype) {
@@ -1333,12 +1401,17 @@ tds_convert_datetimeall(const TDSCONTEXT * tds_ctx, int srctype, const TDS_DATET
 	case CASE_ALL_CHAR:
 		tds_datecrack(srctype, dta, &when);
 		datetime_fmt = tds_ctx->locale->datetime_fmt;
-		if (srctype == SYBMSDATE && tds_ctx->locale->date_fmt)
+		compiled = tds_ctx->locale->datetime_compiled;
+		if (srctype == SYBMSDATE && tds_ctx->locale->date_fmt) {
 			datetime_fmt = tds_ctx->locale->date_fmt;
-		if (srctype == SYBMSTIME && tds_ctx->locale->time_fmt)
+			compiled = tds_ctx->locale->date_compiled;
+		}
+		if (srctype == SYBMSTIME && tds_ctx->locale->time_fmt) {
 			datetime_fmt = tds_ctx->locale->time_fmt;
-		tds_strftime(whole_date_string, sizeof(whole_date_string), datetime_fmt, &when,
-		             dta->time_prec);
+			compiled = tds_ctx->locale->time_compiled;
+		}
+		tds_locale_strftime(whole_date_string, sizeof(whole_date_string), datetime_fmt, compiled, &when,
+				    dta->time_prec);
 
 		return string_to_result(desttype, whole_date_string, cr);
 	case SYBDATETIME:
@@ -1403,7 +1476,8 @@ tds_convert_datetime(const TDSCONTEXT * tds_ctx, const TDS_DATETIME * dt, int de
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
 		tds_datecrack(SYBDATETIME, dt, &when);
-		tds_strftime(whole_date_string, sizeof(whole_date_string), tds_ctx->locale->datetime_fmt, &when, 3);
+		tds_locale_strftime(whole_date_string, sizeof(whole_date_string), tds_ctx->locale->datetime_fmt,
+				    tds_ctx->locale->datetime_compiled, &when, 3);
 
 		return string_to_result(desttype, whole_date_string, cr);
 	case SYBDATETIME:
@@ -1578,6 +1652,10 @@ tds_convert_real(const TDS_REAL* src, int desttype, CONV_RESULT * cr)
 	switch (desttype) {
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
+		/* "%.9g" prints integral values below 1e9 as integers */
+		if (the_value > -1e9f && the_value < 1e9f && (the_value <= -1.0f || the_value >= 1.0f)
+		    && the_value == (TDS_REAL) (TDS_INT) the_value)
+			return tds_convert_int((TDS_INT) the_value, desttype, cr);
 		sprintf(tmp_str, "%.9g", the_value);
 		return string_to_result(desttype, tmp_str, cr);
 		break;
@@ -1693,6 +1771,14 @@ tds_convert_flt8(const TDS_FLOAT* src, int desttype, CONV_RESULT * cr)
 	switch (desttype) {
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
+		/* "%.17g" prints integral values below 2^53 as integers */
+		if (the_value > -9007199254740992.0 && the_value < 9007199254740992.0
+		    && (the_value <= -1.0 || the_value >= 1.0)
+		    && the_value == (TDS_FLOAT) (TDS_INT8) the_value) {
+			TDS_INT8 num = (TDS_INT8) the_value;
+
+			return tds_convert_int8(&num, desttype, cr);
+		}
 		sprintf(tmp_str, "%.17g", the_value);
 		return string_to_result(desttype, tmp_str, cr);
 		break;
@@ -1797,15 +1883,26 @@ tds_convert_unique(const TDS_CHAR * src, int desttype, CONV_RESULT * cr)
 	 * so this cast is portable
 	 */
 	const TDS_UNIQUE *u = (const TDS_UNIQUE *) src;
-	char buf[37];
+	TDS_UCHAR bytes[8];
+	char buf[37], *p;
 
 	switch (desttype) {
 	case TDS_CONVERT_CHAR:
 	case CASE_ALL_CHAR:
-		sprintf(buf, "%08X-%04X-%04X-%02X%02X-%02X%02X%02X%02X%02X%02X",
-			(int) u->Data1, (int) u->Data2, (int) u->Data3,
-			u->Data4[0], u->Data4[1], u->Data4[2], u->Data4[3], u->Data4[4], u->Data4[5], u->Data4[6], u->Data4[7]);
-		return string_to_result(desttype, buf, cr);
+		/* XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX */
+		TDS_PUT_UA4BE(bytes, u->Data1);
+		TDS_PUT_UA2BE(bytes + 4, u->Data2);
+		TDS_PUT_UA2BE(bytes + 6, u->Data3);
+		p = bin2hex(buf, bytes, 4, hex_pairs_upper);
+		*p++ = '-';
+		p = bin2hex(p, bytes + 4, 2, hex_pairs_upper);
+		*p++ = '-';
+		p = bin2hex(p, bytes + 6, 2, hex_pairs_upper);
+		*p++ = '-';
+		p = bin2hex(p, u->Data4, 2, hex_pairs_upper);
+		*p++ = '-';
+		p = bin2hex(p, u->Data4 + 2, 6, hex_pairs_upper);
+		return string_len_to_result(desttype, buf, p - buf, cr);
 		break;
 	case SYBUNIQUE:
 		/*
@@ -1948,6 +2045,52 @@ tds_convert_to_binary(int srctype, const TDS_CHAR * src, TDS_UINT srclen, int de
 	return binary_to_result(desttype, src, len, cr);
 }
 
+/** convert from a given source type, all functions have the same signature */
+typedef TDS_INT (*TDS_CONVERT_FUNC)(const TDSCONTEXT *tds_ctx, int srctype, const void *src, TDS_UINT srclen,
+				    int desttype, CONV_RESULT *cr);
+
+#define CONVERTER(name, call) \
+static TDS_INT \
+tds_convert_from_ ## name(const TDSCONTEXT *tds_ctx, int srctype, const void *src, TDS_UINT srclen, \
+			  int desttype, CONV_RESULT *cr) \
+{ \
+	return call; \
+}
+
+CONVERTER(noavail, TDS_CONVERT_NOAVAIL)
+CONVERTER(char, tds_convert_char(src, srclen, desttype, cr))
+CONVERTER(binary, tds_convert_binary((const TDS_UCHAR *) src, srclen, desttype, cr))
+CONVERTER(money4, tds_convert_money4(tds_ctx, (const TDS_MONEY4 *) src, desttype, cr))
+CONVERTER(money, tds_convert_money(tds_ctx, (const TDS_MONEY *) src, desttype, cr))
+CONVERTER(numeric, tds_convert_numeric((const TDS_NUMERIC *) src, desttype, cr))
+CONVERTER(bit, tds_convert_bit(src, desttype, cr))
+CONVERTER(int1, tds_convert_int1((const int8_t *) src, desttype, cr))
+CONVERTER(uint1, tds_convert_uint1((const TDS_TINYINT *) src, desttype, cr))
+CONVERTER(int2, tds_convert_int2((const TDS_SMALLINT *) src, desttype, cr))
+CONVERTER(uint2, tds_convert_uint2((const TDS_USMALLINT *) src, desttype, cr))
+CONVERTER(int4, tds_convert_int4((const TDS_INT *) src, desttype, cr))
+CONVERTER(uint4, tds_convert_uint4((const TDS_UINT *) src, desttype, cr))
+CONVERTER(int8, tds_convert_int8((const TDS_INT8 *) src, desttype, cr))
+CONVERTER(uint8, tds_convert_uint8((const TDS_UINT8 *) src, desttype, cr))
+CONVERTER(real, tds_convert_real((const TDS_REAL *) src, desttype, cr))
+CONVERTER(flt8, tds_convert_flt8((const TDS_FLOAT *) src, desttype, cr))
+CONVERTER(datetimeall, tds_convert_datetimeall(tds_ctx, srctype, (const TDS_DATETIMEALL *) src, desttype, cr))
+CONVERTER(datetime, tds_convert_datetime(tds_ctx, (const TDS_DATETIME *) src, desttype, 3, cr))
+CONVERTER(datetime4, tds_convert_datetime4(tds_ctx, (const TDS_DATETIME4 *) src, desttype, cr))
+CONVERTER(time, tds_convert_time(tds_ctx, (const TDS_TIME *) src, desttype, cr))
+CONVERTER(date, tds_convert_date(tds_ctx, (const TDS_DATE *) src, desttype, cr))
+CONVERTER(bigtime, tds_convert_bigtime(tds_ctx, (const TDS_BIGTIME *) src, desttype, cr))
+CONVERTER(bigdatetime, tds_convert_bigdatetime(tds_ctx, (const TDS_BIGDATETIME *) src, desttype, cr))
+CONVERTER(unique, tds_convert_unique(src, desttype, cr))
+
+#undef CONVERTER
+
+/*
+ * Generated tables: type2category and category_conversion used by
+ * tds_willconvert, converters and type2converter used by tds_convert.
+ */
+#include "tds_willconvert.h"
+
 /**
  * tds_convert
  * convert a type to another.
@@ -1968,7 +2111,7 @@ tds_convert_to_binary(int srctype, const TDS_CHAR * src, TDS_UINT srclen, int de
 TDS_INT
 tds_convert(const TDSCONTEXT *tds_ctx, int srctype, const void *src, TDS_UINT srclen, int desttype, CONV_RESULT *cr)
 {
-	TDS_INT length = 0;
+	TDS_INT length;
 
 	assert(srclen >= 0 && srclen <= 2147483647u);
 
@@ -1984,130 +2127,406 @@ tds_convert(const TDSCONTEXT *tds_ctx, int srctype, const void *src, TDS_UINT sr
 		return tds_convert_to_binary(srctype, src, srclen, desttype, cr);
 	}
 
-	switch (srctype) {
-	case CASE_ALL_CHAR:
-		length = tds_convert_char(src, srclen, desttype, cr);
-		break;
-	case SYBMONEY4:
-		length = tds_convert_money4(tds_ctx, (const TDS_MONEY4 *) src, desttype, cr);
-		break;
-	case SYBMONEY:
-		length = tds_convert_money(tds_ctx, (const TDS_MONEY *) src, desttype, cr);
-		break;
-	case SYBNUMERIC:
-	case SYBDECIMAL:
-		length = tds_convert_numeric((const TDS_NUMERIC *) src, desttype, cr);
-		break;
+	/* they must be from 0 to 255 */
+	if ((srctype & ~0xff) != 0)
+		return TDS_CONVERT_NOAVAIL;
+
+	length = converters[type2converter[srctype]](tds_ctx, srctype, src, srclen, desttype, cr);
+
+/* fix MONEY case */
+#if !defined(WORDS_BIGENDIAN)
+	if (length > 0 && desttype == SYBMONEY) {
+		cr->m.mny = ((TDS_UINT8) cr->m.mny) >> 32 | (cr->m.mny << 32);
+	}
+#endif
+	return length;
+}
+
+/** how tds_convert_batch converts values, chosen once for all values */
+typedef enum
+{
+	/** call tds_convert for every value */
+	TDS_BATCH_GENERIC,
+	/** same fixed type, copy values */
+	TDS_BATCH_COPY,
+	/** integer to integer or floating point */
+	TDS_BATCH_INT,
+} TDS_BATCH_ROUTE;
+
+static bool
+is_batch_int_src(int type)
+{
+	switch (type) {
+	case SYBBIT:
+	case SYBBITN:
+	case SYBSINT1:
+	case SYBINT1:
+	case SYBUINT1:
+	case SYBINT2:
+	case SYBUINT2:
+	case SYBINT4:
+	case SYBUINT4:
+	case SYBINT8:
+		return true;
+	}
+	return false;
+}
+
+static bool
+is_batch_int_dest(int type)
+{
+	switch (type) {
 	case SYBBIT:
 	case SYBBITN:
-		length = tds_convert_bit(src, desttype, cr);
-		break;
 	case SYBSINT1:
-		length = tds_convert_int1((const int8_t *) src, desttype, cr);
-		break;
 	case SYBINT1:
 	case SYBUINT1:
-		length = tds_convert_uint1((const TDS_TINYINT *) src, desttype, cr);
-		break;
 	case SYBINT2:
-		length = tds_convert_int2((const TDS_SMALLINT *) src, desttype, cr);
-		break;
 	case SYBUINT2:
-		length = tds_convert_uint2((const TDS_USMALLINT *) src, desttype, cr);
-		break;
 	case SYBINT4:
-		length = tds_convert_int4((const TDS_INT *) src, desttype, cr);
-		break;
 	case SYBUINT4:
-		length = tds_convert_uint4((const TDS_UINT *) src, desttype, cr);
-		break;
 	case SYBINT8:
-		length = tds_convert_int8((const TDS_INT8 *) src, desttype, cr);
-		break;
 	case SYBUINT8:
-		length = tds_convert_uint8((const TDS_UINT8 *) src, desttype, cr);
-		break;
-	case SYBREAL:
-		length = tds_convert_real((const TDS_REAL *) src, desttype, cr);
-		break;
 	case SYBFLT8:
-		length = tds_convert_flt8((const TDS_FLOAT *) src, desttype, cr);
-		break;
-	case SYBMSTIME:
-	case SYBMSDATE:
-	case SYBMSDATETIME2:
-	case SYBMSDATETIMEOFFSET:
-		length = tds_convert_datetimeall(tds_ctx, srctype, (const TDS_DATETIMEALL *) src, desttype, cr);
-		break;
-	case SYBDATETIME:
-		length = tds_convert_datetime(tds_ctx, (const TDS_DATETIME* ) src, desttype, 3, cr);
-		break;
-	case SYBDATETIME4:
-		length = tds_convert_datetime4(tds_ctx, (const TDS_DATETIME4* ) src, desttype, cr);
-		break;
-	case SYBTIME:
-		length = tds_convert_time(tds_ctx, (const TDS_TIME *) src, desttype, cr);
-		break;
-	case SYBDATE:
-		length = tds_convert_date(tds_ctx, (const TDS_DATE *) src, desttype, cr);
-		break;
-	case SYB5BIGTIME:
-		length = tds_convert_bigtime(tds_ctx, (const TDS_BIGTIME *) src, desttype, cr);
-		break;
-	case SYB5BIGDATETIME:
-		length = tds_convert_bigdatetime(tds_ctx, (const TDS_BIGDATETIME *) src, desttype, cr);
-		break;
-	case CASE_ALL_BINARY:
-		length = tds_convert_binary((const TDS_UCHAR *) src, srclen, desttype, cr);
-		break;
-	case SYBUNIQUE:
-		length = tds_convert_unique(src, desttype, cr);
-		break;
-	case SYBNVARCHAR:
-	case SYBNTEXT:
-	case SYBMSTABLE:
-	default:
-		return TDS_CONVERT_NOAVAIL;
-		break;
+	case SYBREAL:
+		return true;
 	}
+	return false;
+}
 
-/* fix MONEY case */
-#if !defined(WORDS_BIGENDIAN)
-	if (length > 0 && desttype == SYBMONEY) {
-		cr->m.mny = ((TDS_UINT8) cr->m.mny) >> 32 | (cr->m.mny << 32);
+static TDS_BATCH_ROUTE
+tds_batch_route(int srctype, int desttype)
+{
+	if (srctype == desttype) {
+		switch (srctype) {
+		case SYBSINT1:
+		case SYBINT1:
+		case SYBUINT1:
+		case SYBINT2:
+		case SYBUINT2:
+		case SYBINT4:
+		case SYBUINT4:
+		case SYBINT8:
+		case SYBUINT8:
+		case SYBREAL:
+		case SYBFLT8:
+		case SYBMONEY4:
+		case SYBMONEY:
+		case SYBDATETIME4:
+		case SYBDATETIME:
+		case SYBUNIQUE:
+			return TDS_BATCH_COPY;
+		}
 	}
-#endif
-	return length;
+	if (is_batch_int_src(srctype) && is_batch_int_dest(desttype))
+		return TDS_BATCH_INT;
+	return TDS_BATCH_GENERIC;
 }
 
-static int
-string_to_datetime(const char *instr, TDS_UINT len, int desttype, CONV_RESULT * cr)
+/** read an integer of a type accepted by is_batch_int_src */
+static inline TDS_INT8
+batch_get_int(int srctype, const void *src)
 {
-	enum states {
-		GOING_IN_BLIND,
-		PUT_NUMERIC_IN_CONTEXT,
-		DOING_ALPHABETIC_DATE
-	};
+	TDS_INT8 num;
 
-	char *in;
-	char *tok;
-	char *lasts;
-	char last_token[32];
-	int monthdone = 0;
-	int yeardone = 0;
-	int mdaydone = 0;
+	switch (srctype) {
+	case SYBBIT:
+	case SYBBITN:
+		return *(const TDS_TINYINT *) src ? 1 : 0;
+	case SYBSINT1:
+		return *(const int8_t *) src;
+	case SYBINT1:
+	case SYBUINT1:
+		return *(const TDS_TINYINT *) src;
+	case SYBINT2:
+		return *(const TDS_SMALLINT *) src;
+	case SYBUINT2:
+		return *(const TDS_USMALLINT *) src;
+	case SYBINT4:
+		return *(const TDS_INT *) src;
+	case SYBUINT4:
+		return *(const TDS_UINT *) src;
+	}
+	memcpy(&num, src, sizeof(num));
+	return num;
+}
 
-	struct tds_time t;
+/** store an integer in a type accepted by is_batch_int_dest, same results as tds_convert */
+static inline TDS_INT
+batch_put_int(TDS_INT8 num, int desttype, CONV_RESULT * cr)
+{
+	switch (desttype) {
+	case SYBSINT1:
+		if (!IS_SINT1(num))
+			return TDS_CONVERT_OVERFLOW;
+		cr->ti = (TDS_TINYINT) num;
+		return sizeof(TDS_TINYINT);
+	case SYBINT1:
+	case SYBUINT1:
+		if (!IS_TINYINT(num))
+			return TDS_CONVERT_OVERFLOW;
+		cr->ti = (TDS_TINYINT) num;
+		return sizeof(TDS_TINYINT);
+	case SYBINT2:
+		if (!IS_SMALLINT(num))
+			return TDS_CONVERT_OVERFLOW;
+		cr->si = (TDS_SMALLINT) num;
+		return sizeof(TDS_SMALLINT);
+	case SYBUINT2:
+		if (!IS_USMALLINT(num))
+			return TDS_CONVERT_OVERFLOW;
+		cr->usi = (TDS_USMALLINT) num;
+		return sizeof(TDS_USMALLINT);
+	case SYBINT4:
+		if (!INT_IS_INT(num))
+			return TDS_CONVERT_OVERFLOW;
+		cr->i = (TDS_INT) num;
+		return sizeof(TDS_INT);
+	case SYBUINT4:
+		if (!IS_UINT(num))
+			return TDS_CONVERT_OVERFLOW;
+		cr->ui = (TDS_UINT) num;
+		return sizeof(TDS_UINT);
+	case SYBINT8:
+		cr->bi = num;
+		return sizeof(TDS_INT8);
+	case SYBUINT8:
+		if (num < 0)
+			return TDS_CONVERT_OVERFLOW;
+		cr->ubi = (TDS_UINT8) num;
+		return sizeof(TDS_UINT8);
+	case SYBBIT:
+	case SYBBITN:
+		cr->ti = num ? 1 : 0;
+		return sizeof(TDS_TINYINT);
+	case SYBFLT8:
+		cr->f = (TDS_FLOAT) num;
+		return sizeof(TDS_FLOAT);
+	case SYBREAL:
+		cr->r = (TDS_REAL) num;
+		return sizeof(TDS_REAL);
+	}
+	return TDS_CONVERT_NOAVAIL;
+}
 
-	unsigned int dt_time;
-	TDS_INT dt_days;
-	int i;
+/**
+ * Convert many values of the same type.
+ * Results are the same as calling tds_convert() for every value but the
+ * way to convert is chosen once, common conversions (same fixed type,
+ * integer to integer or floating point) are done without calling tds_convert().
+ * @param tds_ctx     context (used in conversion to data and to return messages)
+ * @param srctype     type of source
+ * @param src         pointers to the values to convert
+ * @param srclens     lengths of the values, can be NULL if \a srctype is fixed
+ * @param n           number of values
+ * @param desttype    type of destination
+ * @param cr          results, one for every value, initialized as for tds_convert()
+ *                    (precision and scale for numeric, buffers for TDS_CONVERT_CHAR)
+ * @param destlens    receive the lengths returned by tds_convert() for every value
+ * @param nulls       if not NULL, values with a not zero entry are NULL and
+ *                    not converted, their length is set to 0
+ * @return number of values converted. If less than \a n conversion stopped
+ *         at that value and its entry in \a destlens is the failure code.
+ */
+TDS_INT
+tds_convert_batch(const TDSCONTEXT *tds_ctx, int srctype, const void *const *src, const TDS_UINT *srclens,
+		  TDS_INT n, int desttype, CONV_RESULT *cr, TDS_INT *destlens, const unsigned char *nulls)
+{
+	TDS_INT i, len;
+
+	switch (tds_batch_route(srctype, desttype)) {
+	case TDS_BATCH_COPY:
+		len = tds_get_size_by_type(srctype);
+		for (i = 0; i < n; ++i) {
+			if (nulls && nulls[i]) {
+				destlens[i] = 0;
+				continue;
+			}
+			memcpy(&cr[i], src[i], len);
+			destlens[i] = len;
+		}
+		break;
+
+	case TDS_BATCH_INT:
+		for (i = 0; i < n; ++i) {
+			if (nulls && nulls[i]) {
+				destlens[i] = 0;
+				continue;
+			}
+			destlens[i] = batch_put_int(batch_get_int(srctype, src[i]), desttype, &cr[i]);
+			if (destlens[i] < 0)
+				return i;
+		}
+		break;
+
+	case TDS_BATCH_GENERIC:
+		for (i = 0; i < n; ++i) {
+			if (nulls && nulls[i]) {
+				destlens[i] = 0;
+				continue;
+			}
+			destlens[i] = tds_convert(tds_ctx, srctype, src[i], srclens ? srclens[i] : 0, desttype, &cr[i]);
+			if (destlens[i] < 0)
+				return i;
+		}
+		break;
+	}
+	return n;
+}
+
+/** parse a fixed number of decimal digits */
+static inline bool
+parse_digits(const char *s, unsigned int n, unsigned int *value)
+{
+	unsigned int v = 0;
+
+	while (n--) {
+		unsigned int digit = (unsigned char) *s++ - '0';
+
+		if (digit > 9)
+			return false;
+		v = v * 10 + digit;
+	}
+	*value = v;
+	return true;
+}
+
+/**
+ * Parse ISO and ODBC canonical forms without allocations:
+ * "YYYY-MM-DD", "YYYY-MM-DD hh:mm", "YYYY-MM-DD hh:mm:ss" or
+ * "YYYY-MM-DD hh:mm:ss.f", with up to 9 digits of fraction.
+ * Date and time can also be separated by 'T'.
+ * Values out of range are left to the general parser.
+ * @return false if the string is not in these forms
+ */
+static bool
+parse_iso_datetime(const char *s, const char *end, struct tds_time *t)
+{
+	unsigned int year, month, mday, hour = 0, min = 0, sec = 0, ns = 0, digits;
+
+	while (s < end && *s == ' ')
+		++s;
+	while (end > s && end[-1] == ' ')
+		--end;
+
+	if (end - s < 10 || s[4] != '-' || s[7] != '-'
+	    || !parse_digits(s, 4, &year) || !parse_digits(s + 5, 2, &month) || !parse_digits(s + 8, 2, &mday))
+		return false;
+	s += 10;
+
+	if (s != end) {
+		if (end - s < 6 || (s[0] != ' ' && s[0] != 'T') || s[3] != ':'
+		    || !parse_digits(s + 1, 2, &hour) || !parse_digits(s + 4, 2, &min))
+			return false;
+		s += 6;
+		if (s != end) {
+			if (end - s < 3 || s[0] != ':' || !parse_digits(s + 1, 2, &sec))
+				return false;
+			s += 3;
+		}
+		if (s != end) {
+			digits = (unsigned int) (end - s - 1);
+			if (s[0] != '.' || digits < 1 || digits > 9 || !parse_digits(s + 1, digits, &ns))
+				return false;
+			for (; digits < 9; ++digits)
+				ns *= 10;
+		}
+	}
+
+	if (year < 1753 || month < 1 || month > 12 || mday < 1 || mday > 31 || hour > 23 || min > 59 || sec > 59)
+		return false;
+
+	t->tm_year = year - 1900;
+	t->tm_mon = month - 1;
+	t->tm_mday = mday;
+	t->tm_hour = hour;
+	t->tm_min = min;
+	t->tm_sec = sec;
+	t->tm_ns = ns;
+	return true;
+}
+
+/** compute date/time result of string conversions */
+static int
+tds_time_to_result(const struct tds_time *t, int desttype, CONV_RESULT * cr)
+{
+	unsigned int dt_time;
+	TDS_INT dt_days;
+	int i;
+
+	i = (t->tm_mon - 13) / 12;
+	dt_days = 1461 * (t->tm_year + 1900 + i) / 4 +
+		(367 * (t->tm_mon - 1 - 12 * i)) / 12 - (3 * ((t->tm_year + 2000 + i) / 100)) / 4 + t->tm_mday - 693932;
+
+	if (desttype == SYBDATE) {
+		cr->date = dt_days;
+		return sizeof(TDS_DATE);
+	}
+	dt_time = t->tm_hour * 60 + t->tm_min;
+	/* TODO check for overflow */
+	if (desttype == SYBDATETIME4) {
+		cr->dt4.days = dt_days;
+		cr->dt4.minutes = dt_time;
+		return sizeof(TDS_DATETIME4);
+	}
+	dt_time = dt_time * 60 + t->tm_sec;
+	if (desttype == SYBDATETIME) {
+		cr->dt.dtdays = dt_days;
+		cr->dt.dttime = dt_time * 300 + (t->tm_ns / 1000000u * 300 + 150) / 1000;
+		return sizeof(TDS_DATETIME);
+	}
+	if (desttype == SYBTIME) {
+		cr->time = dt_time * 300 + (t->tm_ns / 1000000u * 300 + 150) / 1000;
+		return sizeof(TDS_TIME);
+	}
+	if (desttype == SYB5BIGTIME) {
+		cr->bigtime = dt_time * UINT64_C(1000000) + t->tm_ns / 1000u;
+		return sizeof(TDS_BIGTIME);
+	}
+	if (desttype == SYB5BIGDATETIME) {
+		cr->bigdatetime = (dt_days + BIGDATETIME_BIAS) * (UINT64_C(86400) * 1000000u)
+				  + dt_time * UINT64_C(1000000) + t->tm_ns / 1000u;
+		return sizeof(TDS_BIGDATETIME);
+	}
+
+	cr->dta.has_offset = 0;
+	cr->dta.offset = 0;
+	cr->dta.has_date = 1;
+	cr->dta.date = dt_days;
+	cr->dta.has_time = 1;
+	cr->dta.time_prec = 7; /* TODO correct value */
+	cr->dta.time = dt_time * UINT64_C(10000000) + t->tm_ns / 100u;
+	return sizeof(TDS_DATETIMEALL);
+}
+
+static int
+string_to_datetime(const char *instr, TDS_UINT len, int desttype, CONV_RESULT * cr)
+{
+	enum states {
+		GOING_IN_BLIND,
+		PUT_NUMERIC_IN_CONTEXT,
+		DOING_ALPHABETIC_DATE
+	};
+
+	char *in;
+	char *tok;
+	char *lasts;
+	char last_token[32];
+	int monthdone = 0;
+	int yeardone = 0;
+	int mdaydone = 0;
+
+	struct tds_time t;
 
 	enum states current_state;
 
 	memset(&t, '\0', sizeof(t));
 	t.tm_mday = 1;
 
+	/* most dates are in ISO format, parse them quickly */
+	if (parse_iso_datetime(instr, instr + len, &t))
+		return tds_time_to_result(&t, desttype, cr);
+
 	in = tds_strndup(instr, len);
 	test_alloc(in);
 
@@ -2298,51 +2717,8 @@ string_to_datetime(const char *instr, TDS_UINT len, int desttype, CONV_RESULT *
 		tok = strtok_r(NULL, " ,", &lasts);
 	}
 
-	i = (t.tm_mon - 13) / 12;
-	dt_days = 1461 * (t.tm_year + 1900 + i) / 4 +
-		(367 * (t.tm_mon - 1 - 12 * i)) / 12 - (3 * ((t.tm_year + 2000 + i) / 100)) / 4 + t.tm_mday - 693932;
-
 	free(in);
-
-	if (desttype == SYBDATE) {
-		cr->date = dt_days;
-		return sizeof(TDS_DATE);
-	}
-	dt_time = t.tm_hour * 60 + t.tm_min;
-	/* TODO check for overflow */
-	if (desttype == SYBDATETIME4) {
-		cr->dt4.days = dt_days;
-		cr->dt4.minutes = dt_time;
-		return sizeof(TDS_DATETIME4);
-	}
-	dt_time = dt_time * 60 + t.tm_sec;
-	if (desttype == SYBDATETIME) {
-		cr->dt.dtdays = dt_days;
-		cr->dt.dttime = dt_time * 300 + (t.tm_ns / 1000000u * 300 + 150) / 1000;
-		return sizeof(TDS_DATETIME);
-	}
-	if (desttype == SYBTIME) {
-		cr->time = dt_time * 300 + (t.tm_ns / 1000000u * 300 + 150) / 1000;
-		return sizeof(TDS_TIME);
-	}
-	if (desttype == SYB5BIGTIME) {
-		cr->bigtime = dt_time * UINT64_C(1000000) + t.tm_ns / 1000u;
-		return sizeof(TDS_BIGTIME);
-	}
-	if (desttype == SYB5BIGDATETIME) {
-		cr->bigdatetime = (dt_days + BIGDATETIME_BIAS) * (UINT64_C(86400) * 1000000u)
-				  + dt_time * UINT64_C(1000000) + t.tm_ns / 1000u;
-		return sizeof(TDS_BIGDATETIME);
-	}
-
-	cr->dta.has_offset = 0;
-	cr->dta.offset = 0;
-	cr->dta.has_date = 1;
-	cr->dta.date = dt_days;
-	cr->dta.has_time = 1;
-	cr->dta.time_prec = 7; /* TODO correct value */
-	cr->dta.time = dt_time * UINT64_C(10000000) + t.tm_ns / 100u;
-	return sizeof(TDS_DATETIMEALL);
+	return tds_time_to_result(&t, desttype, cr);
 
 string_garbled:
 	tdsdump_log(TDS_DBG_INFO1,
@@ -3051,8 +3427,305 @@ tds_get_null_type(TDS_SERVER_TYPE srctype)
 	return srctype;
 }
 
+/** operations of a compiled date format */
+enum {
+	TDS_DATEFMT_TEXT,	/**< copy text */
+	TDS_DATEFMT_YEAR,	/**< %Y */
+	TDS_DATEFMT_YEAR2,	/**< %y */
+	TDS_DATEFMT_MONTH,	/**< %m */
+	TDS_DATEFMT_DAY,	/**< %d */
+	TDS_DATEFMT_DAY_BLANK,	/**< %e */
+	TDS_DATEFMT_HOUR,	/**< %H */
+	TDS_DATEFMT_HOUR12,	/**< %I */
+	TDS_DATEFMT_HOUR12_BLANK,	/**< %l */
+	TDS_DATEFMT_MINUTE,	/**< %M */
+	TDS_DATEFMT_SECOND,	/**< %S */
+	TDS_DATEFMT_FRACTION,	/**< first %z */
+	TDS_DATEFMT_DOT_FRACTION,	/**< first %z preceded by a dot, dot is removed if precision is 0 */
+	TDS_DATEFMT_MONTH_NAME,	/**< %b, %h or %B, from names */
+	TDS_DATEFMT_WEEKDAY_NAME,	/**< %a or %A, from names */
+	TDS_DATEFMT_AMPM,	/**< %p, from names */
+	TDS_DATEFMT_STRFTIME,	/**< anything else, needs strftime */
+};
+
+typedef struct
+{
+	unsigned char op;
+	unsigned char len;	/**< length of text */
+	unsigned short pos;	/**< position of text in format or first name */
+} TDS_DATEFMT_OP;
+
+/** maximum length of a text operation, a rendered number is shorter */
+#define TDS_DATEFMT_MAX_TEXT 16
+/** maximum length of a name, including terminator */
+#define TDS_DATEFMT_MAX_NAME 32
+
+struct tds_datefmt
+{
+	unsigned int num_ops;
+	TDS_DATEFMT_OP *ops;
+	char *format;
+	/** some directives need strftime, format using tds_strftime_ext() */
+	bool use_strftime;
+	/**
+	 * names of months (abbreviated and full), week days (abbreviated
+	 * and full) and AM/PM in the locale used at compile time
+	 */
+	char (*names)[TDS_DATEFMT_MAX_NAME];
+};
+
+/**
+ * Split a format in operations.
+ * \a ops must have space for strlen(format) + 1 operations.
+ * @return number of operations or -1 if the format is too long
+ */
+static int
+tds_datefmt_parse(const char *format, TDS_DATEFMT_OP *ops)
+{
+	const char *p = format, *start;
+	int n = 0, op;
+	bool z_found = false;
+
+	if (strlen(format) > 0xffffu)
+		return -1;
+
+	while (*p) {
+		if (*p != '%') {
+			/* text up to next directive */
+			for (start = p; *p && *p != '%' && p - start < TDS_DATEFMT_MAX_TEXT; ++p)
+				continue;
+			ops[n].op = TDS_DATEFMT_TEXT;
+			ops[n].pos = (unsigned short) (start - format);
+			ops[n].len = (unsigned char) (p - start);
+			++n;
+			continue;
+		}
+		if (p[1] == '%' || p[1] == 0) {
+			/* "%%" or a final "%", print a single % */
+			ops[n].op = TDS_DATEFMT_TEXT;
+			ops[n].pos = (unsigned short) (p - format);
+			ops[n].len = 1;
+			++n;
+			p += p[1] ? 2 : 1;
+			continue;
+		}
+
+		start = p++;
+		switch (*p++) {
+		case 'Y': op = TDS_DATEFMT_YEAR; break;
+		case 'y': op = TDS_DATEFMT_YEAR2; break;
+		case 'm': op = TDS_DATEFMT_MONTH; break;
+		case 'd': op = TDS_DATEFMT_DAY; break;
+		case 'e': op = TDS_DATEFMT_DAY_BLANK; break;
+		case 'H': op = TDS_DATEFMT_HOUR; break;
+		case 'I': op = TDS_DATEFMT_HOUR12; break;
+		case 'l': op = TDS_DATEFMT_HOUR12_BLANK; break;
+		case 'M': op = TDS_DATEFMT_MINUTE; break;
+		case 'S': op = TDS_DATEFMT_SECOND; break;
+		case 'z':
+			/* only first %z is replaced, next are passed to strftime */
+			if (z_found) {
+				op = TDS_DATEFMT_STRFTIME;
+				break;
+			}
+			z_found = true;
+			op = TDS_DATEFMT_FRACTION;
+			if (n > 0 && ops[n - 1].op == TDS_DATEFMT_TEXT && start[-1] == '.') {
+				op = TDS_DATEFMT_DOT_FRACTION;
+				if (--ops[n - 1].len == 0)
+					--n;
+			}
+			break;
+		default:
+			op = TDS_DATEFMT_STRFTIME;
+			break;
+		}
+		ops[n].op = op;
+		ops[n].pos = (unsigned short) (start - format);
+		ops[n].len = (unsigned char) (p - start);
+		++n;
+	}
+	return n;
+}
+
+/** fill struct tm for strftime */
 static void
-two_digit(char *out, int num)
+tds_datefmt_tm(struct tm *tm, const TDSDATEREC * dr)
+{
+	memset(tm, 0, sizeof(*tm));
+	tm->tm_sec = dr->second;
+	tm->tm_min = dr->minute;
+	tm->tm_hour = dr->hour;
+	tm->tm_mday = dr->day;
+	tm->tm_mon = dr->month;
+	tm->tm_year = dr->year - 1900;
+	tm->tm_wday = dr->weekday;
+	tm->tm_yday = dr->dayofyear;
+}
+
+/**
+ * Compute names for a directive.
+ * @return false if a name is too long
+ */
+static bool
+tds_datefmt_names(char (*names)[TDS_DATEFMT_MAX_NAME], const char *directive, int num)
+{
+	TDSDATEREC dr;
+	struct tm tm;
+	char buf[TDS_DATEFMT_MAX_NAME + 1];
+	int i;
+
+	memset(&dr, 0, sizeof(dr));
+	dr.year = 2000;
+	dr.day = 1;
+	for (i = 0; i < num; ++i) {
+		dr.month = i;
+		dr.weekday = i % 7;
+		dr.hour = (i & 1) * 12;
+		tds_datefmt_tm(&tm, &dr);
+		/* directive is prefixed with a character to distinguish empty results from errors */
+		if (!strftime(buf, sizeof(buf), directive, &tm))
+			return false;
+		strcpy(names[i], buf + 1);
+	}
+	return true;
+}
+
+/**
+ * Compile a date format for tds_datefmt_format().
+ * Use it to format many dates with the same format.
+ * Names of months and week days are computed using current locale.
+ * @param format  format, see tds_strftime()
+ * @return compiled format, NULL on failure. Free it with tds_datefmt_free().
+ */
+TDSDATEFMT *
+tds_datefmt_compile(const char *format)
+{
+	static const struct {
+		char directive[4];
+		unsigned char op, first, num;
+	} named[] = {
+		{ "|%b", TDS_DATEFMT_MONTH_NAME,    0, 12 },
+		{ "|%h", TDS_DATEFMT_MONTH_NAME,    0, 12 },
+		{ "|%B", TDS_DATEFMT_MONTH_NAME,   12, 12 },
+		{ "|%a", TDS_DATEFMT_WEEKDAY_NAME, 24,  7 },
+		{ "|%A", TDS_DATEFMT_WEEKDAY_NAME, 31,  7 },
+		{ "|%p", TDS_DATEFMT_AMPM,         38,  2 },
+	};
+	TDSDATEFMT *fmt;
+	TDS_DATEFMT_OP *op;
+	int n;
+	unsigned int i, j;
+
+	fmt = tds_new0(TDSDATEFMT, 1);
+	if (!fmt)
+		return NULL;
+	fmt->ops = tds_new(TDS_DATEFMT_OP, strlen(format) + 1);
+	fmt->format = strdup(format);
+	if (!fmt->ops || !fmt->format || (n = tds_datefmt_parse(format, fmt->ops)) < 0)
+		goto error;
+	fmt->num_ops = n;
+
+	/* compute names for this locale so we don't need strftime */
+	for (i = 0, op = fmt->ops; i < fmt->num_ops; ++i, ++op) {
+		if (op->op != TDS_DATEFMT_STRFTIME)
+			continue;
+		for (j = 0; j < TDS_VECTOR_SIZE(named); ++j)
+			if (op->len == 2 && memcmp(fmt->format + op->pos, named[j].directive + 1, 2) == 0)
+				break;
+		if (j >= TDS_VECTOR_SIZE(named)) {
+			fmt->use_strftime = true;
+			continue;
+		}
+		if (!fmt->names && !TDS_RESIZE(fmt->names, 40))
+			goto error;
+		if (!tds_datefmt_names(fmt->names + named[j].first, named[j].directive, named[j].num)) {
+			fmt->use_strftime = true;
+			continue;
+		}
+		op->op = named[j].op;
+		op->pos = named[j].first;
+	}
+	return fmt;
+
+error:
+	tds_datefmt_free(fmt);
+	return NULL;
+}
+
+void
+tds_datefmt_free(TDSDATEFMT *fmt)
+{
+	if (!fmt)
+		return;
+	free(fmt->ops);
+	free(fmt->format);
+	free(fmt->names);
+	free(fmt);
+}
+
+/**
+ * Compile a format only if it does not depend on the C library locale.
+ * @return compiled format or NULL
+ */
+static TDSDATEFMT *
+tds_datefmt_compile_fixed(const char *format)
+{
+	TDSDATEFMT *fmt;
+
+	if (!format)
+		return NULL;
+	fmt = tds_datefmt_compile(format);
+	if (fmt && (fmt->use_strftime || fmt->names)) {
+		tds_datefmt_free(fmt);
+		fmt = NULL;
+	}
+	return fmt;
+}
+
+/**
+ * Compile date formats of a locale, to be used converting dates to strings.
+ * Only formats not using names (like %b or %p) or other locale dependent
+ * directives are compiled, others are formatted with tds_strftime().
+ * Should be called again after changing formats; conversions check
+ * that compiled formats still match so stale ones are just not used.
+ */
+void
+tds_locale_compile_formats(TDSLOCALE *locale)
+{
+	tds_datefmt_free(locale->datetime_compiled);
+	locale->datetime_compiled = tds_datefmt_compile_fixed(locale->datetime_fmt);
+	tds_datefmt_free(locale->date_compiled);
+	locale->date_compiled = tds_datefmt_compile_fixed(locale->date_fmt);
+	tds_datefmt_free(locale->time_compiled);
+	locale->time_compiled = tds_datefmt_compile_fixed(locale->time_fmt);
+}
+
+/**
+ * Format a date using locale format, compiled version is used if
+ * available and still matches format.
+ */
+static size_t
+tds_locale_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEFMT *compiled,
+		    const TDSDATEREC * dr, int prec)
+{
+	if (compiled && strcmp(compiled->format, format) == 0)
+		return tds_datefmt_format(compiled, buf, maxsize, dr, prec);
+	return tds_strftime(buf, maxsize, format, dr, prec);
+}
+
+/** write a 2 digit number, values from 0 to 99 */
+static inline char *
+two_digits(char *out, unsigned int num)
+{
+	out[0] = num / 10u + '0';
+	out[1] = num % 10u + '0';
+	return out + 2;
+}
+
+/** write day or hour, single digit preceded by a blank */
+static inline char *
+two_digit_blank(char *out, int num)
 {
 	if (num < 1)
 		num = 1;
@@ -3060,53 +3733,130 @@ two_digit(char *out, int num)
 		num = 31;
 	out[0] = num < 10 ? ' ' : num/10 + '0';
 	out[1] = num%10 + '0';
+	return out + 2;
 }
 
 /**
- * format a date string according to an "extended" strftime(3) formatting definition.
- * @param buf     output buffer
- * @param maxsize size of buffer in bytes (space include terminator)
- * @param format  format string passed to strftime(3), except that %z represents fraction of seconds.
- * @param dr      date to convert
- * @param prec    second fraction precision (0-7).
+ * Format a date without strftime, format should not contain
+ * TDS_DATEFMT_STRFTIME operations.
  * @return length of string returned, 0 for error
  */
-size_t
-tds_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEREC * dr, int prec)
+static size_t
+tds_datefmt_render(const TDSDATEFMT *fmt, char *buf, size_t maxsize, const TDSDATEREC * dr, int prec)
+{
+	const TDS_DATEFMT_OP *op, *end;
+	char tmp[TDS_DATEFMT_MAX_TEXT];
+	char *p, *start;
+	const char *name;
+	size_t len = 0, n;
+
+	for (op = fmt->ops, end = op + fmt->num_ops; op != end; ++op) {
+		/* write directly to buffer if there is enough space */
+		start = p = (maxsize - len > sizeof(tmp)) ? buf + len : tmp;
+		switch (op->op) {
+		case TDS_DATEFMT_TEXT:
+			memcpy(p, fmt->format + op->pos, op->len);
+			p += op->len;
+			break;
+		case TDS_DATEFMT_YEAR:
+			p = tmp + 8;
+			start = tds_format_uint8((unsigned int) dr->year, p);
+			break;
+		case TDS_DATEFMT_YEAR2:
+			p = two_digits(p, (unsigned int) dr->year % 100u);
+			break;
+		case TDS_DATEFMT_MONTH:
+			p = two_digits(p, dr->month + 1);
+			break;
+		case TDS_DATEFMT_DAY:
+			p = two_digits(p, dr->day);
+			break;
+		case TDS_DATEFMT_DAY_BLANK:
+			p = two_digit_blank(p, dr->day);
+			break;
+		case TDS_DATEFMT_HOUR:
+			p = two_digits(p, dr->hour);
+			break;
+		case TDS_DATEFMT_HOUR12:
+			p = two_digits(p, (dr->hour + 11u) % 12u + 1);
+			break;
+		case TDS_DATEFMT_HOUR12_BLANK:
+			p = two_digit_blank(p, (dr->hour + 11u) % 12u + 1);
+			break;
+		case TDS_DATEFMT_MINUTE:
+			p = two_digits(p, dr->minute);
+			break;
+		case TDS_DATEFMT_SECOND:
+			p = two_digits(p, dr->second);
+			break;
+		case TDS_DATEFMT_DOT_FRACTION:
+			if (!prec)
+				continue;
+			*p++ = '.';
+			/* fall through */
+		case TDS_DATEFMT_FRACTION:
+			memset(p, '0', 7);
+			tds_format_uint8(dr->decimicrosecond, p + 7);
+			p += prec;
+			break;
+		case TDS_DATEFMT_MONTH_NAME:
+			name = fmt->names[op->pos + dr->month];
+			goto copy_name;
+		case TDS_DATEFMT_WEEKDAY_NAME:
+			name = fmt->names[op->pos + dr->weekday];
+			goto copy_name;
+		case TDS_DATEFMT_AMPM:
+			name = fmt->names[op->pos + (dr->hour >= 12)];
+		copy_name:
+			n = strlen(name);
+			if (len + n >= maxsize)
+				return 0;
+			memcpy(buf + len, name, n);
+			len += n;
+			continue;
+		default:
+			assert(0);
+			return 0;
+		}
+		n = p - start;
+		if (start != buf + len) {
+			if (len + n >= maxsize)
+				return 0;
+			memcpy(buf + len, start, n);
+		}
+		len += n;
+	}
+	if (len >= maxsize)
+		return 0;
+	buf[len] = 0;
+	return len;
+}
+
+/**
+ * Format a date replacing our extensions and calling strftime.
+ * Used for formats containing directives depending on locale.
+ */
+static size_t
+tds_strftime_ext(char *buf, size_t maxsize, const char *format, const TDSDATEREC * dr, int prec)
 {
 	struct tm tm;
 
 	size_t length;
+	char fmt_buf[128];
 	char *our_format;
 	char *pz;
 	bool z_found = false;
-	
-	assert(buf);
-	assert(format);
-	assert(dr);
-	assert(0 <= dr->decimicrosecond && dr->decimicrosecond < 10000000);
-	if (prec < 0 || prec > 7)
-		prec = 3;
 
-	tm.tm_sec = dr->second;
-	tm.tm_min = dr->minute;
-	tm.tm_hour = dr->hour;
-	tm.tm_mday = dr->day;
-	tm.tm_mon = dr->month;
-	tm.tm_year = dr->year - 1900;
-	tm.tm_wday = dr->weekday;
-	tm.tm_yday = dr->dayofyear;
-	tm.tm_isdst = 0;
-#ifdef HAVE_STRUCT_TM_TM_ZONE
-	tm.tm_zone = NULL;
-#elif defined(HAVE_STRUCT_TM___TM_ZONE)
-	tm.__tm_zone = NULL;
-#endif
+	tds_datefmt_tm(&tm, dr);
 
 	/* more characters are required because we replace %z with up to 7 digits */
-	our_format = tds_new(char, strlen(format) + 1 + 5 + 1);
-	if (!our_format)
-		return 0;
+	length = strlen(format) + 1 + 5 + 1;
+	our_format = fmt_buf;
+	if (length > sizeof(fmt_buf)) {
+		our_format = tds_new(char, length);
+		if (!our_format)
+			return 0;
+	}
 
 	strcpy(our_format, format);
 
@@ -3125,13 +3875,13 @@ tds_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEREC * d
 		case 'e':
 			/* not portable: day of month, single digit preceded by a blank */
 			/* not supported on old Windows versions */
-			two_digit(pz-1, dr->day);
+			two_digit_blank(pz-1, dr->day);
 			break;
 		case 'l':
 			/* not portable: 12-hour, single digit preceded by a blank */
 			/* not supported on: SCO Unix, AIX, HP-UX, Windows
 			 * supported on: *BSD, MacOS, Linux, Solaris */
-			two_digit(pz-1, (dr->hour + 11u) % 12u + 1);
+			two_digit_blank(pz-1, (dr->hour + 11u) % 12u + 1);
 			break;
 		case 'z':
 			/*
@@ -3162,11 +3912,86 @@ tds_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEREC * d
 
 	length = strftime(buf, maxsize, our_format, &tm);
 
-	free(our_format);
+	if (our_format != fmt_buf)
+		free(our_format);
 
 	return length;
 }
 
+/**
+ * Format a date using a compiled format.
+ * @param fmt     compiled format, see tds_datefmt_compile()
+ * @param buf     output buffer
+ * @param maxsize size of buffer in bytes (space include terminator)
+ * @param dr      date to convert
+ * @param prec    second fraction precision (0-7).
+ * @return length of string returned, 0 for error
+ */
+size_t
+tds_datefmt_format(const TDSDATEFMT *fmt, char *buf, size_t maxsize, const TDSDATEREC * dr, int prec)
+{
+	assert(buf);
+	assert(fmt);
+	assert(dr);
+	assert(0 <= dr->decimicrosecond && dr->decimicrosecond < 10000000);
+	if (prec < 0 || prec > 7)
+		prec = 3;
+
+	if (fmt->use_strftime)
+		return tds_strftime_ext(buf, maxsize, fmt->format, dr, prec);
+	return tds_datefmt_render(fmt, buf, maxsize, dr, prec);
+}
+
+/**
+ * format a date string according to an "extended" strftime(3) formatting definition.
+ * @param buf     output buffer
+ * @param maxsize size of buffer in bytes (space include terminator)
+ * @param format  format string passed to strftime(3), except that %z represents fraction of seconds.
+ * @param dr      date to convert
+ * @param prec    second fraction precision (0-7).
+ * @return length of string returned, 0 for error
+ */
+size_t
+tds_strftime(char *buf, size_t maxsize, const char *format, const TDSDATEREC * dr, int prec)
+{
+	TDS_DATEFMT_OP ops[32];
+	TDSDATEFMT fmt;
+	const char *p;
+	int n;
+	bool native = true;
+
+	assert(buf);
+	assert(format);
+	assert(dr);
+	assert(0 <= dr->decimicrosecond && dr->decimicrosecond < 10000000);
+	if (prec < 0 || prec > 7)
+		prec = 3;
+
+	/* format directly short formats not depending on locale */
+	for (p = format; *p && native; ++p) {
+		if (*p != '%')
+			continue;
+		switch (*++p) {
+		case 'Y': case 'y': case 'm': case 'd': case 'e': case 'H':
+		case 'I': case 'l': case 'M': case 'S': case 'z': case '%':
+			break;
+		default:
+			native = false;
+			break;
+		}
+	}
+	if (!native || p - format >= (ptrdiff_t) TDS_VECTOR_SIZE(ops))
+		return tds_strftime_ext(buf, maxsize, format, dr, prec);
+
+	n = tds_datefmt_parse(format, ops);
+	for (fmt.num_ops = 0; fmt.num_ops < (unsigned int) n; ++fmt.num_ops)
+		if (ops[fmt.num_ops].op == TDS_DATEFMT_STRFTIME)
+			return tds_strftime_ext(buf, maxsize, format, dr, prec);
+	fmt.ops = ops;
+	fmt.format = (char *) format;
+	return tds_datefmt_render(&fmt, buf, maxsize, dr, prec);
+}
+
 #if 0
 static TDS_UINT
 utf16len(const utf16_t * s)
@@ -3179,8 +4004,6 @@ utf16len(const utf16_t * s)
 }
 #endif
 
-#include "tds_willconvert.h"
-
 /**
  * Test if a conversion is possible
  * @param srctype  source type
@@ -3336,19 +4159,47 @@ tds_datecrack(TDS_INT datetype, const void *di, TDSDATEREC * dr)
 	 */
 	l = dt_days + (146038 + 146097*4);
 	wday = (l + 4) % 7;
-	n = (4 * l) / 146097;	/* n century */
-	l = l - (146097 * n + 3) / 4;	/* days from xx00-02-28 (y-m-d) */
-	i = (4000 * (l + 1)) / 1461001;	/* years from xx00-02-28 */
-	l = l - (1461 * i) / 4;	/* year days from xx00-02-28 */
-	ydays = l >= 306 ? l - 305 : l + 60;
-	l += 31;
-	j = (80 * l) / 2447;
-	days = l - (2447 * j) / 80;
-	l = j / 11;
-	months = j + 1 - 12 * l;
-	years = 100 * (n - 1) + i + l;
-	if (l == 0 && (years & 3) == 0 && (years % 100 != 0 || years % 400 == 0))
-		++ydays;
+	if (dt_days >= 365 && dt_days < 73049) {
+		/*
+		 * From 1901 to 2099 every 4th year is leap, use cycles of
+		 * 4 years and a table of month starts.
+		 */
+		static const short int month_starts[2][13] = {
+			{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+			{ 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 },
+		};
+		const short int *starts;
+
+		l = dt_days - 365;	/* days from 1901-01-01 */
+		n = l / 1461;		/* 4 years cycles */
+		l = l % 1461;
+		i = l / 365;		/* years in cycle, last one is leap */
+		if (i > 3)
+			i = 3;
+		l -= 365 * i;		/* year days, from 0 */
+		years = 1901 + 4 * n + i;
+		ydays = l + 1;
+		starts = month_starts[i == 3];
+		/* month is l / 32 or next one */
+		months = l >> 5;
+		if (l >= starts[months + 1])
+			++months;
+		days = l - starts[months] + 1;
+	} else {
+		n = (4 * l) / 146097;	/* n century */
+		l = l - (146097 * n + 3) / 4;	/* days from xx00-02-28 (y-m-d) */
+		i = (4000 * (l + 1)) / 1461001;	/* years from xx00-02-28 */
+		l = l - (1461 * i) / 4;	/* year days from xx00-02-28 */
+		ydays = l >= 306 ? l - 305 : l + 60;
+		l += 31;
+		j = (80 * l) / 2447;
+		days = l - (2447 * j) / 80;
+		l = j / 11;
+		months = j + 1 - 12 * l;
+		years = 100 * (n - 1) + i + l;
+		if (l == 0 && (years & 3) == 0 && (years % 100 != 0 || years % 400 == 0))
+			++ydays;
+	}
 
 	hours = dt_time / 60;
 	mins = dt_time % 60;
@@ -3578,6 +4429,44 @@ parse_numeric(const char *buf, const char *pend, bool *p_negative, size_t *p_dig
 	return start;
 }
 
+/**
+ * Parse simple numbers like "[+-]123.456" without calling strtod.
+ * Numbers with at most 15 digits are exact as double as are the powers
+ * of 10 we divide by so a single division gives a correctly rounded result.
+ * @return false if the number is not in this form, caller should use strtod
+ */
+static bool
+parse_simple_float(const char *s, const char *end, double *res)
+{
+	static const double powers_of_ten[] = {
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+		1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	};
+	TDS_UINT8 mantissa = 0;
+	unsigned int digit, digits = 0, decimals = 0;
+	bool negative = false;
+
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD != 0
+	/* extended precision could round twice */
+	return false;
+#endif
+	if (s != end && (*s == '-' || *s == '+'))
+		negative = (*s++ == '-');
+	for (; s != end && (digit = (unsigned char) *s - '0') <= 9; ++s, ++digits)
+		mantissa = mantissa * 10u + digit;
+	if (s != end && *s == '.')
+		for (++s; s != end && (digit = (unsigned char) *s - '0') <= 9; ++s, ++decimals)
+			mantissa = mantissa * 10u + digit;
+
+	if (s != end || digits + decimals == 0 || digits + decimals > 15)
+		return false;
+
+	*res = (double) mantissa / powers_of_ten[decimals];
+	if (negative)
+		*res = -*res;
+	return true;
+}
+
 static TDS_INT
 string_to_float(const TDS_CHAR * src, TDS_UINT srclen, int desttype, CONV_RESULT * cr)
 {
@@ -3593,18 +4482,20 @@ string_to_float(const TDS_CHAR * src, TDS_UINT srclen, int desttype, CONV_RESULT
 	while (srclen > 0 && (src[srclen - 1] == ' ' || src[srclen - 1] == '\0'))
 		--srclen;
 
-	if (srclen >= sizeof(tmpstr))
-		return TDS_CONVERT_OVERFLOW;
+	if (!parse_simple_float(src, src + srclen, &res)) {
+		if (srclen >= sizeof(tmpstr))
+			return TDS_CONVERT_OVERFLOW;
 
-	memcpy(tmpstr, src, srclen);
-	tmpstr[srclen] = 0;
+		memcpy(tmpstr, src, srclen);
+		tmpstr[srclen] = 0;
 
-	errno = 0;
-	res = strtod(tmpstr, &end);
-	if (errno == ERANGE)
-		return TDS_CONVERT_OVERFLOW;
-	if (end != tmpstr + srclen)
-		return TDS_CONVERT_SYNTAX;
+		errno = 0;
+		res = strtod(tmpstr, &end);
+		if (errno == ERANGE)
+			return TDS_CONVERT_OVERFLOW;
+		if (end != tmpstr + srclen)
+			return TDS_CONVERT_SYNTAX;
+	}
 
 	if (desttype == SYBREAL) {
 		/* FIXME check overflows */
@@ -29,6 +29,7 @@
 #include <assert.h>
 
 #include <freetds/tds.h>
+#include <freetds/convert.h>
 #include <freetds/iconv.h>
 #include <freetds/tls.h>
 #include <freetds/checks.h>
@@ -730,6 +731,7 @@ tds_alloc_context(void * parent)
 		tds_free_locale(locale);
 		return NULL;
 	}
+	tds_locale_compile_formats(locale);
 	context->locale = locale;
 	context->parent = parent;
 	context->money_use_2_digits = false;
@@ -1466,6 +1468,9 @@ tds_free_locale(TDSLOCALE * locale)
 	free(locale->datetime_fmt);
 	free(locale->date_fmt);
 	free(locale->time_fmt);
+	tds_datefmt_free(locale->datetime_compiled);
+	tds_datefmt_free(locale->date_compiled);
+	tds_datefmt_free(locale->time_compiled);
 	free(locale);
 }
 
@@ -1833,6 +1838,7 @@ tds_alloc_bcp_column_data(unsigned int column_size)
 	if (column_size > 4 * 1024)
 		column_size = 4 * 1024;
 	TEST_CALLOC(coldata->data, unsigned char, column_size);
+	coldata->datasize = column_size;
 
 	return coldata;
 Cleanup:
@@ -1875,6 +1881,8 @@ tds_deinit_bcpinfo(TDSBCPINFO *bcpinfo)
 	bcpinfo->bindinfo = NULL;
 	TDS_ZERO_FREE(bcpinfo->sybase_colinfo);
 	bcpinfo->sybase_count = 0;
+	TDS_ZERO_FREE(bcpinfo->plan);
+	bcpinfo->plan_count = bcpinfo->plan_fixed = bcpinfo->plan_variable = 0;
 }
 
 void
@@ -58,6 +58,43 @@ const int tds_numeric_bytes_per_prec[] = {
 TDS_COMPILE_CHECK(maxprecision,
 	MAXPRECISION < TDS_VECTOR_SIZE(tds_numeric_bytes_per_prec) );
 
+/** pairs of decimal digits from "00" to "99" */
+const char tds_digit_pairs[201] =
+	"00010203040506070809" "10111213141516171819"
+	"20212223242526272829" "30313233343536373839"
+	"40414243444546474849" "50515253545556575859"
+	"60616263646566676869" "70717273747576777879"
+	"80818283848586878889" "90919293949596979899";
+
+/**
+ * Format an unsigned number in decimal, two digits at a time.
+ * Digits are written backward, ending at \a end.
+ * @return pointer to first digit
+ */
+char *
+tds_format_uint8(TDS_UINT8 num, char *end)
+{
+	unsigned int n;
+
+	while (num > 0xffffffffu) {
+		end -= 2;
+		memcpy(end, tds_digit_pairs + (num % 100u) * 2u, 2);
+		num /= 100u;
+	}
+	/* use 32 bit divisions, faster on many platforms */
+	for (n = (unsigned int) num; n >= 100u; n /= 100u) {
+		end -= 2;
+		memcpy(end, tds_digit_pairs + (n % 100u) * 2u, 2);
+	}
+	if (n >= 10u) {
+		end -= 2;
+		memcpy(end, tds_digit_pairs + n * 2u, 2);
+	} else {
+		*--end = (char) ('0' + n);
+	}
+	return end;
+}
+
 /*
  * money is a special case of numeric really...that why its here
  */
@@ -66,7 +103,10 @@ tds_money_to_string(const TDS_MONEY * money, char *s, bool use_2_digits)
 {
 	TDS_INT8 mymoney;
 	TDS_UINT8 n;
-	char *p;
+	unsigned int frac;
+	char buf[32];
+	char *const end = buf + sizeof(buf);
+	char *p, *digits;
 
 	/* sometimes money it's only 4-byte aligned so always compute 64-bit */
 	mymoney = (((TDS_INT8) money->tdsoldmoney.mnyhigh) << 32) | money->tdsoldmoney.mnylow;
@@ -79,39 +119,184 @@ tds_money_to_string(const TDS_MONEY * money, char *s, bool use_2_digits)
 	} else {
 		n = mymoney;
 	}
-	/* if machine is 64 bit you do not need to split n */
+	/* format backward into buf, decimals first */
 	if (use_2_digits) {
 		n = (n+ 50) / 100;
-		sprintf(p, "%" PRIu64 ".%02u", n / 100u, (unsigned) (n % 100u));
+		frac = (unsigned int) (n % 100u);
+		n /= 100u;
+		digits = end - 2;
+		memcpy(digits, tds_digit_pairs + frac * 2u, 2);
 	} else {
-		sprintf(p, "%" PRIu64 ".%04u", n / 10000u, (unsigned) (n % 10000u));
+		frac = (unsigned int) (n % 10000u);
+		n /= 10000u;
+		digits = end - 4;
+		memcpy(digits, tds_digit_pairs + (frac / 100u) * 2u, 2);
+		memcpy(digits + 2, tds_digit_pairs + (frac % 100u) * 2u, 2);
 	}
+	*--digits = '.';
+	digits = tds_format_uint8(n, digits);
+	memcpy(p, digits, end - digits);
+	p[end - digits] = 0;
 	return s;
 }
 
+#define TDS_WORD  uint32_t
+#define TDS_DWORD uint64_t
+#define TDS_WORD_DDIGIT 9
+#define TDS_WORD_BITS (8 * sizeof(TDS_WORD))
+
+#undef USE_128_MULTIPLY
+#if defined(__GNUC__) && SIZEOF___INT128 > 0
+#define USE_128_MULTIPLY 1
+#undef __umulh
+#define __umulh(multiplier, multiplicand) \
+	((uint64_t) ((((unsigned __int128) (multiplier)) * (multiplicand)) >> 64))
+#endif
+#if defined(_MSC_VER) && (defined(_M_AMD64) || defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#define USE_128_MULTIPLY 1
+#endif
+
+#undef USE_I386_DIVIDE
+#undef USE_64_MULTIPLY
+#ifndef USE_128_MULTIPLY
+# if defined(__GNUC__) && __GNUC__ >= 3 && defined(__i386__)
+#  define USE_I386_DIVIDE 1
+# else
+#  define USE_64_MULTIPLY
+# endif
+#endif
+
+static const TDS_WORD factors[] = {
+	1, 10, 100, 1000, 10000,
+	100000, 1000000, 10000000, 100000000, 1000000000
+};
+#ifndef USE_I386_DIVIDE
+/* These numbers are computed as
+ * (2 ** (reverse_dividers_shift[i] + 64)) / (10 ** i) + 1
+ * (** is power).
+ * The shifts are computed to make sure the multiplication error
+ * does not cause a wrong result.
+ *
+ * See also misc/reverse_divisor script.
+ */
+static const TDS_DWORD reverse_dividers[] = {
+	1 /* not used */,
+	UINT64_C(1844674407370955162),
+	UINT64_C(184467440737095517),
+	UINT64_C(18446744073709552),
+	UINT64_C(1844674407370956),
+	UINT64_C(737869762948383),
+	UINT64_C(2361183241434823),
+	UINT64_C(15111572745182865),
+	UINT64_C(48357032784585167),
+	UINT64_C(1237940039285380275),
+};
+static const uint8_t reverse_dividers_shift[] = {
+	0 /* not used */,
+	0,
+	0,
+	0,
+	0,
+	2,
+	7,
+	13,
+	18,
+	26,
+};
+#endif
+
 /**
- * @return <0 if error
+ * Divide a number in packet format by 10^n.
+ * Division is computed with multiplications by the reverse divider
+ * (or a single instruction on i386) for each word.
+ * @param n  power of ten, from 1 to TDS_WORD_DDIGIT
+ * @return remainder of the division
  */
-TDS_INT
-tds_numeric_to_string(const TDS_NUMERIC * numeric, char *s)
+static TDS_WORD
+tds_packet_divide(TDS_WORD *packet, unsigned int packet_len, unsigned int n)
 {
-	const unsigned char *number;
+	TDS_WORD factor = factors[n];
+	TDS_WORD borrow = 0;
+	unsigned int i;
+#if defined(USE_128_MULTIPLY)
+	TDS_DWORD reverse_divider = reverse_dividers[n];
+	uint8_t shift = reverse_dividers_shift[n];
+#elif defined(USE_64_MULTIPLY)
+	TDS_WORD reverse_divider_low = (TDS_WORD) reverse_dividers[n];
+	TDS_WORD reverse_divider_high = (TDS_WORD) (reverse_dividers[n] >> TDS_WORD_BITS);
+	uint8_t shift = reverse_dividers_shift[n];
+#endif
 
-	unsigned int packet[sizeof(numeric->array) / 2];
-	unsigned int *pnum, *packet_start;
-	unsigned int *const packet_end = packet + TDS_VECTOR_SIZE(packet);
+	for (i = packet_len; i > 0; ) {
+#ifdef USE_I386_DIVIDE
+		--i;
+		/* For different reasons this code is still here.
+		 * But mainly because although compilers do wonderful things this is hard to get.
+		 * One of the reason is that it's hard to understand that the double-precision division
+		 * result will fit into 32-bit.
+		 */
+		__asm__ ("divl %4": "=a"(packet[i]), "=d"(borrow): "0"(packet[i]), "1"(borrow), "r"(factor));
+#else
+		TDS_DWORD n = (((TDS_DWORD) borrow) << TDS_WORD_BITS) + packet[--i];
+#if defined(USE_128_MULTIPLY)
+		TDS_DWORD quotient = __umulh(n, reverse_divider);
+#else
+		TDS_DWORD mul1 = (TDS_DWORD) packet[i] * reverse_divider_low;
+		TDS_DWORD mul2 = (TDS_DWORD) borrow * reverse_divider_low + (mul1 >> TDS_WORD_BITS);
+		TDS_DWORD mul3 = (TDS_DWORD) packet[i] * reverse_divider_high;
+		TDS_DWORD quotient = (TDS_DWORD) borrow * reverse_divider_high + (mul3 >> TDS_WORD_BITS);
+		quotient += (mul2 + (mul3 & 0xffffffffu)) >> TDS_WORD_BITS;
+#endif
+		quotient >>= shift;
+		packet[i] = (TDS_WORD) quotient;
+		borrow = (TDS_WORD) (n - quotient * factor);
+#endif
+	}
+	return borrow;
+}
+
+/**
+ * Unpack numeric absolute value into words, less significant first.
+ * @return number of words, at least 1, without high zero words
+ */
+static unsigned int
+tds_numeric_to_packet(const TDS_NUMERIC *numeric, TDS_WORD *packet)
+{
+	int bytes = tds_numeric_bytes_per_prec[numeric->precision] - 1;
+	unsigned int i = 0;
 
-	unsigned int packet10k[(MAXPRECISION + 3) / 4];
-	unsigned int *p;
+	do {
+		/*
+		 * note that if bytes are smaller we have a small buffer
+		 * overflow in numeric->array however is not a problem
+		 * cause overflow occurs in numeric and number is fixed below
+		 */
+		packet[i] = TDS_GET_UA4BE(&numeric->array[bytes-3]);
+		++i;
+	} while ( (bytes -= sizeof(TDS_WORD)) > 0);
+	/* fix last packet */
+	if (bytes < 0)
+		packet[i-1] &= 0xffffffffu >> (8 * -bytes);
+	while (i > 1 && packet[i-1] == 0)
+		--i;
+	return i;
+}
 
-	int num_bytes;
-	unsigned int remainder, n, i, m;
+/**
+ * @return <0 if error
+ */
+TDS_INT
+tds_numeric_to_string(const TDS_NUMERIC * numeric, char *s)
+{
+	TDS_WORD packet[(sizeof(numeric->array) - 1) / sizeof(TDS_WORD)];
+	unsigned int packet_len;
 
-	/* a bit of debug */
-#if ENABLE_EXTRA_CHECKS
-	memset(packet, 0x55, sizeof(packet));
-	memset(packet10k, 0x55, sizeof(packet10k));
-#endif
+	/* digits are formatted backward, 9 at a time */
+	char digits[(MAXPRECISION + TDS_WORD_DDIGIT - 1) / TDS_WORD_DDIGIT * TDS_WORD_DDIGIT];
+	char *const end = digits + sizeof(digits);
+	char *p = end;
+	unsigned int i, len;
 
 	if (numeric->precision < 1 || numeric->precision > MAXPRECISION || numeric->scale > numeric->precision)
 		return TDS_CONVERT_FAIL;
@@ -120,85 +305,48 @@ tds_numeric_to_string(const TDS_NUMERIC * numeric, char *s)
 	if (numeric->array[0] == 1)
 		*s++ = '-';
 
-	/* put number in a 16bit array */
-	number = numeric->array;
-	num_bytes = tds_numeric_bytes_per_prec[numeric->precision];
-
-	n = num_bytes - 1;
-	pnum = packet_end;
-	for (; n > 1; n -= 2)
-		*--pnum = TDS_GET_UA2BE(&number[n - 1]);
-	if (n == 1)
-		*--pnum = number[n];
-	while (!*pnum) {
-		++pnum;
-		if (pnum == packet_end) {
-			*s++ = '0';
-			if (numeric->scale) {
-				*s++ = '.';
-				i = numeric->scale;
-				do {
-					*s++ = '0';
-				} while (--i);
-			}
-			*s = 0;
-			return 1;
-		}
-	}
-	packet_start = pnum;
-
-	/* transform 2^16 base number in 10^4 base number */
-	for (p = packet10k + TDS_VECTOR_SIZE(packet10k); packet_start != packet_end;) {
-		pnum = packet_start;
-		n = *pnum;
-		remainder = n % 10000u;
-		if (!(*pnum++ = (n / 10000u)))
-			packet_start = pnum;
-		for (; pnum != packet_end; ++pnum) {
-			n = remainder * (256u * 256u) + *pnum;
-			remainder = n % 10000u;
-			*pnum = n / 10000u;
+	/* split in 10^9 chunks, while number does not fit in a word */
+	packet_len = tds_numeric_to_packet(numeric, packet);
+	while (packet_len > 1) {
+		TDS_WORD chunk = tds_packet_divide(packet, packet_len, TDS_WORD_DDIGIT);
+
+		if (packet[packet_len-1] == 0)
+			--packet_len;
+		for (i = 0; i < 4; ++i) {
+			p -= 2;
+			memcpy(p, tds_digit_pairs + (chunk % 100u) * 2u, 2);
+			chunk /= 100u;
 		}
-		*--p = remainder;
+		*--p = (char) ('0' + chunk);
 	}
+	if (packet[0] || p == end)
+		p = tds_format_uint8(packet[0], p);
 
-	/* transform to 10 base number and output */
-	i = 4 * (unsigned int)((packet10k + TDS_VECTOR_SIZE(packet10k)) - p);	/* current digit */
-	/* skip leading zeroes */
-	n = 1000;
-	remainder = *p;
-	while (remainder < n)
-		n /= 10, --i;
-	if (i <= numeric->scale) {
+	/* zero is formatted as a single digit, so skip it */
+	len = (unsigned int) (end - p);
+	if (len == 1 && *p == '0')
+		len = 0, p = end;
+
+	if (len <= numeric->scale) {
 		*s++ = '0';
-		*s++ = '.';
-		m = i;
-		while (m < numeric->scale)
-			*s++ = '0', ++m;
-	}
-	for (;;) {
-		*s++ = (remainder / n) + '0';
-		--i;
-		remainder %= n;
-		n /= 10;
-		if (!n) {
-			n = 1000;
-			if (++p == packet10k + TDS_VECTOR_SIZE(packet10k))
-				break;
-			remainder = *p;
+		if (numeric->scale) {
+			*s++ = '.';
+			memset(s, '0', numeric->scale - len);
+			s += numeric->scale - len;
 		}
-		if (i == numeric->scale)
+	} else {
+		memcpy(s, p, len - numeric->scale);
+		s += len - numeric->scale;
+		p += len - numeric->scale;
+		if (numeric->scale)
 			*s++ = '.';
 	}
-	*s = 0;
+	memcpy(s, p, end - p);
+	s[end - p] = 0;
 
 	return 1;
 }
 
-#define TDS_WORD  uint32_t
-#define TDS_DWORD uint64_t
-#define TDS_WORD_DDIGIT 9
-
 /* include to check limits */
 
 #include "num_limits.h"
@@ -239,71 +387,9 @@ tds_packet_check_overflow(TDS_WORD *packet, unsigned int packet_len, unsigned in
 	return 0;
 }
 
-#undef USE_128_MULTIPLY
-#if defined(__GNUC__) && SIZEOF___INT128 > 0
-#define USE_128_MULTIPLY 1
-#undef __umulh
-#define __umulh(multiplier, multiplicand) \
-	((uint64_t) ((((unsigned __int128) (multiplier)) * (multiplicand)) >> 64))
-#endif
-#if defined(_MSC_VER) && (defined(_M_AMD64) || defined(_M_X64) || defined(_M_ARM64))
-#include <intrin.h>
-#define USE_128_MULTIPLY 1
-#endif
-
-#undef USE_I386_DIVIDE
-#undef USE_64_MULTIPLY
-#ifndef USE_128_MULTIPLY
-# if defined(__GNUC__) && __GNUC__ >= 3 && defined(__i386__)
-#  define USE_I386_DIVIDE 1
-# else
-#  define USE_64_MULTIPLY
-# endif
-#endif
-
 TDS_INT
 tds_numeric_change_prec_scale(TDS_NUMERIC * numeric, unsigned char new_prec, unsigned char new_scale)
 {
-#define TDS_WORD_BITS (8 * sizeof(TDS_WORD))
-	static const TDS_WORD factors[] = {
-		1, 10, 100, 1000, 10000,
-		100000, 1000000, 10000000, 100000000, 1000000000
-	};
-#ifndef USE_I386_DIVIDE
-	/* These numbers are computed as
-	 * (2 ** (reverse_dividers_shift[i] + 64)) / (10 ** i) + 1
-	 * (** is power).
-	 * The shifts are computed to make sure the multiplication error
-	 * does not cause a wrong result.
-	 *
-	 * See also misc/reverse_divisor script.
-	 */
-	static const TDS_DWORD reverse_dividers[] = {
-		1 /* not used */,
-		UINT64_C(1844674407370955162),
-		UINT64_C(184467440737095517),
-		UINT64_C(18446744073709552),
-		UINT64_C(1844674407370956),
-		UINT64_C(737869762948383),
-		UINT64_C(2361183241434823),
-		UINT64_C(15111572745182865),
-		UINT64_C(48357032784585167),
-		UINT64_C(1237940039285380275),
-	};
-	static const uint8_t reverse_dividers_shift[] = {
-		0 /* not used */,
-		0,
-		0,
-		0,
-		0,
-		2,
-		7,
-		13,
-		18,
-		26,
-	};
-#endif
-
 	TDS_WORD packet[(sizeof(numeric->array) - 1) / sizeof(TDS_WORD)];
 
 	unsigned int i, packet_len;
@@ -327,23 +413,7 @@ tds_numeric_change_prec_scale(TDS_NUMERIC * numeric, unsigned char new_prec, uns
 	}
 
 	/* package number */
-	bytes = tds_numeric_bytes_per_prec[numeric->precision] - 1;
-	i = 0;
-	do {
-		/*
-		 * note that if bytes are smaller we have a small buffer
-		 * overflow in numeric->array however is not a problem
-		 * cause overflow occurs in numeric and number is fixed below
-		 */
-		packet[i] = TDS_GET_UA4BE(&numeric->array[bytes-3]);
-		++i;
-	} while ( (bytes -= sizeof(TDS_WORD)) > 0);
-	/* fix last packet */
-	if (bytes < 0)
-		packet[i-1] &= 0xffffffffu >> (8 * -bytes);
-	while (i > 1 && packet[i-1] == 0)
-		--i;
-	packet_len = i;
+	packet_len = tds_numeric_to_packet(numeric, packet);
 
 	if (scale_diff >= 0) {
 		/* check overflow before multiply */
@@ -384,42 +454,8 @@ tds_numeric_change_prec_scale(TDS_NUMERIC * numeric, unsigned char new_prec, uns
 		scale_diff = -scale_diff;
 		do {
 			unsigned int n = scale_diff > TDS_WORD_DDIGIT ? TDS_WORD_DDIGIT : scale_diff;
-			TDS_WORD factor = factors[n];
-			TDS_WORD borrow = 0;
-#if defined(USE_128_MULTIPLY)
-			TDS_DWORD reverse_divider = reverse_dividers[n];
-			uint8_t shift = reverse_dividers_shift[n];
-#elif defined(USE_64_MULTIPLY)
-			TDS_WORD reverse_divider_low = (TDS_WORD) reverse_dividers[n];
-			TDS_WORD reverse_divider_high = (TDS_WORD) (reverse_dividers[n] >> TDS_WORD_BITS);
-			uint8_t shift = reverse_dividers_shift[n];
-#endif
 			scale_diff -= n;
-			for (i = packet_len; i > 0; ) {
-#ifdef USE_I386_DIVIDE
-				--i;
-				/* For different reasons this code is still here.
-				 * But mainly because although compilers do wonderful things this is hard to get.
-				 * One of the reason is that it's hard to understand that the double-precision division
-				 * result will fit into 32-bit.
-				 */
-				__asm__ ("divl %4": "=a"(packet[i]), "=d"(borrow): "0"(packet[i]), "1"(borrow), "r"(factor));
-#else
-				TDS_DWORD n = (((TDS_DWORD) borrow) << TDS_WORD_BITS) + packet[--i];
-#if defined(USE_128_MULTIPLY)
-				TDS_DWORD quotient = __umulh(n, reverse_divider);
-#else
-				TDS_DWORD mul1 = (TDS_DWORD) packet[i] * reverse_divider_low;
-				TDS_DWORD mul2 = (TDS_DWORD) borrow * reverse_divider_low + (mul1 >> TDS_WORD_BITS);
-				TDS_DWORD mul3 = (TDS_DWORD) packet[i] * reverse_divider_high;
-				TDS_DWORD quotient = (TDS_DWORD) borrow * reverse_divider_high + (mul3 >> TDS_WORD_BITS);
-				quotient += (mul2 + (mul3 & 0xffffffffu)) >> TDS_WORD_BITS;
-#endif
-				quotient >>= shift;
-				packet[i] = (TDS_WORD) quotient;
-				borrow = (TDS_WORD) (n - quotient * factor);
-#endif
-			}
+			tds_packet_divide(packet, packet_len, n);
 		} while (scale_diff > 0);
 	}
 
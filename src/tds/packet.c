@@ -430,15 +430,67 @@ tds_connection_network(TDSCONNECTION *conn, TDSSOCKET *tds, int send)
 	conn->in_net_tds = NULL;
 }
 
+/**
+ * Maximum number of packets a session can queue before waiting.
+ * Used for bulk data which is not waited to be sent.
+ */
+#define TDS_MAX_QUEUED_PACKETS 16
+
+/**
+ * Send queued packets as long as socket accepts data without waiting.
+ * Must be called with list_mtx locked, only for connections not using MARS.
+ * \return true if caller does not need to wait for its packets to be sent
+ */
+static bool
+tds_connection_send_queued(TDSCONNECTION *conn, TDSSOCKET *tds)
+{
+	TDSPACKET *pkt;
+	unsigned queued = 0;
+
+	if (!conn->in_net_tds) {
+		conn->in_net_tds = tds;
+		tds_mutex_unlock(&conn->list_mtx);
+		while (conn->send_packets) {
+			unsigned pos = conn->send_pos;
+			TDSPACKET *first = conn->send_packets;
+
+			/* stop when socket buffer is full */
+			if (tds_packet_write(conn) < 0 && conn->send_packets == first && conn->send_pos == pos)
+				break;
+		}
+		tds_mutex_lock(&conn->list_mtx);
+		conn->in_net_tds = NULL;
+	}
+
+	if (IS_TDSDEAD(tds))
+		return false;
+
+	for (pkt = conn->send_packets; pkt; pkt = pkt->next)
+		if (++queued >= TDS_MAX_QUEUED_PACKETS)
+			return false;
+	return true;
+}
+
 static TDSRET
 tds_connection_put_packet(TDSSOCKET *tds, TDSPACKET *packet)
 {
 	TDSCONNECTION *conn = tds->conn;
+	const unsigned char *header = packet->buf + tds_packet_get_data_start(packet);
+	bool pipelined;
 
 	CHECK_TDS_EXTRA(tds);
 
 	packet->sid = tds->sid;
 
+	/*
+	 * Bulk data are not waited to be sent, so we can encode other rows
+	 * while previous packets are being sent. Last packet is waited as
+	 * usual so all data are sent before reading the response.
+	 * Sockets are not blocking, but TLS layer could not support partial writes.
+	 * With MARS other sessions could wait for the network, keep it simple.
+	 */
+	pipelined = header[0] == TDS_BULK && !(header[1] & 1) && !conn->tls_session && !conn->mars;
+
 	tds_mutex_lock(&conn->list_mtx);
 	tds->sending_packet = packet;
 	while (tds->sending_packet) {
@@ -471,6 +523,9 @@ tds_connection_put_packet(TDSSOCKET *tds, TDSPACKET *packet)
 			/* append packet */
 			tds_append_packet(&conn->send_packets, packet);
 			packet = NULL;
+
+			if (pipelined && tds_connection_send_queued(conn, tds))
+				break;
 		}
 
 		/* network ok ? process network */
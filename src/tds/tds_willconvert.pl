@@ -127,6 +127,37 @@ for my $catFrom (@converts) {
 	}
 	print "\t$conv,\t/* $catFrom */\n";
 }
+print "};\n\n";
+
+# read functions converting from each type
+my @converters = ('noavail');
+my %converterIndex = (noavail => 0);
+my @typeConverter = (0) x 256;
+while(<DATA>) {
+	next if /^\s*$/ || /^Converters/;
+	my ($from, $name) = split;
+	if (!exists($converterIndex{$name})) {
+		$converterIndex{$name} = scalar(@converters);
+		push @converters, $name;
+	}
+	foreach $from (category($from)) {
+		$from = to_type($from);
+		die $from if !exists($typesNum{$from});
+		$typeConverter[$typesNum{$from}] = $converterIndex{$name};
+	}
+}
+die if @converters >= 256;
+
+# output functions and array to translate source type to function
+print "static const TDS_CONVERT_FUNC converters[] = {\n";
+print "\ttds_convert_from_$_,\n" for @converters;
+print "};\n\n";
+
+print "static const uint8_t type2converter[256] = {\n";
+for my $n (0..255) {
+	my $comment = $typeNames[$n] ? $typeNames[$n] : "$n";
+	print "\t$typeConverter[$n], /* $comment */\n";
+}
 print "};\n";
 
 __DATA__
@@ -147,3 +178,35 @@ BOUNDARY    T     T    F       F    F    F       F       F    F      F         T
 UNIQUE      T     T    T       F    F    F       F       F    F      F         F        T      F           F
 SENSITIVITY t     t    F       F    F    F       F       F    F      F         F        F      t           F
 MSTABLE     F     F    F       F    F    F       F       F    F      F         F        F      F           T
+
+Converters
+CHARx       char
+TEXT        char
+BINARYx     binary
+MONEY4      money4
+MONEY       money
+NUMERIC     numeric
+DECIMAL     numeric
+BITx        bit
+SINT1       int1
+INT1        uint1
+UINT1       uint1
+INT2        int2
+UINT2       uint2
+INT4        int4
+UINT4       uint4
+INT8        int8
+UINT8       uint8
+REAL        real
+FLT8        flt8
+MSTIME      datetimeall
+MSDATE      datetimeall
+MSDATETIME2 datetimeall
+MSDATETIMEOFFSET datetimeall
+DATETIME    datetime
+DATETIME4   datetime4
+TIME        time
+DATE        date
+5BIGTIME    bigtime
+5BIGDATETIME bigdatetime
+UNIQUE      unique
@@ -0,0 +1,154 @@
+/* FreeTDS - Library of routines accessing Sybase and Microsoft databases
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Purpose: test tds_convert_batch gives the same results as tds_convert.
+ */
+#include "common.h"
+#include <assert.h>
+#include <freetds/convert.h>
+
+static TDSCONTEXT *ctx;
+
+static const int types[] = {
+	SYBBIT, SYBSINT1, SYBINT1, SYBUINT1, SYBINT2, SYBUINT2, SYBINT4, SYBUINT4,
+	SYBINT8, SYBUINT8, SYBREAL, SYBFLT8, SYBMONEY4, SYBMONEY, SYBNUMERIC,
+	SYBDATETIME4, SYBDATETIME, SYBUNIQUE, SYBVARCHAR, SYBVARBINARY,
+	0
+};
+
+static const char *strings[] = {
+	"0", "1", "-1", "127", "128", "-129", "255", "256", "32767", "-40000", "65535",
+	"2147483647", "-2147483648", "3000000000", "-3000000000", "9223372036854775807",
+	"12.5", "2020-01-02 03:04:05", "12345678-1234-1234-1234-123456789012",
+	NULL
+};
+
+#define MAX_VALUES 32
+
+static bool
+is_var_type(int type)
+{
+	return type == SYBVARCHAR || type == SYBVARBINARY;
+}
+
+static void
+init_result(CONV_RESULT *cr)
+{
+	memset(cr, 0, sizeof(*cr));
+	cr->n.precision = 20;
+	cr->n.scale = 2;
+}
+
+static void
+free_result(int type, CONV_RESULT *cr, TDS_INT len)
+{
+	if (len >= 0 && is_var_type(type))
+		free(cr->c);
+}
+
+static void
+test(int srctype, int desttype)
+{
+	CONV_RESULT values[MAX_VALUES], batch[MAX_VALUES], single;
+	const void *src[MAX_VALUES];
+	TDS_UINT srclens[MAX_VALUES];
+	TDS_INT destlens[MAX_VALUES], len;
+	unsigned char nulls[MAX_VALUES];
+	const char **s;
+	int n = 0, i, converted;
+
+	if (!tds_willconvert(srctype, desttype))
+		return;
+
+	/* build source values, add a NULL in the middle */
+	for (s = strings; *s; ++s) {
+		init_result(&values[n]);
+		len = tds_convert(ctx, SYBVARCHAR, *s, (TDS_UINT) strlen(*s), srctype, &values[n]);
+		if (len < 0)
+			continue;
+		src[n] = is_var_type(srctype) ? (const void *) values[n].c : (const void *) &values[n];
+		srclens[n] = len;
+		nulls[n] = 0;
+		if (++n == 3) {
+			values[n] = values[0];
+			src[n] = src[0];
+			srclens[n] = srclens[0];
+			nulls[n++] = 1;
+		}
+	}
+
+	for (i = 0; i < n; ++i)
+		init_result(&batch[i]);
+	converted = tds_convert_batch(ctx, srctype, src, srclens, n, desttype, batch, destlens, nulls);
+	assert(converted >= 0 && converted <= n);
+
+	for (i = 0; i < n && i <= converted; ++i) {
+		if (i == converted) {
+			assert(destlens[i] < 0);
+			break;
+		}
+		if (nulls[i]) {
+			assert(destlens[i] == 0);
+			continue;
+		}
+		init_result(&single);
+		len = tds_convert(ctx, srctype, src[i], srclens[i], desttype, &single);
+		if (len != destlens[i]
+		    || (len > 0 && memcmp(is_var_type(desttype) ? (const void *) single.c : (const void *) &single,
+					  is_var_type(desttype) ? (const void *) batch[i].c : (const void *) &batch[i],
+					  len) != 0)) {
+			fprintf(stderr, "Different results converting from %s to %s value %d: %d %d\n",
+				tds_prtype(srctype), tds_prtype(desttype), i, (int) len, (int) destlens[i]);
+			exit(1);
+		}
+		free_result(desttype, &single, len);
+		free_result(desttype, &batch[i], destlens[i]);
+	}
+
+	/* conversion stopped at first error, check it is really an error */
+	if (converted < n) {
+		init_result(&single);
+		len = tds_convert(ctx, srctype, src[converted], srclens[converted], desttype, &single);
+		assert(len == destlens[converted]);
+	}
+
+	for (i = 0; i < n; ++i)
+		if (!nulls[i])
+			free_result(srctype, &values[i], srclens[i]);
+}
+
+int
+main(void)
+{
+	const int *srctype, *desttype;
+
+	ctx = tds_alloc_context(NULL);
+	assert(ctx);
+	if (!ctx->locale->datetime_fmt) {
+		/* set default in case there's no locale file */
+		ctx->locale->datetime_fmt = strdup(STD_DATETIME_FMT);
+	}
+
+	for (srctype = types; *srctype; ++srctype)
+		for (desttype = types; *desttype; ++desttype)
+			test(*srctype, *desttype);
+
+	tds_free_context(ctx);
+	return 0;
+}
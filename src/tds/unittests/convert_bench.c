@@ -0,0 +1,345 @@
+/* FreeTDS - Library of routines accessing Sybase and Microsoft databases
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Purpose: measure conversion performance.
+ * For every conversion allowed by tds_willconvert time tds_convert
+ * using a set of input values and print results as CSV, one line
+ * for each conversion.
+ * This is not run by "make check", usage:
+ * $ ./convert_bench [iterations] > results.csv
+ */
+#include "common.h"
+#include <assert.h>
+#include <freetds/convert.h>
+#include <freetds/replacements.h>
+
+#include <freetds/time.h>
+
+enum value_kind {
+	KIND_OTHER,
+	KIND_CHAR,
+	KIND_BINARY,
+	KIND_BIT,
+	KIND_INT,
+	KIND_NUMERIC,
+	KIND_DATE,
+	KIND_TIME,
+	KIND_UNIQUE,
+};
+
+typedef struct {
+	const char *value;
+	/* precision and scale, used only for numeric types */
+	unsigned char precision, scale;
+} bench_value;
+
+static const bench_value bit_values[] = {
+	{ "0" }, { "1" }, { NULL }
+};
+
+static const bench_value int_values[] = {
+	{ "0" }, { "1" }, { "-42" }, { "255" }, { "32767" }, { "-2147483648" },
+	{ "9223372036854775807" }, { NULL }
+};
+
+static const bench_value numeric_values[] = {
+	{ "0.5", 3, 1 },
+	{ "1999.25", 8, 2 },
+	{ "-3.14159", 6, 5 },
+	{ "12345678.9", 10, 1 },
+	{ "-922337203685477.5807", 19, 4 },
+	{ "12345678901234567890123456.789012345678", 38, 12 },
+	{ NULL }
+};
+
+/* dates across eras, both ISO and legacy formats */
+static const bench_value date_values[] = {
+	{ "1753-01-01 00:00:00" },
+	{ "Jan  1 1900 12:00AM" },
+	{ "1970-01-01 12:34:56.123" },
+	{ "1999-12-31T23:59:59.997" },
+	{ "2024-02-29 08:15:30.5" },
+	{ "2079-06-06" },
+	{ "9999-12-31 23:59:59.9999999" },
+	{ NULL }
+};
+
+static const bench_value time_values[] = {
+	{ "00:00:00" }, { "12:34:56.1234567" }, { "11:59PM" }, { "23:59:59.997" }, { NULL }
+};
+
+static const bench_value unique_values[] = {
+	{ "A8C60F70-5BD4-3E02-B769-7CCCCA585DCC" },
+	{ "00000000-0000-0000-0000-000000000001" },
+	{ NULL }
+};
+
+static char long_string[1025];
+static char long_hex[2 + 2048 + 1];
+static TDS_UCHAR long_binary[1024];
+
+static const bench_value char_values[] = {
+	{ "" }, { "a" }, { "Hello world" }, { long_string }, { NULL }
+};
+
+static const bench_value binary_values[] = {
+	{ "0xbeef" }, { "0x0123456789abcdef0123456789abcdef" }, { long_hex }, { NULL }
+};
+
+#define MAX_INPUTS 16
+
+typedef struct {
+	const TDS_CHAR *data;
+	TDS_UINT len;
+	CONV_RESULT value;
+} bench_input;
+
+static TDSCONTEXT *ctx;
+static bench_input inputs[MAX_INPUTS];
+static unsigned num_inputs;
+static int iterations = 1000;
+
+static enum value_kind
+type_kind(int type)
+{
+	switch (type) {
+	case SYBBIT:
+	case SYBBITN:
+		return KIND_BIT;
+	case SYBINT1:
+	case SYBSINT1:
+	case SYBUINT1:
+	case SYBINT2:
+	case SYBUINT2:
+	case SYBINT4:
+	case SYBUINT4:
+	case SYBINT8:
+	case SYBUINT8:
+		return KIND_INT;
+	case SYBNUMERIC:
+	case SYBDECIMAL:
+	case SYBMONEY:
+	case SYBMONEY4:
+	case SYBREAL:
+	case SYBFLT8:
+		return KIND_NUMERIC;
+	case SYBDATETIME:
+	case SYBDATETIME4:
+	case SYBDATE:
+	case SYBMSDATE:
+	case SYBMSDATETIME2:
+	case SYBMSDATETIMEOFFSET:
+	case SYB5BIGDATETIME:
+		return KIND_DATE;
+	case SYBTIME:
+	case SYBMSTIME:
+	case SYB5BIGTIME:
+		return KIND_TIME;
+	case SYBUNIQUE:
+		return KIND_UNIQUE;
+	}
+	if (is_char_type(type))
+		return KIND_CHAR;
+	if (is_binary_type(type) || type == SYBLONGBINARY)
+		return KIND_BINARY;
+	return KIND_OTHER;
+}
+
+static const bench_value *
+kind_values(enum value_kind kind)
+{
+	switch (kind) {
+	case KIND_CHAR:
+		return char_values;
+	case KIND_BINARY:
+		return binary_values;
+	case KIND_BIT:
+		return bit_values;
+	case KIND_INT:
+		return int_values;
+	case KIND_NUMERIC:
+		return numeric_values;
+	case KIND_DATE:
+		return date_values;
+	case KIND_TIME:
+		return time_values;
+	case KIND_UNIQUE:
+		return unique_values;
+	default:
+		break;
+	}
+	return NULL;
+}
+
+static TDS_INT
+convert_and_free(int srctype, const TDS_CHAR *src, TDS_UINT srclen, int desttype, CONV_RESULT *cr)
+{
+	TDS_INT res;
+
+	if (is_numeric_type(desttype)) {
+		cr->n.precision = 38;
+		cr->n.scale = 10;
+	}
+	res = tds_convert(ctx, srctype, src, srclen, desttype, cr);
+	if (res < 0)
+		return res;
+
+	switch (desttype) {
+	case SYBCHAR: case SYBVARCHAR: case SYBTEXT: case XSYBCHAR: case XSYBVARCHAR:
+	case SYBBINARY: case SYBVARBINARY: case SYBIMAGE: case XSYBBINARY: case XSYBVARBINARY:
+	case SYBLONGBINARY:
+		free(cr->c);
+		break;
+	}
+	return res;
+}
+
+/* add an input, if it can be converted to the destination */
+static void
+add_input(int srctype, const TDS_CHAR *data, TDS_UINT len, int desttype)
+{
+	CONV_RESULT cr;
+	bench_input *input;
+
+	assert(num_inputs < MAX_INPUTS);
+	input = &inputs[num_inputs];
+	if (data == NULL)
+		data = (const TDS_CHAR *) &input->value;
+	if (convert_and_free(srctype, data, len, desttype, &cr) < 0)
+		return;
+	input->data = data;
+	input->len = len;
+	++num_inputs;
+}
+
+/* fill inputs with values of srctype which can be converted to desttype */
+static void
+prepare_inputs(int srctype, int desttype)
+{
+	enum value_kind kind = type_kind(srctype);
+	const bench_value *values;
+	TDS_INT len;
+
+	num_inputs = 0;
+
+	/* for strings use values meaningful for destination */
+	if (kind == KIND_CHAR) {
+		values = kind_values(type_kind(desttype));
+		for (; values && values->value; ++values)
+			add_input(srctype, values->value, strlen(values->value), desttype);
+		return;
+	}
+
+	if (kind == KIND_BINARY) {
+		static const TDS_UCHAR short_binary[] = { 0x12, 0x34, 0x56, 0x78 };
+		static const TDS_UCHAR guid_binary[] = {
+			0x70, 0x0f, 0xc6, 0xa8, 0xd4, 0x5b, 0x02, 0x3e,
+			0xb7, 0x69, 0x7c, 0xcc, 0xca, 0x58, 0x5d, 0xcc
+		};
+
+		add_input(srctype, (const TDS_CHAR *) short_binary, sizeof(short_binary), desttype);
+		add_input(srctype, (const TDS_CHAR *) guid_binary, sizeof(guid_binary), desttype);
+		add_input(srctype, (const TDS_CHAR *) long_binary, sizeof(long_binary), desttype);
+		return;
+	}
+
+	/* other types, convert from string to get source values */
+	values = kind_values(kind);
+	for (; values && values->value; ++values) {
+		CONV_RESULT *cr = &inputs[num_inputs].value;
+
+		cr->n.precision = values->precision;
+		cr->n.scale = values->scale;
+		len = tds_convert(ctx, SYBVARCHAR, values->value, strlen(values->value), srctype, cr);
+		if (len < 0)
+			continue;
+		add_input(srctype, NULL, len, desttype);
+	}
+}
+
+static double
+get_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return (double) tv.tv_sec + (double) tv.tv_usec * 0.000001;
+}
+
+static void
+bench(int srctype, int desttype)
+{
+	CONV_RESULT cr;
+	double start, elapsed;
+	unsigned n;
+	int i;
+
+	prepare_inputs(srctype, desttype);
+	if (!num_inputs) {
+		printf("%d,%s,%d,%s,0,0,\n", srctype, tds_prtype(srctype), desttype, tds_prtype(desttype));
+		return;
+	}
+
+	start = get_time();
+	for (i = 0; i < iterations; ++i)
+		for (n = 0; n < num_inputs; ++n)
+			convert_and_free(srctype, inputs[n].data, inputs[n].len, desttype, &cr);
+	elapsed = get_time() - start;
+
+	printf("%d,%s,%d,%s,%u,%.0f,%.1f\n", srctype, tds_prtype(srctype), desttype, tds_prtype(desttype),
+	       num_inputs, (double) iterations * num_inputs,
+	       elapsed * 1e9 / ((double) iterations * num_inputs));
+}
+
+int
+main(int argc, char **argv)
+{
+	int srctype, desttype;
+	int i;
+
+	if (argc > 1)
+		iterations = atoi(argv[1]);
+	if (iterations <= 0)
+		iterations = 1;
+
+	for (i = 0; i < 1024; ++i) {
+		long_string[i] = "abcdefghijklmnopqrstuvwxyz0123456789"[i % 36];
+		long_binary[i] = (TDS_UCHAR) (i * 7);
+	}
+	long_hex[0] = '0';
+	long_hex[1] = 'x';
+	for (i = 0; i < 2048; ++i)
+		long_hex[2 + i] = "0123456789abcdef"[(i * 5) % 16];
+
+	ctx = tds_alloc_context(NULL);
+	assert(ctx);
+	if (!ctx->locale->datetime_fmt) {
+		/* set default in case there's no locale file */
+		ctx->locale->datetime_fmt = strdup(STD_DATETIME_FMT);
+	}
+
+	printf("srctype,srcname,desttype,destname,values,conversions,ns_per_conversion\n");
+	for (srctype = 0; srctype < 256; ++srctype)
+		for (desttype = 0; desttype < 256; ++desttype)
+			if (tds_willconvert(srctype, desttype))
+				bench(srctype, desttype);
+
+	tds_free_context(ctx);
+	return 0;
+}
@@ -389,6 +389,27 @@ test_end(void)
 	tds_freeze_close(&outer);
 }
 
+/* bulk data are queued and sent without waiting,
+ * check data are sent correctly using a non blocking socket */
+static void
+test_bulk(void)
+{
+	TDSFREEZE outer;
+	int i;
+
+	assert(tds_socket_set_nonblocking(tds_get_s(tds)) == 0);
+	tds->out_flag = TDS_BULK;
+	for (i = 0; i < 2000; ++i) {
+		append(NULL, 111);
+		if (i % 100 == 0) {
+			tds_freeze(tds, &outer, 2);
+			append_num(BLOCK_SIZE * 2 + 45, 2);
+			append(NULL, BLOCK_SIZE * 2 + 45);
+			tds_freeze_close(&outer);
+		}
+	}
+}
+
 /* close the socket, force thread to stop also */
 static void
 shutdown_server_socket(void)
@@ -481,6 +502,7 @@ main(void)
 		test(mars, test_cross1);
 		test(mars, test_cross2);
 		test(mars, test_end);
+		test(mars, test_bulk);
 	}
 
 	return 0;
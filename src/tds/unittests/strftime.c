@@ -18,7 +18,7 @@
  */
 
 /*
- * Purpose: test tds_strftime.
+ * Purpose: test tds_strftime and compiled formats.
  * This is a wrapper to strftime for portability and extension.
  */
 #include "common.h"
@@ -31,6 +31,7 @@ test(const TDSDATEREC* dr, int prec, const char *fmt, const char *expected, int
 {
 	char out[256];
 	char *format = strdup(fmt);
+	TDSDATEFMT *compiled;
 	assert(format != NULL);
 
 	tds_strftime(out, sizeof(out), format, dr, prec);
@@ -40,7 +41,18 @@ test(const TDSDATEREC* dr, int prec, const char *fmt, const char *expected, int
 		exit(1);
 	}
 
+	/* compiled format should give same results */
+	compiled = tds_datefmt_compile(format);
+	assert(compiled != NULL);
 	free(format);
+	strcpy(out, "garbage");
+	tds_datefmt_format(compiled, out, sizeof(out), dr, prec);
+	tds_datefmt_free(compiled);
+
+	if (strcmp(out, expected) != 0) {
+		fprintf(stderr, "%d: Wrong compiled results got '%s' expected '%s'\n", line, out, expected);
+		exit(1);
+	}
 }
 
 int
@@ -76,5 +88,31 @@ main(void)
 	TEST(0, "%e", "23");
 	dr.day = 5;
 	TEST(0, "x%e", "x 5");
+
+	/* names, formatted by strftime or computed once by compiled formats */
+	dr.year = 2020;
+	dr.month = 1;
+	dr.weekday = 3;
+	dr.minute = 7;
+	TEST(3, "%b %e %Y %I:%M%p", "Feb  5 2020 04:07PM");
+	TEST(3, "%a %A %B %h %p", "Wed Wednesday February Feb PM");
+	TEST(2, "%Y-%m-%d %H:%M:%S.%z", "2020-02-05 16:07:00.12");
+	TEST(0, "%Y-%m-%d %H:%M:%S.%z", "2020-02-05 16:07:00");
+	TEST(7, "%y%m%d %z %%z", "200205 1234567 %z");
+
+	/* output must fit with terminator */
+	{
+		char out[10];
+		TDSDATEFMT *compiled = tds_datefmt_compile("%Y-%m-%d");
+
+		assert(compiled);
+		if (tds_strftime(out, 10, "%Y-%m-%d", &dr, 3) != 0
+		    || tds_datefmt_format(compiled, out, 10, &dr, 3) != 0
+		    || tds_datefmt_format(compiled, out, 11, &dr, 3) != 10) {
+			fprintf(stderr, "Wrong results for small buffer\n");
+			exit(1);
+		}
+		tds_datefmt_free(compiled);
+	}
 	return 0;
 }
@@ -199,6 +199,7 @@ main(void)
 	ctx.locale->date_fmt = strdup("%Y-%m-%d");
 	free(ctx.locale->time_fmt);
 	ctx.locale->time_fmt = strdup("%H:%M:%S.%z");
+	tds_locale_compile_formats(ctx.locale);
 
 	/* test some conversion */
 	printf("some checks...\n");
@@ -321,6 +322,9 @@ main(void)
 	test("12345678-1234-a234-9876543298765432", SYBUNIQUE, "12345678-1234-A234-9876543298765432");
 	test("123a5678-1234-a234-98765-43298765432", SYBUNIQUE, "error");
 	test("123-5678-1234-a234-9876543298765432", SYBUNIQUE, "error");
+	test("{12345678-1234-1E34-9876-ab3298765432}", SYBUNIQUE, "12345678-1234-1E34-9876AB3298765432");
+	test("12345678-1234-1234-9876-54329876543", SYBUNIQUE, "error");
+	test2("12345678-1234-1e34-9876ab3298765432", SYBUNIQUE, SYBCHAR, "len=36 12345678-1234-1E34-9876-AB3298765432");
 
 	printf("binary test...\n");
 	test("0x1234", SYBBINARY, "len=2 12 34");
@@ -362,6 +366,35 @@ main(void)
 	test2("2006-01-02 12:34:56.337", SYBMSDATETIME2, SYBTIME, "13588901");
 
 	test2("2006-01-02 12:34:56.337", SYBMSDATETIME2, SYBCHAR, "len=27 2006-01-02 12:34:56.3370000");
+
+	/* ISO forms, parsed without the general parser */
+	test2("2006-01-02T12:34:56.337", SYBDATETIME, SYBTIME, "13588901");
+	test2("  2006-01-02 12:34:56.337  ", SYBDATETIME, SYBTIME, "13588901");
+	test2("2006-01-02 12:34", SYBMSDATETIME2, SYBCHAR, "len=27 2006-01-02 12:34:00.0000000");
+	test2("2006-01-02T12:34:56.1234567", SYBMSDATETIME2, SYBCHAR, "len=27 2006-01-02 12:34:56.1234567");
+	test2("2006-01-02 12:34:56.1", SYBMSDATETIME2, SYBCHAR, "len=27 2006-01-02 12:34:56.1000000");
+	test2("2006-01-02 12:34:56", SYBDATETIME, SYBCHAR, "len=23 2006-01-02 12:34:56.000");
+	/* not in ISO forms, left to the general parser */
+	test2("2006-01-02  12:34:56.337", SYBDATETIME, SYBTIME, "13588901");
+	test2("2006-01-02 1:02:03", SYBDATETIME, SYBCHAR, "len=23 2006-01-02 01:02:03.000");
+
+	/* compiled locale formats */
+	test2("2006-01-02 12:34:56.337", SYBMSDATE, SYBCHAR, "len=10 2006-01-02");
+	test2("2006-01-02 12:34:56.337", SYBMSTIME, SYBCHAR, "len=16 12:34:56.3370000");
+	/* format changed, old compiled format should not be used */
+	free(ctx.locale->datetime_fmt);
+	ctx.locale->datetime_fmt = strdup("%d/%m/%Y %H:%M");
+	test2("2006-01-02 12:34:56", SYBDATETIME, SYBCHAR, "len=16 02/01/2006 12:34");
+	tds_locale_compile_formats(ctx.locale);
+	test2("2006-01-02 12:34:56", SYBDATETIME, SYBCHAR, "len=16 02/01/2006 12:34");
+	/* locale dependent, not compiled */
+	free(ctx.locale->datetime_fmt);
+	ctx.locale->datetime_fmt = strdup("%Y %b %d");
+	tds_locale_compile_formats(ctx.locale);
+	test2("2006-01-02 12:34:56", SYBDATETIME, SYBCHAR, "len=11 2006 Jan 02");
+	free(ctx.locale->datetime_fmt);
+	ctx.locale->datetime_fmt = strdup("%Y-%m-%d %H:%M:%S.%z");
+	tds_locale_compile_formats(ctx.locale);
 #if 0
 	/* FIXME should fail conversion ?? */
 	test2("2006-01-02", SYBDATE, SYBTIME, "0");
@@ -373,6 +406,14 @@ main(void)
 
 	test2("123", SYBINT1, SYBBINARY, "len=1 7B");
 	test2("0.000001", SYBFLT8, SYBNUMERIC, "0.00000100");
+	test2("123.25", SYBFLT8, SYBCHAR, "len=6 123.25");
+	test2(" -1234567890123 ", SYBFLT8, SYBCHAR, "len=14 -1234567890123");
+	test2("0.1", SYBFLT8, SYBCHAR, "len=19 0.10000000000000001");
+	test2("1e300", SYBFLT8, SYBCHAR, "len=23 1.0000000000000001e+300");
+	test2("-0", SYBFLT8, SYBCHAR, "len=2 -0");
+	test2("16777217", SYBREAL, SYBCHAR, "len=8 16777216");
+	test2("0.5", SYBREAL, SYBCHAR, "len=3 0.5");
+	test("1.2.3", SYBFLT8, "error");
 	if (big_endian) {
 		test2("12345", SYBINT2, SYBBINARY, "len=2 30 39");
 		test2("123456789", SYBINT4, SYBBINARY, "len=4 07 5B CD 15");
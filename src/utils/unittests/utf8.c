@@ -0,0 +1,178 @@
+/* FreeTDS - Library of routines accessing Sybase and Microsoft databases
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/*
+ * Purpose: test UTF-8 functions.
+ * Results are compared with a simple byte by byte DFA decoding.
+ */
+#undef NDEBUG
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <errno.h>
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <freetds/utils/utf8.h>
+#include <freetds/bytes.h>
+
+/* reference implementation of tds_utf8_count */
+static size_t
+ref_count(const unsigned char *s, size_t len, size_t *p_chars, size_t *p_utf16)
+{
+	const unsigned char *p = s, *const end = s + len;
+	size_t chars = 0, utf16 = 0;
+
+	while (p < end) {
+		uint32_t u, state = UTF8_ACCEPT;
+		const unsigned char *start = p;
+
+		while (decode_utf8(&state, &u, *p++) > UTF8_REJECT && p < end)
+			continue;
+		if (state != UTF8_ACCEPT) {
+			p = start;
+			break;
+		}
+		++chars;
+		utf16 += u >= 0x10000 ? 2 : 1;
+	}
+	*p_chars = chars;
+	*p_utf16 = utf16;
+	return p - s;
+}
+
+static void
+check(const unsigned char *s, size_t len)
+{
+	size_t chars, utf16, ref_chars, ref_utf16, valid, ref_valid, ascii;
+	size_t il, ol, n;
+	const unsigned char *ib;
+	unsigned char *ob, out[1024 * 2 + 8];
+	int err;
+
+	assert(len <= 1024);
+
+	ascii = tds_utf8_ascii_len(s, len);
+	for (n = 0; n < ascii; ++n)
+		assert(s[n] < 0x80);
+	assert(ascii == len || s[ascii] >= 0x80);
+
+	valid = tds_utf8_count(s, len, &chars, &utf16);
+	ref_valid = ref_count(s, len, &ref_chars, &ref_utf16);
+	assert(valid == ref_valid);
+	assert(chars == ref_chars);
+	assert(utf16 == ref_utf16);
+	assert(tds_utf8_count(s, len, NULL, NULL) == valid);
+
+	/* convert all, output is big enough */
+	ib = s;
+	il = len;
+	ob = out;
+	ol = sizeof(out);
+	err = tds_utf8_to_utf16le(&ib, &il, &ob, &ol);
+	assert(ib == s + valid);
+	assert(ob == out + utf16 * 2);
+	if (valid == len) {
+		assert(err == 0);
+	} else {
+		uint32_t u, state = UTF8_ACCEPT;
+
+		for (n = valid; n < len && state != UTF8_REJECT; ++n)
+			decode_utf8(&state, &u, s[n]);
+		assert(err == (state == UTF8_REJECT ? EILSEQ : EINVAL));
+	}
+
+	/* check content */
+	ib = s;
+	ob = out;
+	while (ib < s + valid) {
+		uint32_t u, state = UTF8_ACCEPT;
+
+		while (decode_utf8(&state, &u, *ib++) > UTF8_REJECT)
+			continue;
+		assert(state == UTF8_ACCEPT);
+		if (u >= 0x10000) {
+			assert(TDS_GET_UA2LE(ob) == 0xd7c0 + (u >> 10));
+			assert(TDS_GET_UA2LE(ob + 2) == 0xdc00 + (u & 0x3ff));
+			ob += 4;
+		} else {
+			assert(TDS_GET_UA2LE(ob) == u);
+			ob += 2;
+		}
+	}
+
+	/* not enough output space, only complete characters are converted */
+	for (n = 0; n < utf16 * 2; ++n) {
+		ib = s;
+		il = len;
+		ob = out;
+		ol = n;
+		err = tds_utf8_to_utf16le(&ib, &il, &ob, &ol);
+		assert(err == E2BIG);
+		assert(ob - out + ol == n);
+		assert(ol < 4);
+		assert(ib + il == s + len);
+	}
+}
+
+static void
+check_str(const char *s)
+{
+	check((const unsigned char *) s, strlen(s));
+}
+
+int
+main(void)
+{
+	static const unsigned char chars[] = {
+		'a', 'Z', 0, 0x7f, 0x80, 0xbf, 0xc0, 0xc2, 0xdf, 0xe0, 0xed, 0xef,
+		0xf0, 0xf4, 0xf5, 0xff, 0xa0, 0x9f, 0x90, 0x8f
+	};
+	unsigned char buf[64];
+	int i, n;
+
+	check_str("");
+	check_str("a");
+	check_str("Hello world, this is a long ASCII string");
+	check_str("caf\xc3\xa9 cr\xc3\xa8me br\xc3\xbbl\xc3\xa9" "e");
+	check_str("\xe2\x82\xac 100 \xe2\x82\xac");
+	check_str("abcdefgh\xf0\x9f\x98\x80" "abcdefghijklmnop\xf4\x8f\xbf\xbf");
+	/* invalid sequences */
+	check_str("abcdefghijk\xc0\x80");
+	check_str("abcdefghijk\xed\xa0\x80");
+	check_str("abcdefghijk\xf4\x90\x80\x80");
+	check_str("abcdefghijk\xe2\x82");
+	check_str("abcdefghijk\xe2\x82z");
+	check_str("\x80");
+
+	/* random strings using interesting bytes */
+	srand(12345);
+	for (i = 0; i < 100000; ++i) {
+		int len = rand() % sizeof(buf);
+
+		for (n = 0; n < len; ++n)
+			buf[n] = chars[rand() % sizeof(chars)];
+		check(buf, len);
+	}
+
+	return 0;
+}
@@ -0,0 +1,179 @@
+/* FreeTDS - Library of routines accessing Sybase and Microsoft databases
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <config.h>
+
+#if HAVE_STRING_H
+#include <string.h>
+#endif /* HAVE_STRING_H */
+
+#include <errno.h>
+
+#include <freetds/utils/utf8.h>
+#include <freetds/bytes.h>
+
+/*
+ * ASCII is checked a machine word at a time, only sequences
+ * with high bit set are passed to the DFA decoder.
+ */
+
+/** 0x80 in every byte of a word */
+#define HIGH_BITS (((size_t) -1) / 0xffu * 0x80u)
+
+size_t
+tds_utf8_ascii_len(const unsigned char *s, size_t len)
+{
+	const unsigned char *p = s;
+	size_t w;
+
+	for (; len >= sizeof(w); len -= sizeof(w), p += sizeof(w)) {
+		memcpy(&w, p, sizeof(w));
+		if (w & HIGH_BITS)
+			break;
+	}
+	for (; len && *p < 0x80; --len)
+		++p;
+	return p - s;
+}
+
+/**
+ * Decode a single non ASCII character.
+ * @return bytes used, 0 if sequence is invalid or truncated
+ */
+static inline size_t
+utf8_decode_one(const unsigned char *p, size_t len, uint32_t *out)
+{
+	uint32_t state = UTF8_ACCEPT;
+	size_t l = 0;
+
+	while (decode_utf8(&state, out, p[l++]) > UTF8_REJECT && l < len)
+		continue;
+	return state == UTF8_ACCEPT ? l : 0;
+}
+
+size_t
+tds_utf8_count(const unsigned char *s, size_t len, size_t *p_chars, size_t *p_utf16)
+{
+	const unsigned char *p = s;
+	size_t chars = 0, surrogates = 0;
+
+	while (len) {
+		uint32_t u;
+		size_t l = tds_utf8_ascii_len(p, len);
+
+		chars += l;
+		p += l;
+		len -= l;
+		if (!len)
+			break;
+
+		l = utf8_decode_one(p, len, &u);
+		if (!l)
+			break;
+		++chars;
+		if (u >= 0x10000)
+			++surrogates;
+		p += l;
+		len -= l;
+	}
+
+	if (p_chars)
+		*p_chars = chars;
+	if (p_utf16)
+		*p_utf16 = chars + surrogates;
+	return p - s;
+}
+
+int
+tds_utf8_to_utf16le(const unsigned char **p_in, size_t *p_in_len, unsigned char **p_out, size_t *p_out_len)
+{
+	const unsigned char *ib = *p_in;
+	unsigned char *ob = *p_out;
+	size_t il = *p_in_len, ol = *p_out_len;
+	int err = 0;
+
+	while (il) {
+		uint32_t u, state;
+		size_t l = tds_utf8_ascii_len(ib, il < ol / 2 ? il : ol / 2), n;
+
+		/* read before writing, buffers could alias */
+		for (n = 0; n + 4 <= l; n += 4) {
+			const unsigned char c0 = ib[n], c1 = ib[n + 1], c2 = ib[n + 2], c3 = ib[n + 3];
+
+			ob[n * 2] = c0;
+			ob[n * 2 + 1] = 0;
+			ob[n * 2 + 2] = c1;
+			ob[n * 2 + 3] = 0;
+			ob[n * 2 + 4] = c2;
+			ob[n * 2 + 5] = 0;
+			ob[n * 2 + 6] = c3;
+			ob[n * 2 + 7] = 0;
+		}
+		for (; n < l; ++n) {
+			ob[n * 2] = ib[n];
+			ob[n * 2 + 1] = 0;
+		}
+		ib += l;
+		il -= l;
+		ob += l * 2;
+		ol -= l * 2;
+		if (!il)
+			break;
+
+		/* ASCII character without space in output */
+		if (*ib < 0x80) {
+			err = E2BIG;
+			break;
+		}
+
+		state = UTF8_ACCEPT;
+		l = 0;
+		while (decode_utf8(&state, &u, ib[l++]) > UTF8_REJECT && l < il)
+			continue;
+		if (state != UTF8_ACCEPT) {
+			err = state == UTF8_REJECT ? EILSEQ : EINVAL;
+			break;
+		}
+		if (u >= 0x10000) {
+			if (ol < 4) {
+				err = E2BIG;
+				break;
+			}
+			TDS_PUT_UA2LE(ob, 0xd7c0 + (u >> 10));
+			TDS_PUT_UA2LE(ob + 2, 0xdc00 + (u & 0x3ffu));
+			ob += 4;
+			ol -= 4;
+		} else {
+			if (ol < 2) {
+				err = E2BIG;
+				break;
+			}
+			TDS_PUT_UA2LE(ob, u);
+			ob += 2;
+			ol -= 2;
+		}
+		ib += l;
+		il -= l;
+	}
+
+	*p_in = ib;
+	*p_in_len = il;
+	*p_out = ob;
+	*p_out_len = ol;
+	return err;
+}